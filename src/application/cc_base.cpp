@@ -10,6 +10,8 @@
 #include "version.h"
 #include "log.h"
 #include "timer.h"
+#include "trace.h"
+#include "data/file.h"
 #include "programmer/cc_programmer.h"
 #include "cc_base.h"
 
@@ -80,9 +82,35 @@ void CC_Base::init_options(po::options_description &desc)
 	desc.add_options()
 		("fast,f", "set fast debug interface speed (by default: slow)");
 
+	desc.add_options()
+		("clock-boost", "run target on 32 MHz crystal oscillator while connected "
+				"(CC253x/CC254x)");
+
+	desc.add_options()
+		("tune", "find the fastest interface settings for programmer and target "
+				"and save them to tuning file");
+
+	desc.add_options()
+		("no-tune", "ignore settings saved by --tune");
+
+	desc.add_options()
+		("tuning-file", po::value<String>(&option_tuning_file_),
+				"file of settings saved by --tune (~/.cache/cc-tool/tuning by default)");
+
 	desc.add_options()
 		("name,n", po::value<String>(&option_unit_name_),
 				"specify target name e.g. CC2530 etc.");
+
+	desc.add_options()
+		("stats", "print time and usb transfer statistics per operation");
+
+	desc.add_options()
+		("metrics", po::value<String>(&option_metrics_file_),
+				"add counters of this run to OpenMetrics text file");
+
+	desc.add_options()
+		("trace", po::value<String>(&option_trace_file_),
+				"write timeline of operations in Chrome trace event format");
 }
 
 //==============================================================================
@@ -118,6 +146,16 @@ bool CC_Base::read_options(const po::options_description &desc, const po::variab
 	}
 
 	option_fast_interface_speed_ = vm.count("fast") > 0;
+	option_stats_ = vm.count("stats") > 0;
+	option_clock_boost_ = vm.count("clock-boost") > 0;
+	programmer_.set_clock_boost(option_clock_boost_);
+	option_tune_ = vm.count("tune") > 0;
+	option_no_tune_ = vm.count("no-tune") > 0;
+
+	if (option_tune_ && option_no_tune_)
+		throw po::error("incompatible options tune and no-tune");
+	if (option_tuning_file_.empty())
+		option_tuning_file_ = CC_Tuner::default_file_name();
 	return true;
 }
 
@@ -149,19 +187,80 @@ bool CC_Base::init_unit()
 		return false;
 	}
 
+	stats_.start("connect");
 	if (!programmer_.unit_connect(unit_info_))
 	{
+		stats_.finish();
 		std::cout << "  Unable to communicate with target" << "\n";
 		return false;
 	}
+	stats_.finish();
+
+	if (option_clock_boost_ && !programmer_.unit_clock_boosted())
+		std::cout << "  Clock boost is unavailable, target runs on default clock" << "\n";
 	return true;
 }
 
+//==============================================================================
+void CC_Base::init_tuning()
+{
+	if (option_no_tune_)
+		return;
+
+	CC_Tuner tuner(programmer_, unit_info_);
+	if (option_tune_)
+	{
+		if (programmer_.unit_locked())
+		{
+			std::cout << "  Target is locked, tuning skipped" << "\n";
+			return;
+		}
+
+		std::cout << "  Tuning interface..." << "\n";
+		stats_.start("tune");
+		bool result = tuner.calibrate(tuning_);
+		stats_.finish();
+
+		// clear out progress message
+		std::cout << String(18, ' ') << "\r" << std::flush;
+		if (!result)
+		{
+			std::cout << "  Flash doesn't read back consistently, defaults are kept" << "\n";
+			return;
+		}
+		std::cout << "  Tuning: " << tuning_ << "\n";
+
+		try
+		{
+			CC_Tuner::save(option_tuning_file_, tuner.key(), tuning_);
+		}
+		catch (std::runtime_error &e)
+		{
+			std::cout << "  Unable to save tuning: " << e.what() << "\n";
+		}
+	}
+	else
+	if (!CC_Tuner::load(option_tuning_file_, tuner.key(), tuning_))
+		return;
+
+	// explicit --fast isn't overridden by slow speed found
+	if (option_fast_interface_speed_)
+		tuning_.fast_speed = true;
+
+	tuner.apply(tuning_);
+	tuned_ = true;
+
+	std::stringstream ss;
+	ss << tuning_;
+	log_info("main, tuning applied: %s", ss.str().c_str());
+}
+
 //==============================================================================
 bool CC_Base::init_programmer()
 {
 	CC_Programmer::OpenResult open_result = CC_Programmer::OR_OK;
 
+	stats_.start("open");
 	if (!option_device_address_.empty())
 	{
 		uint_t bus = 0, device = 0;
@@ -178,6 +277,7 @@ bool CC_Base::init_programmer()
 
 	if (open_result != CC_Programmer::OR_OK)
 	{
+		stats_.finish();
 		std::cout << "  CC Debugger device not found" << "\n";
 		return false;
 	}
@@ -189,15 +289,53 @@ bool CC_Base::init_programmer()
 	programmer_.programmer_info(info);
 	std::cout << "  Programmer: " << info.name << "\n";
 
+	stats_.finish();
 	return true;
 }
 
+//==============================================================================
+void CC_Base::save_metrics(bool result)
+{
+	metrics_.count("cctool_runs", result ? "result=\"success\"" : "result=\"failure\"");
+
+	const USB_TransferStats &transfers = programmer_.transfer_stats();
+	metrics_.count("cctool_usb_transfers", "type=\"bulk_read\"", transfers.bulk_reads);
+	metrics_.count("cctool_usb_transfers", "type=\"bulk_write\"", transfers.bulk_writes);
+	metrics_.count("cctool_usb_transfers", "type=\"control_read\"", transfers.control_reads);
+	metrics_.count("cctool_usb_transfers", "type=\"control_write\"", transfers.control_writes);
+	metrics_.count("cctool_usb_bytes", "direction=\"in\"", transfers.bytes_in);
+	metrics_.count("cctool_usb_bytes", "direction=\"out\"", transfers.bytes_out);
+
+	typedef std::map<int, uint_t>::value_type ErrorItem;
+	foreach (const ErrorItem &item, transfers.errors)
+		metrics_.count("cctool_usb_errors",
+				"code=\"" + usb_error_name(item.first) + "\"", item.second);
+
+	foreach (const CC_Stats::Phase &phase, stats_.phases())
+		metrics_.observe("cctool_operation_seconds",
+				"operation=\"" + phase.name + "\"", (double)phase.time / 1000000);
+
+	try
+	{
+		// stations on the host may export to the same file
+		FileLock lock(option_metrics_file_);
+		metrics_.load(option_metrics_file_);
+		metrics_.save(option_metrics_file_);
+	}
+	catch (std::runtime_error &e)
+	{
+		std::cout << "  Unable to save metrics: " << e.what() << "\n";
+	}
+}
+
 //==============================================================================
 bool CC_Base::execute(int argc, char *argv[])
 {
 	po::options_description desc;
 	init_options(desc);
 
+	bool result = false;
+
 	try
 	{
 		po::variables_map vm;
@@ -207,16 +345,30 @@ bool CC_Base::execute(int argc, char *argv[])
 		if (vm.count("log"))
 			init_log(argc, argv, option_log_name_);
 
+		if (!option_trace_file_.empty())
+			trace_get().set_trace_file(option_trace_file_);
+
 		if (!read_options(desc, vm))
 			return false;
 
 		if (init_programmer() && init_unit())
 		{
+			init_tuning();
+
 			log_info("main, start task processing");
-			process_tasks();
+			{
+				TraceScope trace("process_tasks", "application");
+				process_tasks();
+			}
 			log_info("main, finish task processing");
+
+			stats_.start("reset");
 			programmer_.unit_close();
-			return true;
+			stats_.finish();
+
+			if (option_stats_)
+				std::cout << stats_;
+			result = true;
 		}
 	}
 	catch (std::runtime_error& e) // usb, file error
@@ -235,8 +387,12 @@ bool CC_Base::execute(int argc, char *argv[])
 		if (strlen(e.what()))
 			std::cout << " (" << e.what() << ")";
 		std::cout << "\n  Try --help for more information\n";
+		return false;
 	}
-	return false;
+
+	if (!option_metrics_file_.empty())
+		save_metrics(result);
+	return result;
 }
 
 //==============================================================================
@@ -245,5 +401,11 @@ void CC_Base::process_tasks()
 
 //==============================================================================
 CC_Base::CC_Base() :
-		option_fast_interface_speed_(false)
+		stats_(programmer_),
+		tuned_(false),
+		option_tune_(false),
+		option_fast_interface_speed_(false),
+		option_stats_(false),
+		option_clock_boost_(false),
+		option_no_tune_(false)
 { }
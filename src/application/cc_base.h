@@ -14,6 +14,9 @@
 #include "data/read_target.h"
 #include "data/data_section_store.h"
 #include "programmer/cc_programmer.h"
+#include "programmer/cc_tuner.h"
+#include "application/cc_stats.h"
+#include "application/cc_metrics.h"
 
 namespace po = boost::program_options;
 
@@ -33,16 +36,31 @@ protected:
 
 	UnitInfo unit_info_;
 	CC_Programmer programmer_;
+	CC_Stats stats_;
+	CC_Metrics metrics_;
+
+	/// Settings applied by --tune or loaded from tuning file
+	CC_Tuning tuning_;
+	bool tuned_;
+	bool option_tune_;
 
 private:
 	void on_help(const po::options_description &);
 	bool init_programmer();
 	bool init_unit();
+	void init_tuning();
+	void save_metrics(bool result);
 
 	bool option_fast_interface_speed_;
+	bool option_stats_;
+	bool option_clock_boost_;
+	bool option_no_tune_;
 	String option_unit_name_;
 	String option_device_address_;
 	String option_log_name_;
+	String option_metrics_file_;
+	String option_trace_file_;
+	String option_tuning_file_;
 };
 
 #endif // !_CC_BASE_H_
@@ -14,6 +14,8 @@
 #include "log.h"
 #include "timer.h"
 #include "programmer/cc_programmer.h"
+#include "programmer/cc_profiler.h"
+#include "programmer/cc_latency.h"
 #include "cc_flasher.h"
 
 enum Task {
@@ -28,6 +30,11 @@ enum Task {
 	T_PRESERVE_MAC 	= 0x0100,
 	T_READ_INFO_PAGE= 0x0200,
 	T_TEST 			= 0x0400,
+	T_COMPILE_PLAN 	= 0x0800,
+	T_APPLY_DELTA 	= 0x1000,
+	T_VERIFY_RANGE 	= 0x2000,
+	T_PROFILE 		= 0x4000,
+	T_LATENCY 		= 0x8000,
 };
 
 //==============================================================================
@@ -74,32 +81,46 @@ static void print_hex_dump(const ByteVector &data)
 }
 
 //==============================================================================
-static void load_flash_data(const OptionFileInfo &file_info, DataSectionStore &section_store)
+/// Hex dump of flash blocks, a line per 32 bytes with address. Dump is
+/// printed after reading so it isn't mixed with progress
+class HexDumpSink : public DataSink
 {
-	if (file_info.type == "hex")
+public:
+	virtual void write(size_t offset, const uint8_t data[], size_t size)
 	{
-		DataSectionStore sections;
-		hex_file_load(file_info.name, sections);
-		section_store.add_sections(sections, true);
+		const size_t LINE_SIZE = 32;
 
-		size_t n = 0;
-		log_info("main, loaded hex file %s", file_info.name.c_str());
-		foreach (const DataSection &item, section_store.sections())
-			log_info(" section %02u, address: %06Xh, size: %06Xh",
-					n++, item.address, item.size());
+		for (size_t i = 0; i < size; i += LINE_SIZE)
+		{
+			dump_ << "  " << std::hex << std::uppercase << std::setfill('0')
+					<< std::setw(6) << offset + i << "h: " << std::dec
+					<< binary_to_hex(&data[i], std::min(LINE_SIZE, size - i), " ")
+					<< "\n";
+		}
 	}
 
-	if (file_info.type == "bin")
-	{
-		ByteVector data;
-		binary_file_load(file_info.name, data);
+	String dump() const
+	{	return dump_.str(); }
 
-		DataSection section(file_info.offset, data);
-		section_store.add_section(section, true);
+private:
+	std::stringstream dump_;
+};
 
-		log_info("main, loaded bin file %s, size: %u", file_info.name.c_str(),
-				data.size());
-	}
+//==============================================================================
+static size_t flash_size_limit(const UnitInfo &unit_info)
+{
+	size_t flash_size = unit_info.flash_size ?
+			unit_info.flash_size : unit_info.max_flash_size;
+	return flash_size * 1024;
+}
+
+//==============================================================================
+static bool slot_matches(bool present, const AddressRange &range,
+		uint32_t offset, uint32_t size)
+{
+	if (!present)
+		return !size;
+	return range.begin == offset && range.end - range.begin == size;
 }
 
 //==============================================================================
@@ -202,6 +223,10 @@ void CC_Flasher::init_options(po::options_description &desc)
 		("verify,v", po::value<String>()->implicit_value(""),
 				"verify flash after write, method '(r)ead' or '(c)cr' (used by default)");
 
+	desc.add_options()
+		("verify-range", po::value<StringVector>(),
+				"verify flash against file without writing, file_name[@address+size]");
+
 	desc.add_options()
 		("reset", "perform target reset");
 
@@ -215,6 +240,62 @@ void CC_Flasher::init_options(po::options_description &desc)
 	desc.add_options()
 		("flash-size,s", po::value<String>(&option_flash_size_),
 				"specify target flash size in KB");
+
+	desc.add_options()
+		("compile-plan", po::value<String>(&option_compile_plan_),
+				"save image of written files as flash plan for the target");
+
+	desc.add_options()
+		("apply-delta", po::value<String>(),
+				"update flash by delta made with 'cc-tool image delta'");
+
+	desc.add_options()
+		("image-cache", po::value<String>(&option_image_cache_)->implicit_value(""),
+				"cache parsed hex files in directory (~/.cache/cc-tool by default)");
+
+	desc.add_options()
+		("hex-record-size", po::value<String>(&option_hex_record_size_),
+				"data bytes per record of hex files written, 1..255 (32 by default)");
+
+	desc.add_options()
+		("profile", po::value<String>(),
+				"sample PC of the running firmware, functions are taken from "
+				"SDCC .map/.cdb or IAR .map file");
+
+	desc.add_options()
+		("profile-rate", po::value<String>(&option_profile_rate_),
+				"samples per second, 1..1000 (100 by default)");
+
+	desc.add_options()
+		("profile-duration", po::value<String>(&option_profile_duration_),
+				"profiling time in seconds (10 by default)");
+
+	desc.add_options()
+		("profile-folded", po::value<String>(&option_profile_folded_),
+				"save collapsed stacks for flamegraph.pl");
+
+	desc.add_options()
+		("latency", po::value<String>(),
+				"measure cycles of the running firmware from entry to exit "
+				"breakpoint, 'entry[:exit]' are flash addresses or function names");
+
+	desc.add_options()
+		("latency-symbols", po::value<String>(&option_latency_symbols_),
+				"SDCC .map/.cdb or IAR .map file to look function names up in, "
+				"exit of a function is known from .cdb only");
+
+	desc.add_options()
+		("latency-count", po::value<String>(&option_latency_count_),
+				"runs to measure (100 by default)");
+
+	desc.add_options()
+		("latency-divider", po::value<String>(&option_latency_divider_),
+				"Timer 1 divider 1, 8, 32 or 128 for runs over 65535 cycles "
+				"(1 by default)");
+
+	desc.add_options()
+		("latency-timeout", po::value<String>(&option_latency_timeout_),
+				"max seconds to wait for a breakpoint hit (10 by default)");
 }
 
 //==============================================================================
@@ -262,6 +343,7 @@ bool CC_Flasher::read_options(const po::options_description &desc, const po::var
 		else
 		if (!value.empty())
 			throw po::error("invalid verify method - " + value);
+		verify_method_given_ = !value.empty();
 	}
 
 	if (vm.count("reset"))
@@ -277,28 +359,155 @@ bool CC_Flasher::read_options(const po::options_description &desc, const po::var
 		flash_read_target_.set_source(vm["read"].as<String>());
 	}
 
+	if (vm.count("read-info-page") && !info_page_read_target_.range().empty())
+		throw po::error("address range is not supported for info page");
+
+	// data goes to stdout, so do messages to stderr
+	if (flash_read_target_.standard_output() ||
+			info_page_read_target_.standard_output())
+		std::cout.rdbuf(std::cerr.rdbuf());
+
+	if (vm.count("compile-plan"))
+	{
+		task_set_ |= T_COMPILE_PLAN;
+		if (!vm.count("write"))
+			throw po::error("'compile-plan' option is used without write");
+	}
+
+	if (vm.count("verify-range"))
+	{
+		if (vm.count("write") || vm.count("apply-delta"))
+			throw po::error("'verify-range' option is incompatible with write and apply-delta");
+
+		task_set_ |= T_VERIFY_RANGE;
+		foreach (const String &item, vm["verify-range"].as<StringVector>())
+		{
+			OptionFileInfo file_info;
+			option_extract_file_info(item, file_info, true);
+			if (file_info.type == "plan")
+				throw po::error("flash plan can't be verified by range");
+			image_loader_.add_file(file_info);
+		}
+		image_loader_.start();
+	}
+
 	if (vm.count("write"))
 	{
-		if (!(task_set_ & T_ERASE))
+		// plan is compiled without writing unless erase is specified
+		if (!(task_set_ & (T_ERASE | T_COMPILE_PLAN)))
 		{
 			std::cout << "  Writing flash is not supported without erase" << "\n";
 			return false;
 		}
 
-		task_set_ |= T_WRITE_FLASH;
+		if (task_set_ & T_ERASE)
+			task_set_ |= T_WRITE_FLASH;
+
+		if (vm.count("image-cache"))
+		{
+			ImageCache cache;
+			cache.set_directory(option_image_cache_.empty() ?
+					ImageCache::default_directory() : option_image_cache_);
+			cache.set_crc_blocks(programmer_.verify_block_sizes(), FLASH_BANK_SIZE);
+			image_loader_.set_cache(cache);
+		}
+
 		StringVector list = vm["write"].as<StringVector>();
 		foreach (String &item, list)
 		{
 			OptionFileInfo file_info;
 			option_extract_file_info(item, file_info, true);
-			load_flash_data(file_info, flash_write_data_);
+
+			if (file_info.type != "plan")
+				image_loader_.add_file(file_info);
+			else
+			{
+				if (list.size() > 1 || (task_set_ & T_COMPILE_PLAN) ||
+						!file_info.range.empty())
+					throw po::error("flash plan can't be merged with other files or cut by range");
+				flash_plan_.open(file_info.name);
+			}
 		}
+
+		// files are parsed while programmer is being opened
+		image_loader_.start();
+	}
+
+	if (vm.count("apply-delta"))
+	{
+		if (vm.count("write") || vm.count("erase"))
+			throw po::error("'apply-delta' option is incompatible with write and erase");
+
+		task_set_ |= T_APPLY_DELTA;
+		flash_delta_.open(vm["apply-delta"].as<String>());
 	}
 
 	if (vm.count("lock"))
 		task_set_ |= T_LOCK;
 
-	if ((task_set_ & T_VERIFY) && !(task_set_ & T_WRITE_FLASH))
+	if (vm.count("profile"))
+	{
+		if (task_set_ & T_LOCK)
+			throw po::error("'profile' option is incompatible with lock");
+
+		task_set_ |= T_PROFILE;
+		profile_symbols_.load(vm["profile"].as<String>());
+
+		if (!option_profile_rate_.empty() &&
+				(!string_to_number(option_profile_rate_, profile_rate_) ||
+				!profile_rate_ || profile_rate_ > 1000))
+			throw po::error("invalid profile rate " + option_profile_rate_);
+
+		if (!option_profile_duration_.empty() &&
+				(!string_to_number(option_profile_duration_, profile_duration_) ||
+				!profile_duration_))
+			throw po::error("invalid profile duration " + option_profile_duration_);
+	}
+	else
+	if (!option_profile_rate_.empty() || !option_profile_duration_.empty() ||
+			!option_profile_folded_.empty())
+		throw po::error("profile settings are used without 'profile'");
+
+	if (vm.count("latency"))
+	{
+		if (task_set_ & T_LOCK)
+			throw po::error("'latency' option is incompatible with lock");
+
+		task_set_ |= T_LATENCY;
+		SymbolMap symbols;
+		if (!option_latency_symbols_.empty())
+			symbols.load(option_latency_symbols_);
+		read_latency_range(vm["latency"].as<String>(), symbols);
+
+		if (!option_latency_count_.empty() &&
+				(!string_to_number(option_latency_count_, latency_count_) ||
+				!latency_count_))
+			throw po::error("invalid latency count " + option_latency_count_);
+
+		if (!option_latency_divider_.empty() &&
+				(!string_to_number(option_latency_divider_, latency_divider_) ||
+				(latency_divider_ != 1 && latency_divider_ != 8 &&
+				latency_divider_ != 32 && latency_divider_ != 128)))
+			throw po::error("invalid latency divider " + option_latency_divider_);
+
+		if (!option_latency_timeout_.empty() &&
+				(!string_to_number(option_latency_timeout_, latency_timeout_) ||
+				!latency_timeout_))
+			throw po::error("invalid latency timeout " + option_latency_timeout_);
+	}
+	else
+	if (!option_latency_symbols_.empty() || !option_latency_count_.empty() ||
+			!option_latency_divider_.empty() || !option_latency_timeout_.empty())
+		throw po::error("latency settings are used without 'latency'");
+
+	// delta is always verified, verify-range takes method of verify
+	if (task_set_ & T_APPLY_DELTA)
+		task_set_ &= ~T_VERIFY;
+	if (task_set_ & T_VERIFY_RANGE)
+		task_set_ |= T_VERIFY;
+
+	if ((task_set_ & T_VERIFY) && !(task_set_ & T_WRITE_FLASH) &&
+			!(task_set_ & T_VERIFY_RANGE))
 		throw po::error("'verify' option is used without write");
 
 	if (!option_flash_size_.empty())
@@ -308,6 +517,17 @@ bool CC_Flasher::read_options(const po::options_description &desc, const po::var
 				*error != '\0')
 			throw po::error("invalid flash size value " + option_flash_size_);
 	}
+
+	if (!option_hex_record_size_.empty())
+	{
+		size_t record_size = 0;
+		if (!string_to_number(option_hex_record_size_, record_size) ||
+				!record_size || record_size > 255)
+			throw po::error("invalid hex record size " + option_hex_record_size_);
+
+		flash_read_target_.set_hex_record_size(record_size);
+		info_page_read_target_.set_hex_record_size(record_size);
+	}
 	return true;
 }
 
@@ -455,7 +675,11 @@ void CC_Flasher::task_write_config()
 	}
 
 	std::cout << "  Writing " << status << "..." << "\n";
-	print_result(programmer_.unit_config_write(mac_addr_, lock_data_));
+
+	stats_.start("config write");
+	bool result = programmer_.unit_config_write(mac_addr_, lock_data_);
+	stats_.finish(mac_addr_.size() + lock_data_.size());
+	print_result(result);
 }
 
 //==============================================================================
@@ -463,10 +687,14 @@ void CC_Flasher::process_tasks()
 {
 	if (!task_set_)
 	{
-		std::cout << "  No actions specified" << "\n";
+		if (!option_tune_)
+			std::cout << "  No actions specified" << "\n";
 		return;
 	}
 
+	if (tuned_ && !verify_method_given_)
+		verify_method_ = tuning_.verify_method;
+
 	if (!validate_lock_options())
 		return;
 
@@ -517,37 +745,82 @@ void CC_Flasher::process_tasks()
 
 	if (task_set_ & T_RESET)
 	{
+		stats_.start("reset");
 		programmer_.unit_reset();
+		stats_.finish();
 		std::cout << "  Target reseted" << "\n";
 	}
 
 	if (task_set_ & T_READ_FLASH)
 		task_read_flash();
 
-	if (task_set_ & T_ERASE)
-		task_erase();
+	if (task_set_ & T_APPLY_DELTA)
+		task_apply_delta();
 
-	if (task_set_ & T_WRITE_FLASH)
+	// Image must be complete before erase as it's prepared during erasing
+	if (task_set_ & T_VERIFY_RANGE)
+	{
+		stats_.start("load");
+		load_flash_image();
+		stats_.finish(flash_write_data_.actual_size());
+
+		if (flash_write_data_.upper_address() > flash_size_limit(unit_info_))
+		{
+			std::cout << "  Verified data exceeding flash physical size, verification canceled..." << "\n";
+			task_set_ &= ~T_VERIFY;
+		}
+	}
+
+	if (task_set_ & (T_WRITE_FLASH | T_COMPILE_PLAN))
 	{
+		stats_.start("load");
+		load_flash_image();
+		stats_.finish(flash_write_data_.actual_size());
+
+		// CRCs known in advance don't cover data embedded here
 		if (task_set_ & T_LOCK)
 		{
 			if (programmer_.flash_image_embed_lock_data(flash_write_data_, lock_data_))
+			{
 				task_set_ &= ~T_LOCK;
+				image_crcs_.clear();
+			}
 		}
 
 		if (task_set_ & T_WRITE_MAC)
 		{
 			if (programmer_.flash_image_embed_mac_address(flash_write_data_, mac_addr_))
+			{
 				task_set_ &= ~T_WRITE_MAC;
+				image_crcs_.clear();
+			}
 		}
-		task_write_flash();
 	}
 
+	if (task_set_ & T_COMPILE_PLAN)
+	{
+		task_compile_plan();
+		if (!(task_set_ & T_WRITE_FLASH))
+			return;
+	}
+
+	if (task_set_ & T_ERASE)
+		task_erase();
+
+	if (task_set_ & T_WRITE_FLASH)
+		task_write_flash();
+
 	if (task_set_ & T_VERIFY)
 		task_verify_flash();
 
 	if (task_set_ & (T_WRITE_MAC | T_LOCK))
 		task_write_config();
+
+	if (task_set_ & T_PROFILE)
+		task_profile();
+
+	if (task_set_ & T_LATENCY)
+		task_latency();
 }
 
 //==============================================================================
@@ -601,7 +874,9 @@ void CC_Flasher::task_read_info_page()
 
 	Timer timer;
 	ByteVector info_page;
+	stats_.start("info page read");
 	programmer_.unit_read_info_page(info_page);
+	stats_.finish(info_page.size());
 	print_result(true, timer);
 
 	if (info_page_read_target_.source_type() == ReadTarget::ST_CONSOLE)
@@ -618,9 +893,22 @@ void CC_Flasher::task_erase()
 {
 	std::cout << "  Erasing flash..." << "\n";
 
-	print_result(programmer_.unit_erase());
+	stats_.start("erase");
+	programmer_.unit_erase_start();
 
+	// Erase takes a while, build flash image meanwhile
+	if ((task_set_ & T_WRITE_FLASH) && !target_locked_)
+		programmer_.unit_flash_write_prepare(flash_write_data_);
+
+	bool result = programmer_.unit_erase_wait();
+	stats_.finish();
+	print_result(result);
+	if (!result)
+		metrics_.count("cctool_erase_timeouts");
+
+	stats_.start("connect");
 	programmer_.unit_connect(unit_info_);
+	stats_.finish();
 	target_locked_ = programmer_.unit_locked();
 }
 
@@ -630,31 +918,254 @@ void CC_Flasher::task_verify_flash()
 	std::cout << "  Verifying flash..." << "\n";
 
 	Timer timer;
-	bool result = programmer_.unit_flash_verify(flash_write_data_, verify_method_);
+	stats_.start("verify");
+	bool result = (verify_method_ == CC_Programmer::VM_BY_CRC && !image_crcs_.empty()) ?
+			programmer_.unit_flash_verify(image_crcs_) :
+			programmer_.unit_flash_verify(flash_write_data_, verify_method_);
+	stats_.finish(flash_write_data_.actual_size());
 	print_result(result, timer);
+
+	String method = verify_method_ == CC_Programmer::VM_BY_CRC ?
+			"method=\"crc\"" : "method=\"read\"";
+	metrics_.count("cctool_verifications", method);
+	if (!result)
+		metrics_.count("cctool_verify_failures", method);
 }
 
 //==============================================================================
 void CC_Flasher::task_read_flash()
 {
-	size_t size = unit_info_.actual_flash_size() / 1024;
-	std::cout << "  Reading flash (" << size << " KB)..." << "\n";
+	AddressRange range = flash_read_target_.range();
+	if (range.empty())
+		range = AddressRange(0, unit_info_.actual_flash_size());
+
+	if (range.end > unit_info_.actual_flash_size())
+	{
+		std::cout << "  Range " << range << " exceeding flash size, reading canceled" << "\n";
+		return;
+	}
+
+	String size = convinient_storage_size(range.end - range.begin);
+	std::cout << "  Reading flash " << range << " (" << size << ")..." << "\n";
 
+	// blocks are written to the file or console as they're read
 	Timer timer;
-	ByteVector flash_data;
-	programmer_.unit_flash_read(flash_data);
-	flash_read_target_.on_read(flash_data);
+	HexDumpSink dump;
+	bool console = flash_read_target_.source_type() == ReadTarget::ST_CONSOLE;
+	stats_.start("read");
+	if (console)
+		programmer_.unit_flash_read(range, dump);
+	else
+	{
+		flash_read_target_.open();
+		programmer_.unit_flash_read(range, flash_read_target_);
+		flash_read_target_.close();
+	}
+	stats_.finish(range.end - range.begin);
 	print_result(true, timer);
+
+	if (console)
+		std::cout << dump.dump();
 }
 
 //==============================================================================
-void CC_Flasher::task_write_flash()
+void CC_Flasher::load_flash_image()
 {
-	size_t flash_size = unit_info_.flash_size ?
-			unit_info_.flash_size : unit_info_.max_flash_size;
-	flash_size *= 1024;
+	if (!flash_plan_.opened())
+	{
+		image_loader_.finish(flash_write_data_);
+		image_loader_.get_block_crcs(programmer_.unit_verify_block_size(),
+				image_crcs_);
+		return;
+	}
+
+	const FlashPlanHeader &header = flash_plan_.header();
+	if (header.unit_id != unit_info_.ID ||
+			header.flash_size != flash_size_limit(unit_info_))
+	{
+		String name(header.unit_name, strnlen(header.unit_name, sizeof(header.unit_name)));
+		throw std::runtime_error("flash plan " + flash_plan_.file_name() +
+				" is compiled for " + name + " with " +
+				number_to_string(header.flash_size / 1024) + " KB of flash");
+	}
+
+	AddressRange range;
+	bool present = programmer_.flash_image_lock_data_range(range);
+	if (!slot_matches(present, range, header.lock_offset, header.lock_size))
+		throw std::runtime_error("lock data location of flash plan " +
+				flash_plan_.file_name() + " doesn't match the target");
 
+	present = programmer_.flash_image_mac_address_range(range);
+	if (!slot_matches(present, range, header.mac_offset, header.mac_size))
+		throw std::runtime_error("mac address location of flash plan " +
+				flash_plan_.file_name() + " doesn't match the target");
+
+	flash_plan_.get_sections(flash_write_data_);
+	flash_plan_.get_block_crcs(image_crcs_);
+
+	log_info("main, loaded flash plan %s, blocks: %u",
+			flash_plan_.file_name().c_str(), flash_plan_.block_count());
+}
+
+//==============================================================================
+void CC_Flasher::task_compile_plan()
+{
+	size_t flash_size = flash_size_limit(unit_info_);
 	if (flash_write_data_.upper_address() > flash_size)
+	{
+		std::cout << "  Flash image size exceeding flash physical size, plan is not compiled" << "\n";
+		task_set_ &= ~(T_WRITE_FLASH | T_VERIFY | T_LOCK);
+		return;
+	}
+
+	FlashPlanHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.unit_name, unit_info_.name.c_str(), sizeof(header.unit_name) - 1);
+	header.unit_id = unit_info_.ID;
+	header.flash_size = flash_size;
+	header.block_size = programmer_.unit_verify_block_size();
+
+	AddressRange range;
+	if (programmer_.flash_image_lock_data_range(range))
+	{
+		header.lock_offset = range.begin;
+		header.lock_size = range.end - range.begin;
+	}
+
+	if (programmer_.flash_image_mac_address_range(range))
+	{
+		header.mac_offset = range.begin;
+		header.mac_size = range.end - range.begin;
+	}
+
+	std::cout << "  Compiling flash plan..." << "\n";
+
+	stats_.start("compile plan");
+	FlashPlan::save(option_compile_plan_, header, flash_write_data_);
+	stats_.finish(flash_write_data_.actual_size());
+	print_result(true);
+}
+
+//==============================================================================
+void CC_Flasher::task_apply_delta()
+{
+	const FlashDeltaHeader &header = flash_delta_.header();
+	size_t page_size = unit_info_.flash_page_size * 1024;
+	if (header.page_size % page_size)
+	{
+		std::cout << "  Delta page size " << header.page_size
+				<< " B doesn't match flash page size " << page_size
+				<< " B, update canceled" << "\n";
+		return;
+	}
+
+	if (header.upper_address > flash_size_limit(unit_info_))
+	{
+		std::cout << "  Delta exceeding flash physical size, update canceled" << "\n";
+		return;
+	}
+
+	std::cout << "  Checking flash pages..." << "\n";
+
+	Timer check_timer;
+	FlashBlockCrcList pages(flash_delta_.page_count());
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		pages[i].address = flash_delta_.page(i).address;
+		pages[i].size = header.page_size;
+	}
+
+	stats_.start("delta check");
+	programmer_.unit_flash_crc(pages);
+	stats_.finish(pages.size() * header.page_size);
+
+	// A page holding the new content is left from an interrupted update,
+	// any other content means the target doesn't run the base image
+	std::vector<size_t> updates;
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		const FlashDeltaPage &page = flash_delta_.page(i);
+		if (pages[i].crc == page.old_crc)
+			updates.push_back(i);
+		else
+		if (pages[i].crc != page.new_crc)
+		{
+			AddressRange range(page.address, page.address + header.page_size);
+			print_result(false);
+			std::cout << "  Flash at " << range
+					<< " doesn't match the base image of delta, update canceled" << "\n";
+			return;
+		}
+	}
+	print_result(true, check_timer);
+
+	if (updates.empty())
+	{
+		std::cout << "  Flash is up to date" << "\n";
+		return;
+	}
+
+	DataSectionStore sections;
+	FlashBlockCrcList blocks;
+	foreach (size_t index, updates)
+	{
+		const uint8_t *data = flash_delta_.page_data(index);
+		if (data)
+			sections.add_section(DataSection(pages[index].address, data,
+					header.page_size), false);
+
+		pages[index].crc = flash_delta_.page(index).new_crc;
+		blocks.push_back(pages[index]);
+	}
+
+	String size = convinient_storage_size(updates.size() * header.page_size);
+	std::cout << "  Updating " << updates.size() << " pages (" << size << ")..." << "\n";
+
+	Timer write_timer;
+	stats_.start("delta erase");
+	foreach (const FlashBlockCrc &block, blocks)
+	{
+		for (size_t offset = 0; offset < block.size; offset += page_size)
+		{
+			if (!programmer_.unit_erase_page(block.address + offset))
+			{
+				AddressRange range(block.address + offset,
+						block.address + offset + page_size);
+				stats_.finish();
+				print_result(false);
+				std::cout << "  Erase of flash at " << range
+						<< " is aborted, page may be locked" << "\n";
+				return;
+			}
+		}
+	}
+	stats_.finish(blocks.size() * header.page_size);
+
+	stats_.start("write");
+	programmer_.unit_flash_write(sections);
+	stats_.finish(sections.actual_size());
+	print_result(true, write_timer);
+
+	metrics_.count("cctool_units_programmed");
+	metrics_.count("cctool_bytes_written", "", sections.actual_size());
+
+	std::cout << "  Verifying flash..." << "\n";
+
+	Timer verify_timer;
+	stats_.start("verify");
+	bool result = programmer_.unit_flash_verify(blocks);
+	stats_.finish(blocks.size() * header.page_size);
+	print_result(result, verify_timer);
+
+	metrics_.count("cctool_verifications", "method=\"crc\"");
+	if (!result)
+		metrics_.count("cctool_verify_failures", "method=\"crc\"");
+}
+
+//==============================================================================
+void CC_Flasher::task_write_flash()
+{
+	if (flash_write_data_.upper_address() > flash_size_limit(unit_info_))
 	{
 		std::cout << "  Flash image size exceeding flash physical size, writing canceled..." << "\n";
 		task_set_ &= ~(T_VERIFY | T_LOCK);
@@ -665,14 +1176,118 @@ void CC_Flasher::task_write_flash()
 	std::cout << "  Writing flash (" << size << ")..." << "\n";
 
 	Timer timer;
+	stats_.start("write");
 	programmer_.unit_flash_write(flash_write_data_);
+	stats_.finish(flash_write_data_.actual_size());
 	print_result(true, timer);
+
+	metrics_.count("cctool_units_programmed");
+	metrics_.count("cctool_bytes_written", "", flash_write_data_.actual_size());
+}
+
+//==============================================================================
+void CC_Flasher::task_profile()
+{
+	std::cout << "  Profiling firmware for " << profile_duration_ << " s at "
+			<< profile_rate_ << " samples/s..." << "\n";
+
+	// firmware runs from reset, not from the state programming left
+	programmer_.unit_connect(unit_info_);
+
+	Timer timer;
+	CC_Profiler profiler(programmer_, profile_symbols_);
+	stats_.start("profile");
+	profiler.run(profile_rate_, profile_rate_ * profile_duration_, true);
+	stats_.finish();
+	print_result(true, timer);
+
+	profiler.print_flat(std::cout);
+	if (!option_profile_folded_.empty())
+		profiler.save_folded(option_profile_folded_);
+}
+
+//==============================================================================
+void CC_Flasher::read_latency_range(const String &range, const SymbolMap &symbols)
+{
+	StringVector addresses;
+	boost::split(addresses, range, boost::is_any_of(":"));
+	if (addresses.size() > 2 || addresses[0].empty() ||
+			(addresses.size() == 2 && addresses[1].empty()))
+		throw po::error("invalid latency range " + range);
+
+	const CodeSymbol *entry_symbol = NULL;
+	for (size_t i = 0; i < addresses.size(); i++)
+	{
+		uint_t &address = i ? latency_exit_ : latency_entry_;
+
+		char *bad_character = NULL;
+		address = strtoul(addresses[i].c_str(), &bad_character, 0);
+		if (*bad_character == '\0')
+			continue;
+
+		const CodeSymbol *symbol = symbols.find_by_name(addresses[i]);
+		if (!symbol)
+			throw po::error("unknown function " + addresses[i] + " (see 'latency-symbols')");
+		if (i && !symbol->end)
+			throw po::error("end of function " + addresses[i] + " is unknown, "
+					"use .cdb file or give exit address");
+		address = i ? symbol->end - 1 : symbol->address;
+		if (!i)
+			entry_symbol = symbol;
+	}
+
+	// the last instruction (RET) of the function
+	if (addresses.size() == 1)
+	{
+		if (!entry_symbol || !entry_symbol->end)
+			throw po::error("exit of " + addresses[0] + " is unknown, use "
+					"'entry:exit' or function name with .cdb file");
+		latency_exit_ = entry_symbol->end - 1;
+	}
+
+	if (latency_entry_ == latency_exit_)
+		throw po::error("latency entry and exit must differ");
+}
+
+//==============================================================================
+void CC_Flasher::task_latency()
+{
+	std::cout << "  Measuring latency from " << std::hex << std::uppercase
+			<< std::setfill('0') << "0x" << std::setw(4) << latency_entry_
+			<< " to 0x" << std::setw(4) << latency_exit_ << std::dec
+			<< ", " << latency_count_ << " runs..." << "\n";
+
+	// firmware runs from reset, not from the state programming left
+	programmer_.unit_connect(unit_info_);
+
+	Timer timer;
+	CC_LatencyMeter meter(programmer_);
+	stats_.start("latency");
+	meter.start_timer(latency_divider_);
+	bool result = meter.run(latency_entry_, latency_exit_, latency_count_,
+			(uint64_t)latency_timeout_ * 1000000);
+	stats_.finish();
+	print_result(result, timer);
+
+	if (!result)
+		std::cout << "  Breakpoint was not hit in " << latency_timeout_ << " s, "
+				<< meter.latencies().size() << " of " << latency_count_
+				<< " runs measured" << "\n";
+	meter.print_histogram(std::cout);
 }
 
 //==============================================================================
 CC_Flasher::CC_Flasher() :
 		task_set_(0),
 		verify_method_(CC_Programmer::VM_BY_CRC),
+		verify_method_given_(false),
+		profile_rate_(100),
+		profile_duration_(10),
+		latency_entry_(0),
+		latency_exit_(0),
+		latency_count_(100),
+		latency_divider_(1),
+		latency_timeout_(10),
 		target_locked_(false)
 {
 	programmer_.do_on_flash_read_progress(on_progress);
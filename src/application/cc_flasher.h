@@ -14,10 +14,14 @@
 #include <boost/program_options.hpp>
 #include "data/binary_file.h"
 #include "data/hex_file.h"
+#include "data/flash_plan.h"
+#include "data/flash_delta.h"
 #include "data/read_target.h"
+#include "data/symbol_map.h"
 #include "data/data_section_store.h"
 #include "programmer/cc_programmer.h"
 #include "application/cc_base.h"
+#include "application/cc_image_loader.h"
 
 class CC_Flasher : public CC_Base
 {
@@ -33,10 +37,19 @@ private:
 	void task_read_mac_address();
 	void task_write_config();
 	void task_read_info_page();
+	void task_compile_plan();
+	void task_apply_delta();
+	void task_profile();
+	void task_latency();
+
+	/// Merge loaded files or take image of the flash plan
+	void load_flash_image();
 
 	bool validate_mac_options();
 	bool validate_lock_options();
 	bool validate_flash_size_options();
+	/// Take flash offset of 'entry[:exit]' given by numbers or function names
+	void read_latency_range(const String &range, const SymbolMap &symbols);
 
 	virtual void init_options(po::options_description &);
 	virtual bool read_options(const po::options_description &, const po::variables_map &);
@@ -46,12 +59,35 @@ private:
 	String option_info_page_;
 	String option_verify_type_;
 	String option_flash_size_;
+	String option_hex_record_size_;
+	String option_compile_plan_;
+	String option_image_cache_;
+	String option_profile_rate_;
+	String option_profile_duration_;
+	String option_profile_folded_;
+	String option_latency_symbols_;
+	String option_latency_count_;
+	String option_latency_divider_;
+	String option_latency_timeout_;
 	uint_t task_set_;
 
 	CC_Programmer::VerifyMethod verify_method_;
+	bool verify_method_given_; // otherwise tuning may choose
+	CC_ImageLoader image_loader_;
 	DataSectionStore flash_write_data_;
+	FlashPlan flash_plan_;
+	FlashDelta flash_delta_;
+	FlashBlockCrcList image_crcs_; // known in advance, empty if unknown
 	ByteVector mac_addr_;
 	ByteVector lock_data_;
+	SymbolMap profile_symbols_;
+	uint_t profile_rate_;		// samples per second
+	uint_t profile_duration_;	// s
+	uint_t latency_entry_;		// flash offsets
+	uint_t latency_exit_;
+	uint_t latency_count_;
+	uint_t latency_divider_;
+	uint_t latency_timeout_;	// s
 
 	ReadTarget flash_read_target_;
 	ReadTarget info_page_read_target_;
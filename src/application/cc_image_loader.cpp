@@ -0,0 +1,210 @@
+/*
+ * cc_image_loader.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <unistd.h>
+#include "log.h"
+#include "data/binary_file.h"
+#include "data/hex_file.h"
+#include "cc_image_loader.h"
+
+//==============================================================================
+static void load_file(const ImageCache &cache, const OptionFileInfo &file_info,
+		DataSectionStore &store, FlashBlockCrcMap &crcs)
+{
+	if (file_info.type == "hex")
+		cache.hex_file_load(file_info.name, store, crcs);
+
+	if (file_info.type == "bin")
+	{
+		DataSection section;
+		section.address = file_info.offset;
+		binary_file_load(file_info.name, section.data);
+		store.take_section(section, true);
+	}
+
+	// CRCs of the whole file don't fit its part
+	if (!file_info.range.empty())
+	{
+		store.clip(file_info.range);
+		crcs.clear();
+	}
+}
+
+//==============================================================================
+static void log_loaded_file(const OptionFileInfo &file_info,
+		const DataSectionStore &store)
+{
+	if (file_info.type == "hex")
+	{
+		size_t n = 0;
+		log_info("main, loaded hex file %s", file_info.name.c_str());
+		foreach (const DataSection &item, store.sections())
+			log_info(" section %02u, address: %06Xh, size: %06Xh",
+					n++, item.address, item.size());
+	}
+
+	if (file_info.type == "bin")
+		log_info("main, loaded bin file %s, size: %u", file_info.name.c_str(),
+				store.actual_size());
+}
+
+//==============================================================================
+void CC_ImageLoader::add_file(const OptionFileInfo &file_info)
+{
+	assert(threads_.empty());
+
+	items_.push_back(Item());
+	items_.back().file_info = file_info;
+	items_.back().failed = false;
+}
+
+//==============================================================================
+bool CC_ImageLoader::empty() const
+{	return items_.empty(); }
+
+//==============================================================================
+void CC_ImageLoader::set_cache(const ImageCache &cache)
+{
+	assert(threads_.empty());
+	cache_ = cache;
+}
+
+//==============================================================================
+bool CC_ImageLoader::get_block_crcs(size_t block_size,
+		FlashBlockCrcList &blocks) const
+{
+	FlashBlockCrcMap::const_iterator it = crcs_.find(block_size);
+	if (it == crcs_.end())
+		return false;
+
+	blocks = it->second;
+	return true;
+}
+
+//==============================================================================
+void CC_ImageLoader::start(size_t max_threads)
+{
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpu_count > 0)
+		max_threads = std::min(max_threads, (size_t)cpu_count);
+
+	size_t count = std::min(max_threads, items_.size());
+	for (size_t i = 0; i < count; i++)
+	{
+		pthread_t thread;
+		// files left are parsed by finish if a thread can't be created
+		if (pthread_create(&thread, NULL, thread_entry, this))
+			break;
+		threads_.push_back(thread);
+	}
+}
+
+//==============================================================================
+void *CC_ImageLoader::thread_entry(void *loader)
+{
+	((CC_ImageLoader *)loader)->run();
+	return NULL;
+}
+
+//==============================================================================
+void CC_ImageLoader::run()
+{
+	while (true)
+	{
+		pthread_mutex_lock(&mutex_);
+		size_t index = next_item_;
+		bool done = canceled_ || index >= items_.size();
+		if (!done)
+			next_item_++;
+		pthread_mutex_unlock(&mutex_);
+
+		if (done)
+			break;
+
+		Item &item = items_[index];
+		try
+		{
+			load_file(cache_, item.file_info, item.store, item.crcs);
+		}
+		catch (std::exception &e)
+		{
+			item.error = e.what();
+			item.failed = true;
+		}
+	}
+}
+
+//==============================================================================
+void CC_ImageLoader::join()
+{
+	foreach (pthread_t thread, threads_)
+		pthread_join(thread, NULL);
+	threads_.clear();
+}
+
+//==============================================================================
+void CC_ImageLoader::finish(DataSectionStore &store)
+{
+	run();
+	join();
+
+	// merge in command line order so result doesn't depend on thread timing
+	foreach (Item &item, items_)
+	{
+		if (item.failed)
+			throw FileException(item.error);
+
+		log_loaded_file(item.file_info, item.store);
+
+		AddressRangeList overlaps;
+		foreach (const DataSection &section, item.store.sections())
+			store.find_overlaps(section, overlaps);
+
+		if (!overlaps.empty())
+		{
+			std::stringstream ss;
+			ss << overlaps;
+			std::cout << "  File '" << item.file_info.name
+					<< "' overrides data at " << ss.str() << "\n";
+			log_info("main, file %s overrides data at %s",
+					item.file_info.name.c_str(), ss.str().c_str());
+		}
+
+		if (store.sections().empty())
+			store.swap(item.store);
+		else
+			store.add_sections(item.store, true);
+		item.store.remove_sections();
+	}
+
+	// merging changes CRCs of blocks
+	if (items_.size() == 1)
+		crcs_.swap(items_.front().crcs);
+	items_.clear();
+}
+
+//==============================================================================
+CC_ImageLoader::CC_ImageLoader() :
+		next_item_(0),
+		canceled_(false)
+{
+	pthread_mutex_init(&mutex_, NULL);
+}
+
+//==============================================================================
+CC_ImageLoader::~CC_ImageLoader()
+{
+	// files being parsed are completed, others are skipped
+	pthread_mutex_lock(&mutex_);
+	canceled_ = true;
+	pthread_mutex_unlock(&mutex_);
+
+	join();
+	pthread_mutex_destroy(&mutex_);
+}
@@ -0,0 +1,69 @@
+/*
+ * cc_image_loader.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_IMAGE_LOADER_H_
+#define _CC_IMAGE_LOADER_H_
+
+#include <pthread.h>
+#include "data/read_target.h"
+#include "data/data_section_store.h"
+#include "data/image_cache.h"
+
+/// Parses flash image files on background threads while the programmer is
+/// being opened. Files are merged in the order they were added, data of a
+/// later file overrides data of earlier ones.
+class CC_ImageLoader : boost::noncopyable
+{
+public:
+	void add_file(const OptionFileInfo &file_info);
+	bool empty() const;
+
+	/// Hex files are taken through the cache, must be set before start
+	void set_cache(const ImageCache &cache);
+
+	/// Start parsing, up to max_threads files are parsed at once
+	void start(size_t max_threads = 4);
+
+	/// Wait for all files to be parsed and merge them into the store.
+	/// Overridden ranges are reported, the first failed file throws
+	void finish(DataSectionStore &store); // throw
+
+	/// Block CRCs of the image known in advance (from cache), available
+	/// after finish if the image is made of a single file
+	/// @return false if CRCs are unknown
+	bool get_block_crcs(size_t block_size, FlashBlockCrcList &blocks) const;
+
+	CC_ImageLoader();
+	~CC_ImageLoader();
+
+private:
+	struct Item
+	{
+		OptionFileInfo file_info;
+		DataSectionStore store;
+		FlashBlockCrcMap crcs;
+		String error;
+		bool failed;
+	};
+
+	static void *thread_entry(void *loader);
+	/// Parse files until none left, called by threads and on finish
+	void run();
+	void join();
+
+	ImageCache cache_;
+	FlashBlockCrcMap crcs_;
+	std::vector<Item> items_;
+	std::vector<pthread_t> threads_;
+	pthread_mutex_t mutex_;
+	size_t next_item_;
+	bool canceled_;
+};
+
+#endif // !_CC_IMAGE_LOADER_H_
@@ -0,0 +1,285 @@
+/*
+ * cc_image_tool.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include "common.h"
+#include "version.h"
+#include "data/binary_file.h"
+#include "data/hex_file.h"
+#include "data/flash_delta.h"
+#include "data/image_pages.h"
+#include "cc_image_loader.h"
+#include "cc_image_tool.h"
+
+typedef boost::shared_ptr<CC_ImageLoader> CC_ImageLoaderPtr;
+
+//==============================================================================
+static String address_to_string(uint_t address)
+{
+	std::stringstream ss;
+	ss << "0x" << std::hex << std::uppercase << std::setfill('0')
+			<< std::setw(6) << address;
+	return ss.str();
+}
+
+//==============================================================================
+static String crc_to_string(uint16_t crc)
+{
+	std::stringstream ss;
+	ss << "0x" << std::hex << std::uppercase << std::setfill('0')
+			<< std::setw(4) << crc;
+	return ss.str();
+}
+
+//==============================================================================
+CC_ImageTool::CC_ImageTool() :
+		page_size_(1024),
+		hex_record_size_(HEX_RECORD_SIZE)
+{ }
+
+//==============================================================================
+void CC_ImageTool::init_options(po::options_description &desc)
+{
+	desc.add_options()
+		("help,h", "produce help message");
+
+	desc.add_options()
+		("command", po::value<String>(&command_),
+				"convert, merge, crc, diff or delta");
+
+	desc.add_options()
+		("input", po::value<StringVector>(&inputs_), "input files");
+
+	desc.add_options()
+		("output,o", po::value<String>(&output_),
+				"output file of convert, merge and delta");
+
+	desc.add_options()
+		("page-size", po::value<size_t>(&page_size_),
+				"page size of crc, diff and delta in bytes (1024 by default)");
+
+	desc.add_options()
+		("hex-record-size", po::value<size_t>(&hex_record_size_),
+				"data bytes per record of hex files written, 1..255 (32 by default)");
+}
+
+//==============================================================================
+void CC_ImageTool::print_help(const po::options_description &desc)
+{
+	std::cout << MODULE_DESCRIPTION << "\n";
+	std::cout << " Version: "  << VERSION_MAJOR << "." << VERSION_MINOR << "\n";
+	std::cout << "\n Usage: cc-tool image <command> [options] files...\n";
+	std::cout << "\n Commands:\n";
+	std::cout << "   convert in -o out      convert between hex and binary file\n";
+	std::cout << "   merge in... -o out     merge files, later files override earlier ones\n";
+	std::cout << "   crc in...              CRC16 of every page with data as target computes it\n";
+	std::cout << "   diff old new           pages that differ, exit status 1 if any\n";
+	std::cout << "   delta old new -o out   save pages that differ for --apply-delta,\n";
+	std::cout << "                          page size must match target flash page\n";
+	std::cout << "\n File names are given as for --write: file_name[:type[:offset]]\n";
+	std::cout << "\n Command line options:\n";
+	std::cout << desc;
+}
+
+//==============================================================================
+void CC_ImageTool::load_inputs(std::vector<DataSectionStore> &stores)
+{
+	std::vector<CC_ImageLoaderPtr> loaders;
+	foreach (const String &input, inputs_)
+	{
+		OptionFileInfo file_info;
+		option_extract_file_info(input, file_info, true);
+		if (file_info.type == "plan")
+			throw po::error("flash plan is not supported here (" + input + ")");
+
+		CC_ImageLoaderPtr loader(new CC_ImageLoader());
+		loader->add_file(file_info);
+		loader->start(1);
+		loaders.push_back(loader);
+	}
+
+	stores.resize(loaders.size());
+	for (size_t i = 0; i < loaders.size(); i++)
+		loaders[i]->finish(stores[i]);
+}
+
+//==============================================================================
+void CC_ImageTool::save_output(const DataSectionStore &store)
+{
+	OptionFileInfo file_info;
+	option_extract_file_info(output_, file_info, false);
+	if (!file_info.range.empty())
+		throw po::error("address range is not allowed for output (" + output_ + ")");
+
+	if (file_info.type == "hex")
+		hex_file_save(file_info.name, store, hex_record_size_);
+	else
+	{
+		ByteVector image;
+		store.create_image(PAGE_FILLER, image);
+		binary_file_save(file_info.name, image);
+	}
+}
+
+//==============================================================================
+void CC_ImageTool::command_merge()
+{
+	CC_ImageLoader loader;
+	foreach (const String &input, inputs_)
+	{
+		OptionFileInfo file_info;
+		option_extract_file_info(input, file_info, true);
+		if (file_info.type == "plan")
+			throw po::error("flash plan is not supported here (" + input + ")");
+		loader.add_file(file_info);
+	}
+	loader.start();
+
+	DataSectionStore store;
+	loader.finish(store);
+	save_output(store);
+}
+
+//==============================================================================
+void CC_ImageTool::command_crc()
+{
+	std::vector<DataSectionStore> stores;
+	load_inputs(stores);
+
+	std::cout << "file,address,size,crc\n";
+	for (size_t i = 0; i < stores.size(); i++)
+	{
+		FlashBlockCrcList pages;
+		image_page_crcs(stores[i], page_size_, pages);
+
+		foreach (const FlashBlockCrc &page, pages)
+			std::cout << inputs_[i] << "," << address_to_string(page.address)
+					<< "," << page.size << "," << crc_to_string(page.crc) << "\n";
+	}
+}
+
+//==============================================================================
+int CC_ImageTool::command_diff()
+{
+	std::vector<DataSectionStore> stores;
+	load_inputs(stores);
+
+	PageChangeList changes;
+	image_page_changes(stores[0], stores[1], page_size_, changes);
+
+	std::cout << "address,size,old_crc,new_crc,change\n";
+	foreach (const PageChange &change, changes)
+	{
+		const char *kind = "modified";
+		if (change.old_blank)
+			kind = "added";
+		if (change.new_blank)
+			kind = "removed";
+
+		std::cout << address_to_string(change.address) << "," << page_size_
+				<< "," << crc_to_string(change.old_crc)
+				<< "," << crc_to_string(change.new_crc)
+				<< "," << kind << "\n";
+	}
+	return changes.empty() ? EXIT_SUCCESS : 1;
+}
+
+//==============================================================================
+void CC_ImageTool::command_delta()
+{
+	std::vector<DataSectionStore> stores;
+	load_inputs(stores);
+
+	PageChangeList changes;
+	image_page_changes(stores[0], stores[1], page_size_, changes);
+	FlashDelta::save(output_, stores[1], page_size_, changes);
+
+	std::cout << "  Delta: " << changes.size() << " pages of "
+			<< page_size_ << " B changed\n";
+}
+
+//==============================================================================
+int CC_ImageTool::execute(int argc, char *argv[])
+{
+	po::options_description desc;
+	init_options(desc);
+
+	po::positional_options_description positional;
+	positional.add("command", 1);
+	positional.add("input", -1);
+
+	try
+	{
+		po::variables_map vm;
+		po::store(po::command_line_parser(argc, argv).options(desc).
+				positional(positional).run(), vm);
+		po::notify(vm);
+
+		if (vm.count("help") || command_.empty())
+		{
+			print_help(desc);
+			return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		if (!page_size_ || page_size_ % 2 || page_size_ > 0x1FFF)
+			throw po::error("invalid page size " + number_to_string(page_size_));
+		if (!hex_record_size_ || hex_record_size_ > 255)
+			throw po::error("invalid hex record size " + number_to_string(hex_record_size_));
+
+		if (command_ == "convert" || command_ == "merge")
+		{
+			if (inputs_.empty() || output_.empty())
+				throw po::error(command_ + " needs input and output files");
+			if (command_ == "convert" && inputs_.size() != 1)
+				throw po::error("convert takes a single input file");
+
+			command_merge();
+			return EXIT_SUCCESS;
+		}
+
+		if (command_ == "crc")
+		{
+			if (inputs_.empty())
+				throw po::error("crc needs input files");
+
+			command_crc();
+			return EXIT_SUCCESS;
+		}
+
+		if (command_ == "diff")
+		{
+			if (inputs_.size() != 2)
+				throw po::error("diff takes two input files");
+
+			return command_diff();
+		}
+
+		if (command_ == "delta")
+		{
+			if (inputs_.size() != 2 || output_.empty())
+				throw po::error("delta takes two input files and output file");
+
+			command_delta();
+			return EXIT_SUCCESS;
+		}
+		throw po::error("unknown command " + command_);
+	}
+	catch (po::error& e) // command line error
+	{
+		std::cerr << "  Bad command line options";
+		if (strlen(e.what()))
+			std::cerr << " (" << e.what() << ")";
+		std::cerr << "\n  Try 'cc-tool image --help' for more information\n";
+	}
+	catch (std::runtime_error& e) // file error
+	{
+		std::cerr << "  Error occured: " << e.what() << "\n";
+	}
+	// diff(1) convention: 1 is for differences, 2 for trouble
+	return 2;
+}
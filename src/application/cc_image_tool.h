@@ -0,0 +1,48 @@
+/*
+ * cc_image_tool.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_IMAGE_TOOL_H_
+#define _CC_IMAGE_TOOL_H_
+
+#include <boost/program_options.hpp>
+#include "data/data_section_store.h"
+
+namespace po = boost::program_options;
+
+/// Image commands that work without programmer: 'cc-tool image <command>'
+class CC_ImageTool : boost::noncopyable
+{
+public:
+	/// @param argv arguments after 'image'
+	/// @return exit status, diff returns 1 if images differ
+	int execute(int argc, char *argv[]);
+
+	CC_ImageTool();
+
+private:
+	void init_options(po::options_description &desc);
+	void print_help(const po::options_description &desc);
+
+	/// Load every input file into its own store, files are parsed in parallel
+	void load_inputs(std::vector<DataSectionStore> &stores);
+	void save_output(const DataSectionStore &store);
+
+	void command_merge();
+	void command_crc();
+	int command_diff();
+	void command_delta();
+
+	String command_;
+	StringVector inputs_;
+	String output_;
+	size_t page_size_;
+	size_t hex_record_size_;
+};
+
+#endif // !_CC_IMAGE_TOOL_H_
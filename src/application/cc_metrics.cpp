@@ -0,0 +1,231 @@
+/*
+ * cc_metrics.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <fstream>
+#include "data/file.h"
+#include "cc_metrics.h"
+
+enum MetricType { MT_COUNTER, MT_HISTOGRAM };
+
+struct MetricFamily
+{
+	const char *name;
+	MetricType type;
+	const char *help;
+};
+
+const static MetricFamily FamilyTable[] = {
+	{ "cctool_runs", MT_COUNTER, "Runs of cc-tool by result" },
+	{ "cctool_units_programmed", MT_COUNTER, "Targets with flash written" },
+	{ "cctool_bytes_written", MT_COUNTER, "Flash bytes written" },
+	{ "cctool_verifications", MT_COUNTER, "Flash verifications by method" },
+	{ "cctool_verify_failures", MT_COUNTER, "Failed flash verifications by method" },
+	{ "cctool_erase_timeouts", MT_COUNTER, "Chip erases not completed in time" },
+	{ "cctool_usb_transfers", MT_COUNTER, "USB transfers by type" },
+	{ "cctool_usb_bytes", MT_COUNTER, "USB payload bytes by direction" },
+	{ "cctool_usb_errors", MT_COUNTER, "Failed USB transfers by libusb error code" },
+	{ "cctool_operation_seconds", MT_HISTOGRAM, "Duration of programmer operations" },
+};
+
+// Histogram bucket upper bounds in seconds, +Inf bucket is implied
+const static double BucketTable[] = {
+	0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60
+};
+
+//==============================================================================
+static const MetricFamily *find_family(const String &name)
+{
+	foreach (const MetricFamily &family, FamilyTable)
+		if (name == family.name)
+			return &family;
+	return NULL;
+}
+
+//==============================================================================
+static String number_to_text(double value)
+{
+	std::stringstream ss;
+	ss << std::setprecision(15) << value;
+	return ss.str();
+}
+
+//==============================================================================
+static String join_labels(const String &labels, const String &label)
+{
+	return labels.empty() ? label : labels + "," + label;
+}
+
+//==============================================================================
+static bool strip_suffix(const String &name, const char suffix[], String &base)
+{
+	size_t size = strlen(suffix);
+	if (name.size() <= size || name.compare(name.size() - size, size, suffix))
+		return false;
+
+	base = name.substr(0, name.size() - size);
+	return true;
+}
+
+//==============================================================================
+CC_Metrics::Histogram::Histogram() :
+		buckets(ARRAY_SIZE(BucketTable) + 1, 0),
+		sum(0),
+		count(0)
+{ }
+
+//==============================================================================
+void CC_Metrics::count(const String &name, const String &labels, double value)
+{	counters_[name][labels] += value; }
+
+//==============================================================================
+void CC_Metrics::observe(const String &name, const String &labels, double value)
+{
+	Histogram &histogram = histograms_[name][labels];
+
+	for (size_t i = 0; i < ARRAY_SIZE(BucketTable); i++)
+		if (value <= BucketTable[i])
+			histogram.buckets[i]++;
+	histogram.buckets.back()++;
+	histogram.sum += value;
+	histogram.count++;
+}
+
+//==============================================================================
+void CC_Metrics::load_sample(const String &name, const String &labels, double value)
+{
+	String base;
+	const MetricFamily *family = NULL;
+
+	if (strip_suffix(name, "_total", base) && (family = find_family(base)) &&
+			family->type == MT_COUNTER)
+	{
+		counters_[base][labels] += value;
+		return;
+	}
+
+	if (strip_suffix(name, "_sum", base) && (family = find_family(base)) &&
+			family->type == MT_HISTOGRAM)
+	{
+		histograms_[base][labels].sum += value;
+		return;
+	}
+
+	if (strip_suffix(name, "_count", base) && (family = find_family(base)) &&
+			family->type == MT_HISTOGRAM)
+	{
+		histograms_[base][labels].count += value;
+		return;
+	}
+
+	if (strip_suffix(name, "_bucket", base) && (family = find_family(base)) &&
+			family->type == MT_HISTOGRAM)
+	{
+		// le is always the last label as written by save()
+		size_t pos = labels.rfind("le=\"");
+		if (pos == String::npos)
+			return;
+
+		double bound = strtod(labels.c_str() + pos + 4, NULL);
+		String rest = labels.substr(0, pos ? pos - 1 : 0);
+
+		Histogram &histogram = histograms_[base][rest];
+		size_t index = std::find(BucketTable, BucketTable + ARRAY_SIZE(BucketTable),
+				bound) - BucketTable;
+		histogram.buckets[index] += value;
+	}
+}
+
+//==============================================================================
+void CC_Metrics::load(const String &file_name)
+{
+	std::ifstream in(file_name.c_str());
+
+	String line;
+	while (std::getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		size_t value_pos = line.rfind(' ');
+		if (value_pos == String::npos)
+			continue;
+
+		String name = line.substr(0, value_pos);
+		String labels;
+
+		size_t labels_pos = name.find('{');
+		if (labels_pos != String::npos)
+		{
+			labels = name.substr(labels_pos + 1, name.size() - labels_pos - 2);
+			name.erase(labels_pos);
+		}
+		load_sample(name, labels, strtod(line.c_str() + value_pos + 1, NULL));
+	}
+}
+
+//==============================================================================
+void CC_Metrics::save(const String &file_name) const
+{
+	std::stringstream ss;
+
+	foreach (const MetricFamily &family, FamilyTable)
+	{
+		if (family.type == MT_COUNTER)
+		{
+			std::map<String, CounterMap>::const_iterator it = counters_.find(family.name);
+			if (it == counters_.end())
+				continue;
+
+			ss << "# TYPE " << family.name << " counter\n";
+			ss << "# HELP " << family.name << " " << family.help << "\n";
+
+			foreach (const CounterMap::value_type &item, it->second)
+			{
+				ss << family.name << "_total";
+				if (!item.first.empty())
+					ss << "{" << item.first << "}";
+				ss << " " << number_to_text(item.second) << "\n";
+			}
+		}
+
+		if (family.type == MT_HISTOGRAM)
+		{
+			std::map<String, HistogramMap>::const_iterator it =
+					histograms_.find(family.name);
+			if (it == histograms_.end())
+				continue;
+
+			ss << "# TYPE " << family.name << " histogram\n";
+			ss << "# HELP " << family.name << " " << family.help << "\n";
+
+			foreach (const HistogramMap::value_type &item, it->second)
+			{
+				const Histogram &histogram = item.second;
+				for (size_t i = 0; i < histogram.buckets.size(); i++)
+				{
+					String le = i < ARRAY_SIZE(BucketTable) ?
+							number_to_text(BucketTable[i]) : "+Inf";
+
+					ss << family.name << "_bucket{"
+						<< join_labels(item.first, "le=\"" + le + "\"") << "} "
+						<< number_to_text(histogram.buckets[i]) << "\n";
+				}
+
+				String labels = item.first.empty() ? "" : "{" + item.first + "}";
+				ss << family.name << "_count" << labels << " "
+					<< number_to_text(histogram.count) << "\n";
+				ss << family.name << "_sum" << labels << " "
+					<< number_to_text(histogram.sum) << "\n";
+			}
+		}
+	}
+	ss << "# EOF\n";
+
+	file_replace(file_name, ss.str());
+}
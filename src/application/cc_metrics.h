@@ -0,0 +1,56 @@
+/*
+ * cc_metrics.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_METRICS_H_
+#define _CC_METRICS_H_
+
+#include <map>
+#include "common.h"
+
+/// Cumulative counters and histograms in OpenMetrics text format. Values are
+/// loaded from the previous file so every run of cc-tool adds to them, the
+/// file is suitable for node-exporter textfile collector.
+class CC_Metrics : boost::noncopyable
+{
+public:
+	/// Add value to counter
+	/// @param labels list like 'method="crc"', may be empty
+	void count(const String &name, const String &labels = "", double value = 1);
+
+	/// Add observation to histogram, value is in seconds
+	void observe(const String &name, const String &labels, double value);
+
+	/// Add values saved by previous runs, missing file is not an error
+	void load(const String &file_name);
+
+	/// Write all metrics into temporary file and then rename it over file_name
+	/// so readers never see partially written file. Processes adding to the
+	/// same file hold FileLock of it across load and save.
+	void save(const String &file_name) const; // throw
+
+private:
+	struct Histogram
+	{
+		std::vector<double> buckets; // cumulative, last one is +Inf
+		double sum;
+		double count;
+
+		Histogram();
+	};
+
+	typedef std::map<String, double> CounterMap; // labels -> value
+	typedef std::map<String, Histogram> HistogramMap; // labels -> histogram
+
+	void load_sample(const String &name, const String &labels, double value);
+
+	std::map<String, CounterMap> counters_;
+	std::map<String, HistogramMap> histograms_;
+};
+
+#endif // !_CC_METRICS_H_
@@ -0,0 +1,107 @@
+/*
+ * cc_stats.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include "trace.h"
+#include "cc_stats.h"
+
+//==============================================================================
+CC_Stats::CC_Stats(CC_Programmer &programmer) :
+		programmer_(programmer),
+		started_(false),
+		start_time_(0)
+{ }
+
+//==============================================================================
+void CC_Stats::start(const String &name)
+{
+	if (started_)
+		trace_get().end();
+	trace_get().begin(name.c_str(), "phase");
+
+	started_ = true;
+	start_name_ = name;
+	start_transfers_ = programmer_.transfer_stats();
+	start_polls_ = programmer_.poll_stats();
+	start_time_ = get_monotonic_time();
+}
+
+//==============================================================================
+void CC_Stats::finish(size_t payload)
+{
+	if (!started_)
+		return;
+	started_ = false;
+	trace_get().end();
+
+	Phase phase;
+	phase.name = start_name_;
+	phase.time = get_monotonic_time() - start_time_;
+	phase.payload = payload;
+
+	const USB_TransferStats &transfers = programmer_.transfer_stats();
+	phase.transfers.bulk_reads = transfers.bulk_reads - start_transfers_.bulk_reads;
+	phase.transfers.bulk_writes = transfers.bulk_writes - start_transfers_.bulk_writes;
+	phase.transfers.control_reads = transfers.control_reads - start_transfers_.control_reads;
+	phase.transfers.control_writes = transfers.control_writes - start_transfers_.control_writes;
+	phase.transfers.bytes_in = transfers.bytes_in - start_transfers_.bytes_in;
+	phase.transfers.bytes_out = transfers.bytes_out - start_transfers_.bytes_out;
+
+	// Poll counters belong to the unit driver which may change on connect
+	CC_PollStats polls = programmer_.poll_stats();
+	if (polls.polls >= start_polls_.polls)
+	{
+		phase.polls.polls = polls.polls - start_polls_.polls;
+		phase.polls.wait_time = polls.wait_time - start_polls_.wait_time;
+	}
+	phases_.push_back(phase);
+}
+
+//==============================================================================
+const CC_Stats::PhaseVector &CC_Stats::phases() const
+{	return phases_; }
+
+//==============================================================================
+std::ostream& operator <<(std::ostream &os, const CC_Stats &o)
+{
+	os << "  Statistics:\n";
+	os << std::setfill(' ') << std::left << "   " << std::setw(14) << "Phase"
+		<< std::right
+		<< std::setw(9) << "Time, s"
+		<< std::setw(7) << "Bulk"
+		<< std::setw(9) << "Control"
+		<< std::setw(10) << "Out, B"
+		<< std::setw(10) << "In, B"
+		<< std::setw(9) << "Polls"
+		<< std::setw(9) << "Wait, s"
+		<< std::setw(10) << "KB/s" << "\n";
+
+	foreach (const CC_Stats::Phase &phase, o.phases())
+	{
+		double time = (double)phase.time / 1000000;
+
+		os << std::left << "   " << std::setw(14) << phase.name << std::right
+			<< std::fixed << std::setprecision(3)
+			<< std::setw(9) << time
+			<< std::setw(7) << phase.transfers.bulk_reads + phase.transfers.bulk_writes
+			<< std::setw(9) << phase.transfers.control_reads +
+					phase.transfers.control_writes
+			<< std::setw(10) << phase.transfers.bytes_out
+			<< std::setw(10) << phase.transfers.bytes_in
+			<< std::setw(9) << phase.polls.polls
+			<< std::setw(9) << (double)phase.polls.wait_time / 1000000
+			<< std::setw(10);
+		if (phase.payload && phase.time)
+			os << std::setprecision(1) << phase.payload / 1024.0 / time;
+		else
+			os << "-";
+		os << "\n";
+	}
+	os.unsetf(std::ios::fixed);
+	return os;
+}
@@ -0,0 +1,53 @@
+/*
+ * cc_stats.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_STATS_H_
+#define _CC_STATS_H_
+
+#include "programmer/cc_programmer.h"
+
+/// Per-phase statistics: wall time, USB transfers and time spent polling
+/// target status. Figures are taken as the difference of programmer counters
+/// between start and finish of each phase.
+class CC_Stats : boost::noncopyable
+{
+public:
+	struct Phase
+	{
+		String name;
+		uint64_t time; // us
+		size_t payload; // bytes, 0 if phase has no payload
+		USB_TransferStats transfers;
+		CC_PollStats polls;
+	};
+	typedef std::vector<Phase> PhaseVector;
+
+	/// Phase is recorded on finish, unfinished phases (e.g. failed with
+	/// exception) are not recorded
+	void start(const String &name);
+	void finish(size_t payload = 0);
+
+	const PhaseVector &phases() const;
+
+	CC_Stats(CC_Programmer &programmer);
+
+private:
+	CC_Programmer &programmer_;
+	PhaseVector phases_;
+	bool started_;
+	String start_name_;
+
+	uint64_t start_time_;
+	USB_TransferStats start_transfers_;
+	CC_PollStats start_polls_;
+};
+
+std::ostream& operator <<(std::ostream &os, const CC_Stats &o);
+
+#endif // !_CC_STATS_H_
@@ -0,0 +1,671 @@
+/*
+ * cc_tool_bench.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string/join.hpp>
+#include "common.h"
+#include "log.h"
+#include "trace.h"
+#include "version.h"
+#include "programmer/cc_programmer.h"
+#include "programmer/cc_simulator.h"
+#include "programmer/cc_tuner.h"
+#include "programmer/cc_profiler.h"
+#include "programmer/cc_latency.h"
+#include "data/flash_delta.h"
+
+namespace po = boost::program_options;
+
+struct BenchTarget
+{
+	const char *name;
+	uint_t ID;
+	uint_t flash_size; // in KB
+};
+
+// One target per driver code path
+const static BenchTarget TargetTable[] = {
+	{ "CC2530", 0x2530, 256 },	// CC253x, double-buffered DMA write
+	{ "CC2541", 0x2541, 256 },	// CC254x, 6-byte MAC
+	{ "CC2543", 0x2543, 32 },	// CC254x small, slow write
+	{ "CC2430", 0x2430, 128 },	// CC243x
+	{ "CC2510", 0x2510, 32 },	// CC251x/CC111x, no banking
+};
+
+enum Operation { OP_WRITE, OP_ERASE_WRITE, OP_VERIFY_CRC, OP_VERIFY_READ, OP_READ, OP_READ_STREAM,
+	OP_READ_INFO_PAGE, OP_READ_MAC, OP_PLAN_WRITE_VERIFY, OP_DELTA_UPDATE,
+	OP_READ_RANGE, OP_VERIFY_RANGE, OP_READ_TUNED, OP_VERIFY_CRC_BOOST, OP_PROFILE,
+	OP_LATENCY };
+enum ImageShape { IS_NONE, IS_FULL, IS_SPARSE };
+
+struct Scenario
+{
+	const char *name;
+	Operation operation;
+	ImageShape shape;
+};
+
+const static Scenario ScenarioTable[] = {
+	{ "write-full", 		OP_WRITE,			IS_FULL },
+	{ "write-sparse", 		OP_WRITE,			IS_SPARSE },
+	{ "erase-write-full",	OP_ERASE_WRITE,		IS_FULL },
+	{ "verify-crc-full",	OP_VERIFY_CRC,		IS_FULL },
+	{ "verify-crc-sparse",	OP_VERIFY_CRC,		IS_SPARSE },
+	{ "verify-crc-boost",	OP_VERIFY_CRC_BOOST, IS_FULL },
+	{ "verify-read-full",	OP_VERIFY_READ,		IS_FULL },
+	{ "verify-read-sparse",	OP_VERIFY_READ,		IS_SPARSE },
+	{ "plan-write-verify",	OP_PLAN_WRITE_VERIFY, IS_FULL },
+	{ "delta-update",		OP_DELTA_UPDATE,	IS_FULL },
+	{ "read",				OP_READ,			IS_NONE },
+	{ "read-stream",		OP_READ_STREAM,		IS_NONE },
+	{ "read-tuned",			OP_READ_TUNED,		IS_NONE },
+	{ "read-range",			OP_READ_RANGE,		IS_FULL },
+	{ "verify-range",		OP_VERIFY_RANGE,	IS_FULL },
+	{ "info-page",			OP_READ_INFO_PAGE,	IS_NONE },
+	{ "mac",				OP_READ_MAC,		IS_NONE },
+	{ "profile",			OP_PROFILE,			IS_NONE },
+	{ "latency",			OP_LATENCY,			IS_NONE },
+};
+
+struct BenchResult
+{
+	size_t payload;			// bytes
+	uint64_t modeled_time;	// us
+	uint64_t wall_time;		// us
+	uint64_t cpu_time;		// us, host only, simulator excluded
+	USB_TransferStats transfers;
+
+	BenchResult() : payload(0), modeled_time(0), wall_time(0), cpu_time(0) { }
+};
+
+//==============================================================================
+static uint64_t process_cpu_time()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+			usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+//==============================================================================
+static uint64_t wall_time()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//==============================================================================
+/// Deterministic image, so every run programs the same data
+static void create_image(ImageShape shape, size_t flash_size, DataSectionStore &image)
+{
+	uint32_t seed = 0x2530;
+	ByteVector data;
+
+	if (shape == IS_FULL)
+	{
+		data.resize(flash_size);
+		foreach (uint8_t &item, data)
+		{
+			seed = seed * 1103515245 + 12345;
+			item = (seed >> 16) & 0xFF;
+		}
+		image.add_section(DataSection(0, data), true);
+	}
+
+	// 8 small sections spread over the flash like bootloader, application
+	// fragments, calibration and serial number blocks
+	if (shape == IS_SPARSE)
+	{
+		const size_t SECTION_COUNT = 8;
+		const size_t SECTION_SIZE = 512;
+
+		for (size_t i = 0; i < SECTION_COUNT; i++)
+		{
+			data.resize(SECTION_SIZE);
+			foreach (uint8_t &item, data)
+			{
+				seed = seed * 1103515245 + 12345;
+				item = (seed >> 16) & 0xFF;
+			}
+			size_t address = i * (flash_size / SECTION_COUNT) + (i ? 0x100 : 0);
+			image.add_section(DataSection(address, data), true);
+		}
+	}
+}
+
+//==============================================================================
+static void check(bool condition, const String &message)
+{
+	if (!condition)
+		throw std::runtime_error(message);
+}
+
+/// Compares blocks streamed by flash read with the simulator flash
+class CheckSink : public DataSink
+{
+public:
+	virtual void write(size_t offset, const uint8_t data[], size_t size)
+	{
+		check(offset == begin_ + size_ && offset + size <= flash_.size() &&
+				std::equal(data, data + size, flash_.begin() + offset),
+				"streamed data mismatch");
+		size_ += size;
+	}
+
+	size_t size() const
+	{	return size_; }
+
+	CheckSink(const ByteVector &flash, size_t begin = 0) :
+			flash_(flash), begin_(begin), size_(0) { }
+
+private:
+	const ByteVector &flash_;
+	size_t begin_;
+	size_t size_;
+};
+
+//==============================================================================
+/// @return false if scenario is not applicable to the target
+static bool run_scenario(const BenchTarget &target, const Scenario &scenario,
+		const CC_Simulator::TimingModel &model, BenchResult &result)
+{
+	CC_Simulator simulator(target.ID, target.flash_size);
+	simulator.set_timing_model(model);
+
+	CC_Programmer programmer(simulator);
+	check(programmer.open() == CC_Programmer::OR_OK, "unable to open simulator");
+
+	programmer.set_clock_boost(scenario.operation == OP_VERIFY_CRC_BOOST);
+
+	UnitInfo unit_info;
+	check(programmer.unit_connect(unit_info), "unable to connect target");
+
+	if (scenario.operation == OP_VERIFY_CRC_BOOST && !programmer.unit_clock_boosted())
+		return false;
+
+	if (scenario.operation == OP_READ_INFO_PAGE &&
+			!(unit_info.flags & UnitInfo::SUPPORT_INFO_PAGE))
+		return false;
+
+	if (scenario.operation == OP_READ_MAC &&
+			!(unit_info.flags & UnitInfo::SUPPORT_MAC_ADDRESS))
+		return false;
+
+	DataSectionStore image;
+	create_image(scenario.shape, unit_info.actual_flash_size(), image);
+
+	if (scenario.shape != IS_NONE && scenario.operation != OP_ERASE_WRITE)
+	{
+		check(programmer.unit_erase(), "erase failed");
+		programmer.unit_connect(unit_info);
+	}
+	if (scenario.operation == OP_VERIFY_CRC || scenario.operation == OP_VERIFY_READ ||
+			scenario.operation == OP_VERIFY_CRC_BOOST ||
+			scenario.operation == OP_DELTA_UPDATE || scenario.operation == OP_VERIFY_RANGE ||
+			scenario.operation == OP_READ_RANGE)
+		programmer.unit_flash_write(image);
+
+	// last 4 KB of flash keep calibration data, MAC address and lock bits
+	const size_t RANGE_SIZE = 4096;
+	AddressRange range(unit_info.actual_flash_size() - RANGE_SIZE,
+			unit_info.actual_flash_size());
+	if (scenario.operation == OP_VERIFY_RANGE)
+		image.clip(range);
+
+	// unaligned, over several read blocks and across a flash bank if there is one
+	const size_t READ_RANGE_SIZE = 0x3000;
+	size_t read_begin = std::min(FLASH_BANK_SIZE,
+			unit_info.actual_flash_size() - READ_RANGE_SIZE) - 0x1000 + 0x33;
+	AddressRange read_range(read_begin, read_begin + READ_RANGE_SIZE);
+
+	// plan is compiled in advance as production run takes it ready
+	char plan_name[] = "/tmp/cc-tool-bench-XXXXXX";
+	if (scenario.operation == OP_PLAN_WRITE_VERIFY)
+	{
+		int fd = mkstemp(plan_name);
+		check(fd >= 0, "unable to create plan file");
+		close(fd);
+
+		FlashPlanHeader header;
+		memset(&header, 0, sizeof(header));
+		header.unit_id = unit_info.ID;
+		header.flash_size = unit_info.actual_flash_size();
+		header.block_size = programmer.unit_verify_block_size();
+		FlashPlan::save(plan_name, header, image);
+	}
+
+	// field update of 4 pages spread over the flash, the image becomes the
+	// updated one
+	if (scenario.operation == OP_DELTA_UPDATE)
+	{
+		const size_t CHANGED_PAGES = 4;
+		size_t page_size = unit_info.flash_page_size * 1024;
+
+		ByteVector data;
+		image.create_image(FLASH_EMPTY_BYTE, data);
+		for (size_t i = 0; i < CHANGED_PAGES; i++)
+			data[i * (data.size() / CHANGED_PAGES) + page_size + 0x11] ^= 0x5A;
+
+		DataSectionStore new_image;
+		new_image.add_section(DataSection(0, data), true);
+
+		PageChangeList changes;
+		image_page_changes(image, new_image, page_size, changes);
+		check(changes.size() == CHANGED_PAGES, "unexpected delta");
+
+		int fd = mkstemp(plan_name);
+		check(fd >= 0, "unable to create delta file");
+		close(fd);
+
+		FlashDelta::save(plan_name, new_image, page_size, changes);
+		image.swap(new_image);
+	}
+
+	// calibration is done once per debugger and target, not on every read
+	if (scenario.operation == OP_READ_TUNED)
+	{
+		CC_Tuning tuning;
+		CC_Tuner tuner(programmer, unit_info);
+		check(tuner.calibrate(tuning), "calibration failed");
+		tuner.apply(tuning);
+	}
+
+	// firmware: main calls process that calls crc16, rf_isr interrupts main
+	const size_t PROFILE_SAMPLES = 400;
+	SymbolMap symbols;
+	symbols.add(0x0100, 0x0200, "main");
+	symbols.add(0x0200, 0x0300, "process");
+	symbols.add(0x0300, 0x0340, "crc16");
+	symbols.add(0x0400, 0x0480, "rf_isr");
+	if (scenario.operation == OP_PROFILE)
+	{
+		const uint8_t MAIN_STACK[] = { 0x63, 0x01 };
+		const uint8_t PROCESS_STACK[] = { 0x63, 0x01, 0x33, 0x55, 0x02 };
+		const uint8_t ISR_STACK[] = { 0x70, 0x01, 0xE0, 0x00 };
+
+		CC_Simulator::CpuStateVector states(4);
+		states[0].pc = 0x0150;
+		states[0].weight = 2;
+		states[1].pc = 0x0240;
+		states[1].stack.assign(MAIN_STACK, MAIN_STACK + sizeof(MAIN_STACK));
+		states[1].weight = 3;
+		states[2].pc = 0x0310;
+		states[2].stack.assign(PROCESS_STACK, PROCESS_STACK + sizeof(PROCESS_STACK));
+		states[2].weight = 4;
+		states[3].pc = 0x0420;
+		states[3].stack.assign(ISR_STACK, ISR_STACK + sizeof(ISR_STACK));
+		states[3].weight = 1;
+		for (size_t i = 0; i < states.size(); i++)
+			states[i].bank = 1;
+		simulator.set_cpu_states(states);
+	}
+	CC_Profiler profiler(programmer, symbols);
+
+	// firmware calls crc16 over and over, runs take different time
+	const uint_t CRC_CYCLES[] = { 120, 250, 90, 4000, 700 };
+	const size_t LATENCY_RUNS = 50;
+	if (scenario.operation == OP_LATENCY)
+	{
+		CC_Simulator::CallModel model;
+		model.entry = 0x0300;
+		model.exit = 0x033F;
+		model.durations.assign(CRC_CYCLES, CRC_CYCLES + ARRAY_SIZE(CRC_CYCLES));
+		model.idle_cycles = 5000;
+		simulator.set_call_model(model);
+	}
+	CC_LatencyMeter meter(programmer);
+
+	programmer.reset_transfer_stats();
+	uint64_t start_wall = wall_time();
+	uint64_t start_cpu = process_cpu_time();
+	uint64_t start_simulator_cpu = simulator.cpu_time();
+	uint64_t start_charged = simulator.charged_time();
+
+	TraceScope trace(scenario.name, "bench");
+
+	ByteVector data;
+	switch (scenario.operation)
+	{
+	case OP_WRITE:
+		programmer.unit_flash_write(image);
+		result.payload = image.actual_size();
+		break;
+
+	case OP_ERASE_WRITE:
+		// the same sequence as cc-tool does for --erase --write
+		programmer.unit_erase_start();
+		programmer.unit_flash_write_prepare(image);
+		check(programmer.unit_erase_wait(), "erase failed");
+		programmer.unit_connect(unit_info);
+		programmer.unit_flash_write(image);
+		result.payload = image.actual_size();
+		break;
+
+	case OP_VERIFY_CRC:
+	case OP_VERIFY_CRC_BOOST:
+		check(programmer.unit_flash_verify(image, CC_Programmer::VM_BY_CRC),
+				"verification by CRC failed");
+		result.payload = image.actual_size();
+		break;
+
+	case OP_VERIFY_READ:
+		check(programmer.unit_flash_verify(image, CC_Programmer::VM_BY_READ),
+				"verification by read failed");
+		result.payload = image.actual_size();
+		break;
+
+	case OP_READ:
+		programmer.unit_flash_read(data);
+		check(data == simulator.flash(), "read data mismatch");
+		result.payload = data.size();
+		break;
+
+	case OP_READ_STREAM:
+	case OP_READ_TUNED:
+	{
+		CheckSink sink(simulator.flash());
+		programmer.unit_flash_read(sink);
+		check(sink.size() == simulator.flash().size(), "streamed size mismatch");
+		result.payload = sink.size();
+		break;
+	}
+
+	case OP_READ_RANGE:
+	{
+		CheckSink sink(simulator.flash(), read_range.begin);
+		programmer.unit_flash_read(read_range, sink);
+		check(sink.size() == READ_RANGE_SIZE, "read range size mismatch");
+		result.payload = sink.size();
+		break;
+	}
+
+	case OP_VERIFY_RANGE:
+		check(programmer.unit_flash_verify(image, CC_Programmer::VM_BY_CRC),
+				"verification of range failed");
+		result.payload = image.actual_size();
+		break;
+
+	case OP_READ_INFO_PAGE:
+		programmer.unit_read_info_page(data);
+		result.payload = data.size();
+		break;
+
+	case OP_READ_MAC:
+		for (size_t i = 0; i < unit_info.mac_address_count; i++)
+		{
+			ByteVector mac;
+			programmer.unit_mac_address_read(i, mac);
+			result.payload += mac.size();
+		}
+		break;
+
+	case OP_PLAN_WRITE_VERIFY:
+	{
+		FlashPlan plan;
+		plan.open(plan_name);
+		unlink(plan_name);
+
+		DataSectionStore plan_image;
+		FlashBlockCrcList crcs;
+		plan.get_sections(plan_image);
+		plan.get_block_crcs(crcs);
+
+		programmer.unit_flash_write(plan_image);
+		check(programmer.unit_flash_verify(crcs), "verification by plan failed");
+		result.payload = plan_image.actual_size();
+		break;
+	}
+
+	case OP_DELTA_UPDATE:
+	{
+		// the same sequence as cc-tool does for --apply-delta
+		FlashDelta delta;
+		delta.open(plan_name);
+		unlink(plan_name);
+
+		size_t page_size = delta.header().page_size;
+		FlashBlockCrcList pages(delta.page_count());
+		for (size_t i = 0; i < pages.size(); i++)
+		{
+			pages[i].address = delta.page(i).address;
+			pages[i].size = page_size;
+		}
+		programmer.unit_flash_crc(pages);
+
+		DataSectionStore sections;
+		for (size_t i = 0; i < pages.size(); i++)
+		{
+			check(pages[i].crc == delta.page(i).old_crc, "base image mismatch");
+			check(programmer.unit_erase_page(pages[i].address), "page erase failed");
+
+			sections.add_section(DataSection(pages[i].address, delta.page_data(i),
+					page_size), false);
+			pages[i].crc = delta.page(i).new_crc;
+		}
+		programmer.unit_flash_write(sections);
+		check(programmer.unit_flash_verify(pages), "verification by delta failed");
+		result.payload = sections.actual_size();
+		break;
+	}
+
+	case OP_PROFILE:
+	{
+		profiler.run(0, PROFILE_SAMPLES, true);
+
+		std::vector<CC_ProfileStack> stacks;
+		profiler.stacks(stacks);
+		size_t crc_samples = 0;
+		foreach (const CC_ProfileStack &stack, stacks)
+		{
+			String folded = boost::algorithm::join(stack, ";");
+			check(folded == "main" || folded == "main;process" ||
+					folded == "main;process;crc16" || folded == "main;rf_isr",
+					"unexpected stack " + folded);
+			crc_samples += stack.back() == "crc16";
+		}
+		check(crc_samples > PROFILE_SAMPLES / 4 && crc_samples < PROFILE_SAMPLES / 2,
+				"unexpected profile");
+		result.payload = profiler.sample_count() * 2; // PC bytes
+		break;
+	}
+
+	case OP_LATENCY:
+	{
+		meter.start_timer(1);
+		check(meter.run(0x0300, 0x033F, LATENCY_RUNS, 1000000), "breakpoint timeout");
+
+		const UintVector &latencies = meter.latencies();
+		check(latencies.size() == LATENCY_RUNS, "unexpected run count");
+		for (size_t i = 0; i < latencies.size(); i++)
+			check(latencies[i] == CRC_CYCLES[i % ARRAY_SIZE(CRC_CYCLES)],
+					"unexpected latency " + number_to_string(latencies[i]));
+		result.payload = latencies.size() * 2 * 4; // PC and timer per hit
+		break;
+	}
+	}
+
+	result.wall_time = wall_time() - start_wall;
+	result.modeled_time = result.wall_time + simulator.charged_time() - start_charged;
+	result.cpu_time = process_cpu_time() - start_cpu -
+			(simulator.cpu_time() - start_simulator_cpu);
+	result.transfers = programmer.transfer_stats();
+
+	if (scenario.operation == OP_WRITE || scenario.operation == OP_ERASE_WRITE ||
+			scenario.operation == OP_PLAN_WRITE_VERIFY ||
+			scenario.operation == OP_DELTA_UPDATE)
+	{
+		ByteVector flash_image;
+		image.create_image(FLASH_EMPTY_BYTE, flash_image);
+		check(std::equal(flash_image.begin(), flash_image.end(),
+				simulator.flash().begin()), "written data mismatch");
+	}
+	return result.payload != 0;
+}
+
+//==============================================================================
+static bool less_modeled_time(const BenchResult &r1, const BenchResult &r2)
+{	return r1.modeled_time < r2.modeled_time; }
+
+//==============================================================================
+static void print_header(std::ostream &out)
+{
+	out << "target,scenario,payload_bytes,modeled_s,kb_per_s,usb_transactions,"
+		"transactions_per_kb,bytes_out,bytes_in,wire_bytes_per_payload_byte,"
+		"wall_s,host_cpu_s\n";
+}
+
+//==============================================================================
+static void print_result(std::ostream &out, const BenchTarget &target,
+		const Scenario &scenario, const BenchResult &result)
+{
+	double kb = (double)result.payload / 1024;
+	double modeled = (double)result.modeled_time / 1000000;
+	uint64_t wire = result.transfers.bytes_in + result.transfers.bytes_out;
+
+	out << target.name << "," << scenario.name << ","
+		<< result.payload << ","
+		<< std::fixed << std::setprecision(6) << modeled << ","
+		<< std::setprecision(3) << (modeled ? kb / modeled : 0) << ","
+		<< result.transfers.transactions() << ","
+		<< (double)result.transfers.transactions() / kb << ","
+		<< result.transfers.bytes_out << ","
+		<< result.transfers.bytes_in << ","
+		<< (double)wire / result.payload << ","
+		<< std::setprecision(6) << (double)result.wall_time / 1000000 << ","
+		<< (double)result.cpu_time / 1000000 << "\n";
+	out.flush();
+}
+
+//==============================================================================
+static bool selected(const StringVector &list, const String &name)
+{
+	return list.empty() || std::find(list.begin(), list.end(), name) != list.end();
+}
+
+//==============================================================================
+int main(int argc, char **argv)
+{
+	StringVector targets, scenarios;
+	String output, log_name, trace_name;
+	uint_t repeat = 3;
+	CC_Simulator::TimingModel model;
+
+	po::options_description desc;
+	desc.add_options()
+		("help,h", "produce help message")
+		("target,t", po::value<StringVector>(&targets), "run only for the target, e.g. CC2530")
+		("scenario,s", po::value<StringVector>(&scenarios), "run only the scenario, e.g. write-full")
+		("repeat,n", po::value<uint_t>(&repeat), "number of runs per scenario, median is reported (default: 3)")
+		("transaction-time", po::value<uint_t>(&model.transaction_time),
+				"modeled time of one USB transfer, us")
+		("byte-time", po::value<uint_t>(&model.byte_time),
+				"modeled time of one transfered byte, ns")
+		("output,o", po::value<String>(&output), "write results to the file instead of stdout")
+		("log", po::value<String>(&log_name), "create log of all operations")
+		("trace", po::value<String>(&trace_name), "write timeline in Chrome trace event format");
+
+	try
+	{
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+
+		if (vm.count("help"))
+		{
+			std::cout << MODULE_NAME << " benchmark, runs programmer operations "
+					"against simulated CC Debugger\n";
+			std::cout << "\n Command line options:\n" << desc;
+			std::cout << "\n Targets:";
+			foreach (const BenchTarget &target, TargetTable)
+				std::cout << " " << target.name;
+			std::cout << "\n Scenarios:";
+			foreach (const Scenario &scenario, ScenarioTable)
+				std::cout << " " << scenario.name;
+			std::cout << "\n";
+			return EXIT_SUCCESS;
+		}
+		if (!repeat)
+			throw po::error("repeat must be positive");
+	}
+	catch (po::error &e)
+	{
+		std::cout << "  Bad command line options (" << e.what() << ")\n";
+		return EXIT_FAILURE;
+	}
+
+	if (!log_name.empty())
+		log_get().set_log_file(log_name);
+	if (!trace_name.empty())
+	{
+		try
+		{
+			trace_get().set_trace_file(trace_name);
+		}
+		catch (FileException &e)
+		{
+			std::cout << "  " << e.what() << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::ofstream file;
+	if (!output.empty())
+	{
+		file.open(output.c_str());
+		if (!file)
+		{
+			std::cout << "  Unable to open file " << output << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream &out = output.empty() ? std::cout : file;
+
+	bool success = true;
+	print_header(out);
+
+	foreach (const BenchTarget &target, TargetTable)
+	{
+		if (!selected(targets, target.name))
+			continue;
+
+		foreach (const Scenario &scenario, ScenarioTable)
+		{
+			if (!selected(scenarios, scenario.name))
+				continue;
+
+			try
+			{
+				std::vector<BenchResult> results;
+				for (uint_t i = 0; i < repeat; i++)
+				{
+					BenchResult result;
+					if (!run_scenario(target, scenario, model, result))
+						break;
+					results.push_back(result);
+				}
+				if (results.empty())
+					continue;
+
+				std::sort(results.begin(), results.end(), less_modeled_time);
+				print_result(out, target, scenario, results[results.size() / 2]);
+			}
+			catch (std::runtime_error &e)
+			{
+				std::cerr << target.name << ", " << scenario.name << ": "
+						<< e.what() << "\n";
+				success = false;
+			}
+		}
+	}
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,659 @@
+/*
+ * data_bench.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <new>
+#include <fstream>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include "common.h"
+#include "version.h"
+#include "data/hex_file.h"
+#include "data/data_section_store.h"
+#include "data/data_block_view.h"
+#include "data/image_cache.h"
+
+namespace po = boost::program_options;
+
+#if __cplusplus >= 201103L
+#define THROW_BAD_ALLOC
+#define THROW_NOTHING noexcept
+#else
+#define THROW_BAD_ALLOC throw (std::bad_alloc)
+#define THROW_NOTHING throw()
+#endif
+
+// Kept out of line: free() inlined at a new expression is reported by
+// -Wmismatched-new-delete
+#define NOINLINE __attribute__((noinline))
+
+// Allocation statistics, collected by the replaced global operator new
+static size_t allocation_count = 0;
+static size_t allocation_size = 0;
+
+//==============================================================================
+void* operator new(size_t size) THROW_BAD_ALLOC
+{
+	allocation_count++;
+	allocation_size += size;
+
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+//==============================================================================
+void* operator new[](size_t size) THROW_BAD_ALLOC
+{	return operator new(size); }
+
+//==============================================================================
+NOINLINE void operator delete(void *p) THROW_NOTHING
+{	free(p); }
+
+//==============================================================================
+NOINLINE void operator delete[](void *p) THROW_NOTHING
+{	free(p); }
+
+//==============================================================================
+void operator delete(void *p, size_t) THROW_NOTHING
+{	operator delete(p); }
+
+//==============================================================================
+void operator delete[](void *p, size_t) THROW_NOTHING
+{	operator delete[](p); }
+
+struct BenchInput
+{
+	size_t image_size;		// bytes, contiguous image
+	size_t section_count;	// number of fragmented sections
+
+	DataSectionStore contiguous;
+	DataSectionStore fragmented;
+	std::vector<DataSection> overlapping;
+	String contiguous_hex;	// file names
+	String fragmented_hex;
+	String output_hex;
+	String cache_directory;
+	ByteVector image;
+};
+
+struct BenchResult
+{
+	size_t input_size;		// bytes processed by one iteration
+	uint64_t time;			// ns
+	size_t allocations;
+	size_t allocated_size;
+	size_t checksum;		// keeps the work from being optimized away
+
+	BenchResult() : input_size(0), time(0), allocations(0), allocated_size(0),
+			checksum(0) { }
+};
+
+typedef void (*BenchProc)(BenchInput &input, BenchResult &result);
+
+struct Benchmark
+{
+	const char *name;
+	BenchProc proc;
+};
+
+static uint32_t random_seed = 0x2530;
+
+//==============================================================================
+static uint32_t random_next()
+{
+	random_seed = random_seed * 1103515245 + 12345;
+	return (random_seed >> 16) & 0x7FFF;
+}
+
+//==============================================================================
+static void random_fill(ByteVector &data, size_t size)
+{
+	data.resize(size);
+	foreach (uint8_t &item, data)
+		item = random_next() & 0xFF;
+}
+
+//==============================================================================
+static uint64_t monotonic_time()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//==============================================================================
+static off_t file_size(const String &file_name)
+{
+	std::ifstream in(file_name.c_str(), std::ios::binary | std::ios::ate);
+	return in.tellg();
+}
+
+//==============================================================================
+static String temp_file_name(const char name[])
+{
+	String file_name = String(P_tmpdir) + "/" + name + "XXXXXX";
+
+	std::vector<char> buffer(file_name.begin(), file_name.end());
+	buffer.push_back('\0');
+
+	int fd = mkstemp(&buffer[0]);
+	if (fd < 0)
+		throw std::runtime_error("Unable to create temporary file " + file_name);
+	close(fd);
+	return &buffer[0];
+}
+
+//==============================================================================
+/// Prepare all inputs once, so iterations measure the same work
+static void create_input(BenchInput &input)
+{
+	ByteVector data;
+
+	random_fill(data, input.image_size);
+	input.contiguous.add_section(DataSection(0, data), false);
+
+	// Small sections of 16..271 bytes separated by gaps, in ascending order
+	// like a linker spreads them
+	size_t address = 0;
+	for (size_t i = 0; i < input.section_count; i++)
+	{
+		random_fill(data, 16 + random_next() % 256);
+		input.fragmented.add_section(DataSection(address, data), false);
+		address += data.size() + 1 + random_next() % 64;
+	}
+
+	// Randomly placed sections heavily overlapping each other across the image
+	for (size_t i = 0; i < input.section_count; i++)
+	{
+		random_fill(data, 16 + random_next() % 1024);
+		size_t max_address = input.image_size - data.size();
+		size_t address = ((random_next() << 15) | random_next()) % max_address;
+		input.overlapping.push_back(DataSection(address, data));
+	}
+
+	input.contiguous_hex = temp_file_name("cc-tool-bench-contiguous");
+	input.fragmented_hex = temp_file_name("cc-tool-bench-fragmented");
+	input.output_hex = temp_file_name("cc-tool-bench-output");
+
+	hex_file_save(input.contiguous_hex, input.contiguous);
+	hex_file_save(input.fragmented_hex, input.fragmented);
+	input.fragmented.create_image(0xFF, input.image);
+
+	char cache_directory[] = P_tmpdir "/cc-tool-bench-cacheXXXXXX";
+	if (!mkdtemp(cache_directory))
+		throw std::runtime_error("Unable to create temporary directory");
+	input.cache_directory = cache_directory;
+}
+
+//==============================================================================
+static void remove_input(BenchInput &input)
+{
+	unlink(input.contiguous_hex.c_str());
+	unlink(input.fragmented_hex.c_str());
+	unlink(input.output_hex.c_str());
+	boost::filesystem::remove_all(input.cache_directory);
+}
+
+//==============================================================================
+static bool same_sections(const DataSectionStore &store1, const DataSectionStore &store2)
+{
+	const DataSectionList &sections1 = store1.sections();
+	const DataSectionList &sections2 = store2.sections();
+
+	if (sections1.size() != sections2.size())
+		return false;
+
+	for (size_t i = 0; i < sections1.size(); i++)
+		if (sections1[i].address != sections2[i].address ||
+				sections1[i].data != sections2[i].data)
+			return false;
+	return true;
+}
+
+//==============================================================================
+static void check_hex_file(const String &file_name, const DataSectionStore &expected)
+{
+	DataSectionStore store;
+	hex_file_load(file_name, store);
+
+	if (!same_sections(store, expected))
+		throw std::runtime_error("hex file " + file_name +
+				" differs from the source image");
+}
+
+//==============================================================================
+static void write_text(const String &file_name, const char text[])
+{
+	std::ofstream out(file_name.c_str(), std::ios::binary);
+	out << text;
+	if (!out)
+		throw std::runtime_error("Unable to write file " + file_name);
+}
+
+struct HexRejectCase
+{
+	const char *name;
+	const char *text;
+	const char *error;	// part of the expected load error message
+};
+
+const static HexRejectCase HexRejectTable[] = {
+	{ "checksum mismatch",
+		":0400000001020304F1\r\n:00000001FF\r\n", "CRC mismatch" },
+	{ "bad character",
+		":04000000010G0304F2\r\n:00000001FF\r\n", "Unexpected character" },
+	{ "overlapping records",
+		":0400000001020304F2\r\n:0400020001020304F0\r\n:00000001FF\r\n",
+		"Sections overlapped" },
+	{ "segment address record with address",
+		":020001021000EB\r\n:0400000001020304F2\r\n:00000001FF\r\n",
+		"Record format error" },
+	{ "segment address record of one byte",
+		":0100000210ED\r\n:0400000001020304F2\r\n:00000001FF\r\n",
+		"Record format error" },
+};
+
+//==============================================================================
+/// Parsed hex files must match their source stores byte for byte and malformed
+/// files must be rejected, benchmarks measure the same parser afterwards
+static void check_hex_load(BenchInput &input)
+{
+	check_hex_file(input.contiguous_hex, input.contiguous);
+	check_hex_file(input.fragmented_hex, input.fragmented);
+
+	// data record placed by an extended segment address record (0x1000 << 4)
+	const uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+	DataSectionStore segment_data;
+	segment_data.add_section(DataSection(0x10000, data, ARRAY_SIZE(data)), false);
+
+	write_text(input.output_hex,
+			":020000021000EC\r\n:0400000001020304F2\r\n:00000001FF\r\n");
+	check_hex_file(input.output_hex, segment_data);
+
+	foreach (const HexRejectCase &item, HexRejectTable)
+	{
+		write_text(input.output_hex, item.text);
+
+		String error;
+		try
+		{
+			DataSectionStore store;
+			hex_file_load(input.output_hex, store);
+		}
+		catch (FileException &e)
+		{
+			error = e.what();
+		}
+		if (error.find(item.error) == String::npos)
+			throw std::runtime_error(String("hex file with ") + item.name +
+					" is not rejected as expected" +
+					(error.empty() ? String() : ": " + error));
+	}
+}
+
+//==============================================================================
+/// Data records must not cross a 64 KB segment, the next segment is
+/// addressed by an extended linear address record
+static void check_hex_records(const String &file_name, size_t record_size)
+{
+	std::ifstream in(file_name.c_str());
+	String line;
+	while (std::getline(in, line))
+	{
+		if (line.size() < 9 || line.substr(7, 2) != "00")
+			continue;
+
+		size_t size = strtoul(line.substr(1, 2).c_str(), NULL, 16);
+		size_t address = strtoul(line.substr(3, 4).c_str(), NULL, 16);
+		if (size > record_size || address + size > 0x10000)
+			throw std::runtime_error("hex file " + file_name +
+					" has a bad data record " + line);
+	}
+}
+
+//==============================================================================
+static void check_hex_round_trip(const String &file_name,
+		const DataSectionStore &store, size_t record_size)
+{
+	hex_file_save(file_name, store, record_size);
+	check_hex_records(file_name, record_size);
+	check_hex_file(file_name, store);
+}
+
+//==============================================================================
+/// Saved hex files must load back to the same data: records split at 64 KB
+/// segments, the longest records and records continued by several writes
+static void check_hex_save(BenchInput &input)
+{
+	check_hex_round_trip(input.output_hex, input.contiguous, HEX_RECORD_SIZE);
+	check_hex_round_trip(input.output_hex, input.fragmented, 255);
+
+	// sections crossing segment boundaries and ending right at them
+	ByteVector data;
+	DataSectionStore segments;
+	random_fill(data, 0x40);
+	segments.add_section(DataSection(0xFFE5, data), false);
+	random_fill(data, 2);
+	segments.add_section(DataSection(0x1FFFF, data), false);
+	random_fill(data, 0x10000 + 300);
+	segments.add_section(DataSection(0x20000 - 7, data), false);
+
+	check_hex_round_trip(input.output_hex, segments, HEX_RECORD_SIZE);
+	check_hex_round_trip(input.output_hex, segments, 255);
+	check_hex_round_trip(input.output_hex, segments, 1);
+
+	// blocks of random size, each continues the record left by the previous
+	// one, smallest text buffer
+	DataSectionStore blocks;
+	random_fill(data, 0x1000);
+	blocks.add_section(DataSection(0xF800, data), false);
+	random_fill(data, 100);
+	blocks.add_section(DataSection(0x20005, data), false);
+
+	File file;
+	file.open(input.output_hex, "wb");
+	HexWriter writer(file, 16, 0);
+	foreach (const DataSection &section, blocks.sections())
+	{
+		for (size_t offset = 0; offset < section.size(); )
+		{
+			size_t count = std::min<size_t>(1 + random_next() % 40,
+					section.size() - offset);
+			writer.write(section.address + offset, &section.data[offset], count);
+			offset += count;
+		}
+	}
+	writer.finish();
+	file.close();
+
+	check_hex_records(input.output_hex, 16);
+	check_hex_file(input.output_hex, blocks);
+}
+
+//==============================================================================
+static void bench_hex_load_contiguous(BenchInput &input, BenchResult &result)
+{
+	DataSectionStore store;
+	hex_file_load(input.contiguous_hex, store);
+
+	result.input_size = file_size(input.contiguous_hex);
+	result.checksum = store.actual_size();
+}
+
+//==============================================================================
+static void bench_hex_load_fragmented(BenchInput &input, BenchResult &result)
+{
+	DataSectionStore store;
+	hex_file_load(input.fragmented_hex, store);
+
+	result.input_size = file_size(input.fragmented_hex);
+	result.checksum = store.sections().size();
+}
+
+//==============================================================================
+/// Hex file taken from the cache filled by the first iteration, with CRCs
+/// of the two verify block sizes
+static void bench_hex_load_cached(BenchInput &input, BenchResult &result)
+{
+	UintVector block_sizes;
+	block_sizes.push_back(512);
+	block_sizes.push_back(1024);
+
+	ImageCache cache;
+	cache.set_directory(input.cache_directory);
+	cache.set_crc_blocks(block_sizes, 32 * 1024);
+
+	DataSectionStore store;
+	FlashBlockCrcMap crcs;
+	cache.hex_file_load(input.fragmented_hex, store, crcs);
+
+	result.input_size = file_size(input.fragmented_hex);
+	result.checksum = store.sections().size() + crcs[1024].size();
+}
+
+//==============================================================================
+static void bench_hex_save_contiguous(BenchInput &input, BenchResult &result)
+{
+	hex_file_save(input.output_hex, input.contiguous);
+	result.input_size = input.contiguous.actual_size();
+}
+
+//==============================================================================
+static void bench_hex_save_fragmented(BenchInput &input, BenchResult &result)
+{
+	hex_file_save(input.output_hex, input.fragmented);
+	result.input_size = input.fragmented.actual_size();
+}
+
+//==============================================================================
+static void bench_store_add_fragmented(BenchInput &input, BenchResult &result)
+{
+	DataSectionStore store;
+	foreach (const DataSection &section, input.fragmented.sections())
+		store.add_section(section, false);
+
+	result.input_size = input.fragmented.actual_size();
+	result.checksum = store.sections().size();
+}
+
+//==============================================================================
+static void bench_store_merge_overlapping(BenchInput &input, BenchResult &result)
+{
+	DataSectionStore store;
+	foreach (const DataSection &section, input.overlapping)
+	{
+		store.add_section(section, true);
+		result.input_size += section.size();
+	}
+	result.checksum = store.actual_size();
+}
+
+//==============================================================================
+static void bench_store_create_image(BenchInput &input, BenchResult &result)
+{
+	ByteVector image;
+	input.fragmented.create_image(0xFF, image);
+
+	result.input_size = image.size();
+	result.checksum = image.size();
+}
+
+//==============================================================================
+static void bench_store_block_view(BenchInput &input, BenchResult &result)
+{
+	const size_t BLOCK_SIZE = 1024;
+
+	DataBlockView view;
+	view.reset(input.fragmented, BLOCK_SIZE, 0xFF);
+
+	for (size_t i = 0; i < view.block_count(); i++)
+		if (view.block_used(i))
+			result.checksum += view.block(i)[0];
+
+	result.input_size = view.block_count() * BLOCK_SIZE;
+}
+
+//==============================================================================
+static void bench_crc_blocks(BenchInput &input, BenchResult &result)
+{
+	const size_t BLOCK_SIZE = 1024;
+
+	for (size_t offset = 0; offset < input.image.size(); offset += BLOCK_SIZE)
+	{
+		size_t count = std::min(BLOCK_SIZE, input.image.size() - offset);
+
+		CrcCalculator crc_calc;
+		crc_calc.process_bytes(&input.image[offset], count);
+		result.checksum += crc_calc.checksum();
+	}
+	result.input_size = input.image.size();
+}
+
+const static Benchmark BenchmarkTable[] = {
+	{ "hex-load-contiguous",	bench_hex_load_contiguous },
+	{ "hex-load-fragmented",	bench_hex_load_fragmented },
+	{ "hex-load-cached",		bench_hex_load_cached },
+	{ "hex-save-contiguous",	bench_hex_save_contiguous },
+	{ "hex-save-fragmented",	bench_hex_save_fragmented },
+	{ "store-add-fragmented",	bench_store_add_fragmented },
+	{ "store-merge-overlapping",bench_store_merge_overlapping },
+	{ "store-create-image",		bench_store_create_image },
+	{ "store-block-view",		bench_store_block_view },
+	{ "crc-blocks",				bench_crc_blocks },
+};
+
+//==============================================================================
+static void run_benchmark(const Benchmark &benchmark, BenchInput &input,
+		BenchResult &result)
+{
+	allocation_count = 0;
+	allocation_size = 0;
+
+	uint64_t start = monotonic_time();
+	benchmark.proc(input, result);
+	result.time = monotonic_time() - start;
+
+	result.allocations = allocation_count;
+	result.allocated_size = allocation_size;
+}
+
+//==============================================================================
+static bool less_time(const BenchResult &r1, const BenchResult &r2)
+{	return r1.time < r2.time; }
+
+//==============================================================================
+static void print_header(std::ostream &out)
+{
+	out << "benchmark,input_bytes,repeat,median_s,min_s,mb_per_s,"
+		"allocations,allocated_bytes\n";
+}
+
+//==============================================================================
+static void print_result(std::ostream &out, const Benchmark &benchmark,
+		std::vector<BenchResult> &results)
+{
+	std::sort(results.begin(), results.end(), less_time);
+	const BenchResult &median = results[results.size() / 2];
+
+	double time = (double)median.time / 1000000000;
+	double mb = (double)median.input_size / (1024 * 1024);
+
+	out << benchmark.name << ","
+		<< median.input_size << ","
+		<< results.size() << ","
+		<< std::fixed << std::setprecision(6) << time << ","
+		<< (double)results.front().time / 1000000000 << ","
+		<< std::setprecision(3) << (time ? mb / time : 0) << ","
+		<< median.allocations << ","
+		<< median.allocated_size << "\n";
+	out.flush();
+}
+
+//==============================================================================
+static bool selected(const StringVector &list, const String &name)
+{
+	return list.empty() || std::find(list.begin(), list.end(), name) != list.end();
+}
+
+//==============================================================================
+int main(int argc, char **argv)
+{
+	StringVector benchmarks;
+	String output;
+	uint_t repeat = 5;
+	uint_t image_size = 1024;
+	uint_t section_count = 4096;
+
+	po::options_description desc;
+	desc.add_options()
+		("help,h", "produce help message")
+		("benchmark,b", po::value<StringVector>(&benchmarks), "run only the benchmark, e.g. hex-load-contiguous")
+		("repeat,n", po::value<uint_t>(&repeat), "number of runs per benchmark, median is reported (default: 5)")
+		("size", po::value<uint_t>(&image_size), "contiguous image size in KB, up to 1024 (default: 1024)")
+		("sections", po::value<uint_t>(&section_count), "number of fragmented and overlapping sections (default: 4096)")
+		("output,o", po::value<String>(&output), "write results to the file instead of stdout");
+
+	try
+	{
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+
+		if (vm.count("help"))
+		{
+			std::cout << MODULE_NAME << " data layer benchmark, measures hex file "
+					"load/save, section store and CRC on synthetic images\n";
+			std::cout << "\n Command line options:\n" << desc;
+			std::cout << "\n Benchmarks:";
+			foreach (const Benchmark &benchmark, BenchmarkTable)
+				std::cout << " " << benchmark.name;
+			std::cout << "\n";
+			return EXIT_SUCCESS;
+		}
+		if (!repeat)
+			throw po::error("repeat must be positive");
+		// hex files are saved with extended segment address records
+		if (!image_size || image_size > 1024)
+			throw po::error("size must be in range 1..1024");
+		if (!section_count)
+			throw po::error("sections must be positive");
+	}
+	catch (po::error &e)
+	{
+		std::cout << "  Bad command line options (" << e.what() << ")\n";
+		return EXIT_FAILURE;
+	}
+
+	std::ofstream file;
+	if (!output.empty())
+	{
+		file.open(output.c_str());
+		if (!file)
+		{
+			std::cout << "  Unable to open file " << output << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream &out = output.empty() ? std::cout : file;
+
+	BenchInput input;
+	input.image_size = image_size * 1024;
+	input.section_count = section_count;
+
+	bool success = true;
+	try
+	{
+		create_input(input);
+		check_hex_load(input);
+		check_hex_save(input);
+		print_header(out);
+
+		foreach (const Benchmark &benchmark, BenchmarkTable)
+		{
+			if (!selected(benchmarks, benchmark.name))
+				continue;
+
+			std::vector<BenchResult> results(repeat);
+			foreach (BenchResult &result, results)
+				run_benchmark(benchmark, input, result);
+
+			print_result(out, benchmark, results);
+		}
+	}
+	catch (std::runtime_error &e)
+	{
+		std::cerr << "  Error occured: " << e.what() << "\n";
+		success = false;
+	}
+	remove_input(input);
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -66,6 +66,14 @@ uint_t get_tick_count()
     return (tv.tv_sec * 1000 + tv.tv_usec / 1000);
 }
 
+//==============================================================================
+uint64_t get_monotonic_time()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 //==============================================================================
 String convinient_storage_size(off_t size)
 {
@@ -44,6 +44,7 @@ typedef std::vector<uint_t> 	UintVector;
 
 String 	convinient_storage_size(off_t size);
 uint_t 	get_tick_count();
+uint64_t get_monotonic_time(); // us, not affected by system time changes
 String 	binary_to_hex(const uint8_t data[], size_t size, const char delimiter[] = "");
 String 	binary_to_hex(const ByteVector &data, const char delimiter[] = "");
 void 	vector_append(ByteVector &vector, const uint8_t data[], size_t size);
@@ -0,0 +1,115 @@
+/*
+ * trace.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <unistd.h>
+#include "data/file.h"
+#include "trace.h"
+
+//==============================================================================
+Trace::Trace() :
+	file_(NULL),
+	start_time_(0),
+	first_event_(true)
+{ }
+
+//==============================================================================
+Trace::~Trace()
+{
+	if (file_)
+	{
+		fprintf(file_, "\n]\n");
+		fclose(file_);
+	}
+}
+
+//==============================================================================
+void Trace::set_trace_file(const String &file_name)
+{
+	if (file_)
+		fclose(file_);
+	file_ = fopen(file_name.c_str(), "w");
+	if (!file_)
+		throw FileException("Trace::set_trace_file failed, file name: " +
+				file_name + ": " + strerror(errno));
+
+	start_time_ = get_monotonic_time();
+	first_event_ = true;
+	fprintf(file_, "[");
+}
+
+//==============================================================================
+bool Trace::enabled() const
+{	return file_ != NULL; }
+
+//==============================================================================
+void Trace::add_event(const char name[], const char category[], char phase)
+{
+	fprintf(file_, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+			"\"ts\":%llu,\"pid\":%d,\"tid\":1",
+			first_event_ ? "" : ",", name, category, phase,
+			(unsigned long long)(get_monotonic_time() - start_time_), getpid());
+	first_event_ = false;
+}
+
+//==============================================================================
+void Trace::begin(const char name[], const char category[],
+		const char arg_name[], uint64_t arg_value)
+{
+	if (!file_)
+		return;
+
+	add_event(name, category, 'B');
+	if (arg_name)
+		fprintf(file_, ",\"args\":{\"%s\":%llu}", arg_name,
+				(unsigned long long)arg_value);
+	fprintf(file_, "}");
+}
+
+//==============================================================================
+void Trace::end()
+{
+	if (!file_)
+		return;
+
+	add_event("", "", 'E');
+	fprintf(file_, "}");
+}
+
+//==============================================================================
+void Trace::counter(const char name[], double value)
+{
+	if (!file_)
+		return;
+
+	add_event(name, "counter", 'C');
+	fprintf(file_, ",\"args\":{\"value\":%.3f}}", value);
+}
+
+//==============================================================================
+Trace &trace_get()
+{
+	static Trace trace;
+	return trace;
+}
+
+//==============================================================================
+TraceScope::TraceScope(const char name[], const char category[],
+		const char arg_name[], uint64_t arg_value) :
+	enabled_(trace_get().enabled())
+{
+	if (enabled_)
+		trace_get().begin(name, category, arg_name, arg_value);
+}
+
+//==============================================================================
+TraceScope::~TraceScope()
+{
+	if (enabled_)
+		trace_get().end();
+}
@@ -0,0 +1,57 @@
+/*
+ * trace.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdio.h>
+#include "common.h"
+
+/// Timeline in Chrome trace event format (JSON array), can be opened by
+/// Perfetto UI or chrome://tracing. Does nothing until trace file is set.
+class Trace
+{
+public:
+	void set_trace_file(const String &file_name); // throw
+	bool enabled() const;
+
+	/// Start nested span, optional argument is shown in span details
+	void begin(const char name[], const char category[],
+			const char arg_name[] = NULL, uint64_t arg_value = 0);
+	void end();
+
+	/// Add value to counter track
+	void counter(const char name[], double value);
+
+	Trace();
+	~Trace();
+
+private:
+	void add_event(const char name[], const char category[], char phase);
+
+	FILE *file_;
+	uint64_t start_time_;
+	bool first_event_;
+};
+
+Trace &trace_get();
+
+/// Span lasting until the end of the scope
+class TraceScope : boost::noncopyable
+{
+public:
+	TraceScope(const char name[], const char category[],
+			const char arg_name[] = NULL, uint64_t arg_value = 0);
+	~TraceScope();
+
+private:
+	bool enabled_;
+};
+
+#endif // !_TRACE_H_
@@ -0,0 +1,110 @@
+/*
+ * data_block_view.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include "data_block_view.h"
+
+//==============================================================================
+static bool ends_before(const DataSection &section, uint_t address)
+{	return section.next_address() <= address; }
+
+//==============================================================================
+static bool filled_with(const uint8_t data[], size_t size, uint8_t filler)
+{	return !size || (data[0] == filler && !memcmp(data, data + 1, size - 1)); }
+
+//==============================================================================
+DataBlockView::DataBlockView() :
+		store_(NULL),
+		block_size_(0),
+		filler_(0),
+		used_block_count_(0)
+{ }
+
+//==============================================================================
+void DataBlockView::reset(const DataSectionStore &store, size_t block_size,
+		uint8_t filler)
+{
+	store_ = &store;
+	block_size_ = block_size;
+	filler_ = filler;
+	used_block_count_ = 0;
+
+	used_.assign(align_up(store.upper_address(), block_size) / block_size, false);
+
+	// only data of sections is checked, gaps between them are blank
+	foreach (const DataSection &section, store.sections())
+	{
+		size_t offset = 0;
+		while (offset < section.size())
+		{
+			size_t address = section.address + offset;
+			size_t index = address / block_size;
+			size_t size = std::min(section.size() - offset,
+					(index + 1) * block_size - address);
+
+			if (!used_[index] && !filled_with(&section.data[offset], size, filler))
+			{
+				used_[index] = true;
+				used_block_count_++;
+			}
+			offset += size;
+		}
+	}
+}
+
+//==============================================================================
+void DataBlockView::clear()
+{
+	store_ = NULL;
+	used_.clear();
+	used_block_count_ = 0;
+}
+
+//==============================================================================
+size_t DataBlockView::block_size() const
+{	return block_size_; }
+
+//==============================================================================
+size_t DataBlockView::block_count() const
+{	return used_.size(); }
+
+//==============================================================================
+size_t DataBlockView::used_block_count() const
+{	return used_block_count_; }
+
+//==============================================================================
+bool DataBlockView::block_used(size_t index) const
+{	return index < used_.size() && used_[index]; }
+
+//==============================================================================
+const uint8_t *DataBlockView::block(size_t index)
+{
+	const DataSectionList &sections = store_->sections();
+	size_t address = index * block_size_;
+	size_t next_address = address + block_size_;
+
+	DataSectionList::const_iterator it = std::lower_bound(sections.begin(),
+			sections.end(), address, ends_before);
+
+	// the whole block is within a section
+	if (it != sections.end() && it->address <= address &&
+			it->next_address() >= next_address)
+		return &it->data[address - it->address];
+
+	buffer_.resize(block_size_);
+	std::fill(buffer_.begin(), buffer_.end(), filler_);
+
+	for (; it != sections.end() && it->address < next_address; ++it)
+	{
+		size_t from = std::max<size_t>(it->address, address);
+		size_t to = std::min<size_t>(it->next_address(), next_address);
+
+		memcpy(&buffer_[from - address], &it->data[from - it->address], to - from);
+	}
+	return &buffer_[0];
+}
@@ -0,0 +1,55 @@
+/*
+ * data_block_view.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _DATA_BLOCK_VIEW_H_
+#define _DATA_BLOCK_VIEW_H_
+
+#include "common.h"
+#include "data_section_store.h"
+
+/// Sparse view of DataSectionStore as a sequence of aligned blocks of the
+/// same size. Blocks are not materialized: a block lying within a section
+/// is referenced in place, other blocks are assembled on request.
+/// The view refers to the store which must not change while it's used.
+class DataBlockView
+{
+public:
+	/// Split store into blocks of block_size, missing data is filler.
+	/// Blocks that contain only filler are marked unused
+	void reset(const DataSectionStore &store, size_t block_size, uint8_t filler);
+
+	/// Drop reference to the store
+	void clear();
+
+	size_t block_size() const;
+
+	/// Number of blocks up to the upper address of the store
+	size_t block_count() const;
+
+	/// Number of blocks with data other than filler
+	size_t used_block_count() const;
+
+	/// @return false if block contains only filler
+	bool block_used(size_t index) const;
+
+	/// Return block data, the pointer is valid until next call
+	const uint8_t *block(size_t index);
+
+	DataBlockView();
+
+private:
+	const DataSectionStore *store_;
+	size_t block_size_;
+	uint8_t filler_;
+	size_t used_block_count_;
+	BoolVector used_;
+	ByteVector buffer_;
+};
+
+#endif // !_DATA_BLOCK_VIEW_H_
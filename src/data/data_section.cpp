@@ -22,6 +22,41 @@ std::ostream& operator <<(std::ostream &os, const DataSection &o)
 	return os;
 }
 
+//==============================================================================
+std::ostream& operator <<(std::ostream &os, const AddressRange &o)
+{
+	os << std::uppercase << std::hex << std::setfill('0');
+	os << std::setw(6) << o.begin << "h-" << std::setw(6) << o.end - 1 << "h";
+	os << std::dec;
+
+	return os;
+}
+
+//==============================================================================
+std::ostream& operator <<(std::ostream &os, const AddressRangeList &o)
+{
+	for (size_t i = 0; i < o.size(); i++)
+		os << (i ? ", " : "") << o[i];
+
+	return os;
+}
+
+//==============================================================================
+AddressRange::AddressRange() :
+		begin(0),
+		end(0)
+{ }
+
+//==============================================================================
+AddressRange::AddressRange(uint_t begin, uint_t end) :
+		begin(begin),
+		end(end)
+{ }
+
+//==============================================================================
+bool AddressRange::empty() const
+{	return begin >= end; }
+
 //==============================================================================
 bool DataSection::empty() const
 {
@@ -40,6 +75,13 @@ uint_t DataSection::next_address() const
 	return address + data.size();
 }
 
+//==============================================================================
+void DataSection::swap(DataSection &other)
+{
+	std::swap(address, other.address);
+	data.swap(other.data);
+}
+
 //==============================================================================
 DataSection::DataSection() :
 		address(0)
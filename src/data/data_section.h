@@ -11,7 +11,7 @@
 #ifndef _DATA_SECTION_H_
 #define _DATA_SECTION_H_
 
-#include <list>
+#include <vector>
 #include "common.h"
 
 struct DataSection
@@ -20,6 +20,9 @@ struct DataSection
 	size_t size() const;
 	uint_t next_address() const;
 
+	/// Exchange contents without copying data
+	void swap(DataSection &other);
+
 	DataSection();
 	DataSection(uint_t address, const ByteVector &data);
 	DataSection(uint_t address, const uint8_t data[], size_t size);
@@ -28,8 +31,26 @@ struct DataSection
 	ByteVector data;
 };
 
-typedef std::list<DataSection> DataSectionList;
+typedef std::vector<DataSection> DataSectionList;
+
+/// Address range [begin, end)
+struct AddressRange
+{
+	AddressRange();
+	AddressRange(uint_t begin, uint_t end);
+
+	bool empty() const;
+
+	uint_t begin;
+	uint_t end;
+};
+
+typedef std::vector<AddressRange> AddressRangeList;
 
 std::ostream& operator <<(std::ostream &os, const DataSection &o);
 
+/// Printed as inclusive range: 001000h-0010FFh
+std::ostream& operator <<(std::ostream &os, const AddressRange &o);
+std::ostream& operator <<(std::ostream &os, const AddressRangeList &o);
+
 #endif // !_DATA_SECTION_H_
@@ -11,19 +11,22 @@
 #include "data_section_store.h"
 
 //==============================================================================
-static bool sections_overlapped(
-		const DataSection &section1,
-		const DataSection &section2)
-{
-	if (section1.address >= section2.address &&
-			section1.address < section2.next_address())
-		return true;
+static bool ends_before(const DataSection &section, uint_t address)
+{	return section.next_address() < address; }
 
-	if (section2.address >= section1.address &&
-			section2.address < section1.next_address())
-		return true;
+//==============================================================================
+static bool starts_after(uint_t address, const DataSection &section)
+{	return address < section.address; }
 
-	return false;
+//==============================================================================
+/// Find sections [first, last) overlapped by or adjacent to [address, next_address)
+static void find_touching_sections(const DataSectionList &sections,
+		uint_t address, uint_t next_address, size_t &first, size_t &last)
+{
+	first = std::lower_bound(sections.begin(), sections.end(),
+			address, ends_before) - sections.begin();
+	last = std::upper_bound(sections.begin() + first, sections.end(),
+			next_address, starts_after) - sections.begin();
 }
 
 //==============================================================================
@@ -31,154 +34,260 @@ static bool check_section_fit(
 		const DataSectionList &sections,
 		const DataSection &section)
 {
-	foreach (const DataSection &item, sections)
+	size_t first = 0, last = 0;
+	find_touching_sections(sections, section.address, section.next_address(),
+			first, last);
+
+	// at most two adjacent sections if there is no overlapping
+	for (size_t i = first; i < last; i++)
 	{
-		if (sections_overlapped(item, section))
+		if (sections[i].address < section.next_address() &&
+				sections[i].next_address() > section.address)
 			return false;
 	}
 	return true;
 }
 
 //==============================================================================
-static void add_insert_section(
-		DataSectionList &sections,
-		const DataSection &section)
+DataSectionStore::DataSectionStore()
+{	touch(); }
+
+//==============================================================================
+void DataSectionStore::touch()
 {
-	DataSectionList::iterator it = sections.begin();
-	for ( ; it != sections.end(); it++)
-	{
-		if (it->address > section.address)
-		{
-			if (it != sections.begin())
-				--it;
-			break;
-		}
-	}
-	sections.insert(it, section);
-	/// possibly merge
+	// stores are filled by image loader threads
+	static uint_t last_stamp = 0;
+	stamp_ = __sync_add_and_fetch(&last_stamp, 1);
 }
 
 //==============================================================================
-static void add_replace_section(
-		DataSectionList &sections,
-		const DataSection &section)
+uint_t DataSectionStore::stamp() const
+{	return stamp_; }
+
+//==============================================================================
+const DataSectionList &DataSectionStore::sections() const
+{	return sections_; }
+
+//==============================================================================
+size_t DataSectionStore::lower_address() const
+{	return sections_.empty() ? 0 : sections_.front().address; }
+
+//==============================================================================
+size_t DataSectionStore::upper_address() const
+{	return sections_.empty() ? 0 : sections_.back().next_address(); }
+
+//==============================================================================
+void DataSectionStore::remove_sections()
+{
+	sections_.clear();
+	touch();
+}
+
+//==============================================================================
+void DataSectionStore::swap(DataSectionStore &other)
+{
+	sections_.swap(other.sections_);
+	std::swap(stamp_, other.stamp_);
+}
+
+//==============================================================================
+void DataSectionStore::clip(const AddressRange &range)
 {
-	DataSectionList::iterator cur_section = sections.begin();
-	for (; cur_section != sections.end(); cur_section++)
+	size_t first = 0, last = 0;
+	find_touching_sections(sections_, range.begin, range.end, first, last);
+
+	DataSectionList sections;
+	for (size_t i = first; i < last; i++)
 	{
-		// new section starts at empty space
-		if (section.address < cur_section->address)
-		{
-			cur_section = sections.insert(cur_section, section);
-			// normalze
-			break;
-		}
-		// new section starts in another section
-		if (cur_section->next_address() > section.address)
+		DataSection &section = sections_[i];
+		uint_t begin = std::max(section.address, range.begin);
+		uint_t end = std::min(section.next_address(), range.end);
+		if (begin >= end)
+			continue; // adjacent to the range
+
+		sections.push_back(DataSection());
+		sections.back().address = begin;
+		if (begin == section.address && end == section.next_address())
+			sections.back().data.swap(section.data);
+		else
 		{
-			uint_t section_offset = section.address - cur_section->address;
-
-			// simple case: replace a part of existing section,
-			// no size change, no normalize
-			if (cur_section->next_address() >= section.next_address())
-			{
-				std::copy(section.data.begin(), section.data.end(),
-						cur_section->data.begin() + section_offset);
-				return;
-			}
-
-			// new section doen't fit current section so resize it and then
-			// normalize
-			cur_section->data.resize(section.next_address() - cur_section->address);
-			std::copy(section.data.begin(), section.data.end(),
-					cur_section->data.begin() + section_offset);
-			break;
+			ByteVector::const_iterator data = section.data.begin() + (begin - section.address);
+			sections.back().data.assign(data, data + (end - begin));
 		}
 	}
+	sections_.swap(sections);
+	touch();
+}
 
-	if (cur_section == sections.end())
-	{
-		sections.push_back(section);
-		/// possibly merge
-		return;
-	}
+//==============================================================================
+bool DataSectionStore::find_overlaps(const DataSection &section,
+		AddressRangeList &ranges) const
+{
+	size_t first = 0, last = 0;
+	find_touching_sections(sections_, section.address, section.next_address(),
+			first, last);
 
-	/// normalize sections:
-	DataSectionList::iterator it = cur_section;
-	it++;
-	for (; it != sections.end(); ++it)
+	bool result = false;
+	for (size_t i = first; i < last; i++)
 	{
-		if (it->address >= cur_section->next_address())
-			break; // need merge
-
-		/// old section completely overlapped by new one, remove it
-		if (it->address >= cur_section->address &&
-				it->next_address() <= cur_section->next_address())
+		uint_t begin = std::max(sections_[i].address, section.address);
+		uint_t end = std::min(sections_[i].next_address(), section.next_address());
+		if (begin < end)
 		{
-			it = sections.erase(it);
-			continue;
-		}
-		/// old section party overlapped by new one, merge them
-		if (it->address >= cur_section->next_address())
-		{
-			cur_section->data.insert(cur_section->data.end(),
-							it->data.begin() + cur_section->next_address() - it->address,
-							it->data.end());
-			it = sections.erase(it);
+			ranges.push_back(AddressRange(begin, end));
+			result = true;
 		}
 	}
+	return result;
 }
 
 //==============================================================================
-const DataSectionList &DataSectionStore::sections() const
-{	return sections_; }
+void DataSectionStore::insert_slot(size_t index)
+{
+	if (sections_.size() == sections_.capacity())
+	{
+		// grow without copying data of the sections
+		DataSectionList sections;
+		sections.reserve(std::max<size_t>(16, sections_.size() * 2));
+		sections.resize(sections_.size());
+		for (size_t i = 0; i < sections_.size(); i++)
+			sections[i].swap(sections_[i]);
+		sections_.swap(sections);
+	}
 
-//==============================================================================
-size_t DataSectionStore::lower_address() const
-{	return sections_.empty() ? 0 : sections_.front().address; }
+	sections_.push_back(DataSection());
+	for (size_t i = sections_.size() - 1; i > index; i--)
+		sections_[i].swap(sections_[i - 1]);
+}
 
 //==============================================================================
-size_t DataSectionStore::upper_address() const
-{	return sections_.empty() ? 0 : sections_.back().next_address(); }
+void DataSectionStore::erase_sections(size_t first, size_t last)
+{
+	if (first >= last)
+		return;
 
-//==============================================================================
-void DataSectionStore::remove_sections()
-{	sections_.clear(); }
+	size_t count = last - first;
+	for (size_t i = last; i < sections_.size(); i++)
+		sections_[i - count].swap(sections_[i]);
+	sections_.resize(sections_.size() - count);
+}
 
 //==============================================================================
-bool DataSectionStore::add_section(const DataSection &section, bool overwrite)
+bool DataSectionStore::insert_section(const DataSection &section,
+		ByteVector *payload, bool overwrite)
 {
 	if (section.empty())
 		return true;
 
+	uint_t address = section.address;
+	uint_t next_address = section.next_address();
+
+	size_t first = 0, last = 0;
+	find_touching_sections(sections_, address, next_address, first, last);
+
 	if (!overwrite)
 	{
-		if (!check_section_fit(sections_, section))
-			return false;
-		add_insert_section(sections_, section);
+		for (size_t i = first; i < last; i++)
+		{
+			if (sections_[i].address < next_address &&
+					sections_[i].next_address() > address)
+				return false;
+		}
+	}
+	touch();
+
+	if (first == last)
+	{
+		insert_slot(first);
+		sections_[first].address = address;
+		if (payload)
+			sections_[first].data.swap(*payload);
+		else
+			sections_[first].data = section.data;
+		return true;
+	}
+
+	DataSection &head = sections_[first];
+	DataSection &tail = sections_[last - 1];
+
+	// simple case: replace a part of existing section
+	if (head.address <= address && head.next_address() >= next_address)
+	{
+		std::copy(section.data.begin(), section.data.end(),
+				head.data.begin() + (address - head.address));
+		return true;
+	}
+
+	// data of the last section left after the new one
+	size_t tail_size = tail.next_address() > next_address ?
+			tail.next_address() - next_address : 0;
+
+	if (head.address < address)
+	{
+		// the first section is extended, it can't be the last one here
+		// unless tail_size is 0
+		head.data.reserve(next_address - head.address + tail_size);
+		head.data.resize(address - head.address);
+		head.data.insert(head.data.end(), section.data.begin(), section.data.end());
+		head.data.insert(head.data.end(), tail.data.end() - tail_size, tail.data.end());
 	}
 	else
-		add_replace_section(sections_, section);
+	{
+		ByteVector data;
+		if (payload)
+			data.swap(*payload);
+		else
+		{
+			data.reserve(section.data.size() + tail_size);
+			data = section.data;
+		}
+		data.insert(data.end(), tail.data.end() - tail_size, tail.data.end());
+
+		head.address = address;
+		head.data.swap(data);
+	}
 
+	erase_sections(first + 1, last);
+	return true;
+}
+
+//==============================================================================
+bool DataSectionStore::add_section(const DataSection &section, bool overwrite)
+{	return insert_section(section, NULL, overwrite); }
+
+//==============================================================================
+bool DataSectionStore::take_section(DataSection &section, bool overwrite)
+{
+	if (!insert_section(section, &section.data, overwrite))
+		return false;
+
+	section.data.clear();
 	return true;
 }
 
 //==============================================================================
 bool DataSectionStore::add_sections(const DataSectionStore &store, bool overwrite)
 {
+	if (&store == this)
+		return overwrite || sections_.empty();
+
+	if (sections_.empty())
+	{
+		sections_ = store.sections_;
+		touch();
+		return true;
+	}
+
 	if (!overwrite)
 	{
 		foreach (const DataSection &item, store.sections())
 		{
-			if (check_section_fit(sections_, item))
+			if (!check_section_fit(sections_, item))
 				return false;
 		}
-		foreach (const DataSection &item, store.sections())
-			add_insert_section(sections_, item);
 	}
-	else
-		foreach (const DataSection &item, store.sections())
-			add_replace_section(sections_, item);
+	foreach (const DataSection &item, store.sections())
+		insert_section(item, NULL, overwrite);
 	return true;
 }
 
@@ -14,7 +14,9 @@
 #include "common.h"
 #include "data_section.h"
 
-/// Class store and manage a list of DataSections object in (accednig not-overlapped order)
+/// Class store and manage a list of DataSections object in (accednig not-overlapped order).
+/// Sections are kept in a vector sorted by address, adjacent and overlapped
+/// sections are merged on insertion so lookup is a binary search.
 class DataSectionStore
 {
 public:
@@ -31,6 +33,10 @@ public:
 	/// @return false if section overlapped and overwrite is false
 	bool add_section(const DataSection &data, bool overwrite);
 
+	/// Same as add_section but data of the section may be taken by the store
+	/// without copying. The section is left empty on success
+	bool take_section(DataSection &section, bool overwrite);
+
 	/// Add all of DataSectionStore object's sections to the store
 	/// @return false if section overlapped and overwrite is false
 	bool add_sections(const DataSectionStore &section_store, bool overwrite);
@@ -38,13 +44,41 @@ public:
 	/// Remove all sections
 	void remove_sections();
 
+	/// Exchange contents without copying data
+	void swap(DataSectionStore &other);
+
+	/// Remove data outside of the range
+	void clip(const AddressRange &range);
+
+	/// Append ranges where the section overlaps data of the store
+	/// @return false if there is no overlapping
+	bool find_overlaps(const DataSection &section, AddressRangeList &ranges) const;
+
 	/// Unite all sections to one continuoys memory block
 	void create_image(uint8_t filler, ByteVector &image) const;
 
 	const DataSectionList &sections() const;
 
+	/// Token of the current content, a new one is taken on every change.
+	/// Tokens aren't reused by any store, so equal tokens mean equal content.
+	uint_t stamp() const;
+
+	DataSectionStore();
+
 private:
+	/// Take a new stamp, content is changed
+	void touch();
+
+	bool insert_section(const DataSection &section, ByteVector *payload,
+			bool overwrite);
+
+	/// Open empty slot at index, sections are moved by swapping
+	void insert_slot(size_t index);
+	/// Remove sections [first, last) by swapping
+	void erase_sections(size_t first, size_t last);
+
 	DataSectionList sections_;
+	uint_t stamp_;
 };
 
 #endif // !_DATA_SECTION_STORE_H_
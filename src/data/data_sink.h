@@ -0,0 +1,25 @@
+/*
+ * data_sink.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _DATA_SINK_H_
+#define _DATA_SINK_H_
+
+#include "common.h"
+
+/// Receiver of data read from target, blocks come in ascending order
+/// as soon as they are read
+class DataSink
+{
+public:
+	virtual void write(size_t offset, const uint8_t data[], size_t size) = 0;
+
+	virtual ~DataSink() { }
+};
+
+#endif // !_DATA_SINK_H_
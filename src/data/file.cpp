@@ -11,6 +11,9 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
 #include "file.h"
 
 //==============================================================================
@@ -30,13 +33,14 @@ inline void file_io_error(const String &context, const String &file_name)
 
 //==============================================================================
 File::File() :
-	file_(NULL)
+	file_(NULL),
+	attached_(false)
 { }
 
 //==============================================================================
 File::~File()
 {
-	if (file_ != NULL)
+	if (file_ != NULL && !attached_)
 		fclose(file_);
 }
 
@@ -58,9 +62,28 @@ void File::open(const String &file_name, const char mode[], off_t max_size)
 	}
 }
 
+//==============================================================================
+void File::attach(FILE *file, const String &name)
+{
+	close();
+
+	file_ = file;
+	file_name_ = name;
+	attached_ = true;
+}
+
 //==============================================================================
 void File::close()
 {
+	if (file_ != NULL && attached_)
+	{
+		FILE *file = file_;
+		file_ = NULL;
+		attached_ = false;
+		if (fflush(file) < 0)
+			file_io_error("File::close", file_name_);
+		return;
+	}
 	if (file_ != NULL)
 		if (fclose(file_) < 0)
 			file_io_error("File::close", file_name_);
@@ -141,3 +164,175 @@ bool File::read_n(uint8_t data[], size_t max_size, size_t &read_size)
 	read_size = result;
 	return feof(file_);
 }
+
+//==============================================================================
+MappedFile::MappedFile() :
+	map_(NULL),
+	size_(0)
+{ }
+
+//==============================================================================
+MappedFile::~MappedFile()
+{	close(); }
+
+//==============================================================================
+void MappedFile::open(const String &file_name)
+{
+	close();
+
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		file_io_error("MappedFile::open", file_name);
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size)
+	{
+		void *map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED)
+		{
+			madvise(map, file_stat.st_size, MADV_SEQUENTIAL);
+			map_ = map;
+			size_ = file_stat.st_size;
+			::close(fd);
+			return;
+		}
+	}
+
+	const size_t CHUNK_SIZE = 64 * 1024;
+	for (;;)
+	{
+		size_t offset = buffer_.size();
+		buffer_.resize(offset + CHUNK_SIZE);
+
+		ssize_t result = ::read(fd, &buffer_[offset], CHUNK_SIZE);
+		if (result < 0 && errno == EINTR)
+		{
+			buffer_.resize(offset);
+			continue;
+		}
+		if (result < 0)
+		{
+			::close(fd);
+			buffer_.clear();
+			file_io_error("MappedFile::open", file_name);
+		}
+		buffer_.resize(offset + result);
+		if (!result)
+			break;
+	}
+	size_ = buffer_.size();
+	::close(fd);
+}
+
+//==============================================================================
+void MappedFile::close()
+{
+	if (map_)
+		munmap(map_, size_);
+	map_ = NULL;
+	size_ = 0;
+	buffer_.clear();
+}
+
+//==============================================================================
+const char *MappedFile::data() const
+{
+	if (map_)
+		return (const char *)map_;
+	return buffer_.empty() ? NULL : (const char *)&buffer_[0];
+}
+
+//==============================================================================
+size_t MappedFile::size() const
+{	return size_; }
+
+//==============================================================================
+void mapped_file_header_init(MappedFileHeader &header, const MappedFileFormat &format)
+{
+	memcpy(header.magic, format.magic, sizeof(header.magic));
+	header.version = format.version;
+	header.byte_order = MAPPED_FILE_BYTE_ORDER;
+}
+
+//==============================================================================
+void mapped_file_open(MappedFile &file, const String &file_name,
+		const MappedFileFormat &format, size_t header_size)
+{
+	file.open(file_name);
+
+	const MappedFileHeader *header = (const MappedFileHeader *)file.data();
+	if (file.size() < std::max(header_size, sizeof(MappedFileHeader)) ||
+			memcmp(header->magic, format.magic, sizeof(header->magic)))
+		mapped_file_error(file_name, String("not a ") + format.name);
+
+	if (header->byte_order != MAPPED_FILE_BYTE_ORDER)
+		mapped_file_error(file_name, String(format.name) +
+				" is made on a host of other byte order");
+	if (header->version != format.version)
+		mapped_file_error(file_name, String("unsupported ") + format.name + " version");
+}
+
+//==============================================================================
+void mapped_file_error(const String &file_name, const String &message)
+{
+	throw FileException("File '" + file_name + "' load error: " + message);
+}
+
+//==============================================================================
+static void file_replace(const String &file_name, const void *data, size_t size)
+{
+	String temp_name = file_name + ".XXXXXX";
+	std::vector<char> buffer(temp_name.begin(), temp_name.end());
+	buffer.push_back('\0');
+
+	int fd = mkstemp(&buffer[0]);
+	if (fd < 0)
+		file_io_error("file_replace", temp_name);
+
+	// mkstemp creates the file private, make it as any other new file
+	mode_t mask = umask(0);
+	umask(mask);
+	fchmod(fd, 0666 & ~mask);
+
+	bool result = write(fd, data, size) == (ssize_t)size;
+	result = !::close(fd) && result;
+	if (!result || rename(&buffer[0], file_name.c_str()))
+	{
+		int error = errno;
+		unlink(&buffer[0]);
+		errno = error;
+		file_io_error("file_replace", file_name);
+	}
+}
+
+//==============================================================================
+void file_replace(const String &file_name, const String &data)
+{	file_replace(file_name, data.data(), data.size()); }
+
+//==============================================================================
+void file_replace(const String &file_name, const ByteVector &data)
+{	file_replace(file_name, data.empty() ? NULL : &data[0], data.size()); }
+
+//==============================================================================
+FileLock::FileLock(const String &file_name) :
+		fd_(-1)
+{
+	String lock_name = file_name + ".lock";
+	fd_ = ::open(lock_name.c_str(), O_RDWR | O_CREAT, 0666);
+	if (fd_ < 0)
+		file_io_error("FileLock", lock_name);
+
+	while (flock(fd_, LOCK_EX))
+	{
+		if (errno == EINTR)
+			continue;
+		int error = errno;
+		::close(fd_);
+		errno = error;
+		file_io_error("FileLock", lock_name);
+	}
+}
+
+//==============================================================================
+FileLock::~FileLock()
+{	::close(fd_); }
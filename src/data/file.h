@@ -17,6 +17,8 @@ class File //: boost::noncopyable
 {
 public:
 	void open(const String &file_name, const char mode[], off_t max_size = 0); // throw
+	/// Use already opened stream (e.g. stdout), it's flushed but not closed
+	void attach(FILE *file, const String &name);
 	void close(); // throw
 
 	off_t size(); // throw
@@ -36,6 +38,78 @@ public:
 private:
 	FILE *file_;
 	String file_name_;
+	bool attached_;
+};
+
+/// Read-only contents of a file, mapped to memory when possible
+class MappedFile
+{
+public:
+	void open(const String &file_name); // throw
+	void close();
+
+	const char *data() const;
+	size_t size() const;
+
+	MappedFile();
+	~MappedFile();
+
+private:
+	void *map_;
+	size_t size_;
+	ByteVector buffer_; // file that can't be mapped (e.g. pipe) is read here
+};
+
+/// Leading fields of binary files the host writes for itself and maps back
+/// (flash plan, flash delta, image cache entry), in host byte order
+struct MappedFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;	// MAPPED_FILE_BYTE_ORDER as written by the host
+};
+
+const uint32_t MAPPED_FILE_BYTE_ORDER = 0x01020304;
+
+/// Data following the tables of a mapped file are aligned to this
+const size_t MAPPED_FILE_DATA_ALIGNMENT = 16;
+
+struct MappedFileFormat
+{
+	const char *name; // for messages, e.g. "flash plan"
+	char magic[8];
+	uint32_t version;
+};
+
+void mapped_file_header_init(MappedFileHeader &header, const MappedFileFormat &format);
+
+/// Map the file and check it starts with the header of the format and holds
+/// at least header_size bytes, the rest is checked by the caller
+void mapped_file_open(MappedFile &file, const String &file_name,
+		const MappedFileFormat &format, size_t header_size); // throw
+
+/// Load error of a file in a format of the host
+void mapped_file_error(const String &file_name, const String &message); // throw
+
+/// Write the whole file through a unique temporary file in the same directory
+/// renamed over it: readers never see a partial file, concurrent writers
+/// don't share the temporary one
+void file_replace(const String &file_name, const String &data); // throw
+void file_replace(const String &file_name, const ByteVector &data); // throw
+
+/// Exclusive lock of a file shared by processes, held while the object lives.
+/// Taken on 'file_name.lock' as the file itself may be replaced.
+class FileLock
+{
+public:
+	FileLock(const String &file_name); // throw
+	~FileLock();
+
+private:
+	FileLock(const FileLock &);
+	FileLock &operator=(const FileLock &);
+
+	int fd_;
 };
 
 class FileException : public std::runtime_error
@@ -0,0 +1,141 @@
+/*
+ * flash_delta.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include "data_block_view.h"
+#include "flash_delta.h"
+
+const MappedFileFormat FLASH_DELTA_FORMAT =
+		{ "flash delta", { 'C', 'C', 'D', 'E', 'L', 'T', 'A', 0 }, 1 };
+
+//==============================================================================
+FlashDelta::FlashDelta() :
+		header_(NULL),
+		pages_(NULL)
+{ }
+
+//==============================================================================
+void FlashDelta::open(const String &file_name)
+{
+	close();
+	mapped_file_open(file_, file_name, FLASH_DELTA_FORMAT, sizeof(FlashDeltaHeader));
+	file_name_ = file_name;
+
+	size_t size = file_.size();
+	const FlashDeltaHeader *header = (const FlashDeltaHeader *)file_.data();
+	if (!header->page_size || header->page_count >
+			(size - sizeof(FlashDeltaHeader)) / sizeof(FlashDeltaPage))
+		mapped_file_error(file_name, "bad page table");
+
+	const FlashDeltaPage *pages = (const FlashDeltaPage *)(header + 1);
+	uint_t next_address = 0;
+	for (size_t i = 0; i < header->page_count; i++)
+	{
+		const FlashDeltaPage &page = pages[i];
+		if (page.address < next_address ||
+				page.address % header->page_size ||
+				page.address > header->upper_address ||
+				header->page_size > header->upper_address - page.address ||
+				page.data_offset % MAPPED_FILE_DATA_ALIGNMENT ||
+				(page.data_offset && (page.data_offset > size ||
+				header->page_size > size - page.data_offset)))
+			mapped_file_error(file_name, "bad page " + number_to_string(i));
+
+		next_address = page.address + header->page_size;
+	}
+
+	header_ = header;
+	pages_ = pages;
+}
+
+//==============================================================================
+void FlashDelta::close()
+{
+	file_.close();
+	file_name_.clear();
+	header_ = NULL;
+	pages_ = NULL;
+}
+
+//==============================================================================
+bool FlashDelta::opened() const
+{	return header_ != NULL; }
+
+//==============================================================================
+const FlashDeltaHeader &FlashDelta::header() const
+{	return *header_; }
+
+//==============================================================================
+const String &FlashDelta::file_name() const
+{	return file_name_; }
+
+//==============================================================================
+size_t FlashDelta::page_count() const
+{	return header_ ? header_->page_count : 0; }
+
+//==============================================================================
+const FlashDeltaPage &FlashDelta::page(size_t index) const
+{	return pages_[index]; }
+
+//==============================================================================
+const uint8_t *FlashDelta::page_data(size_t index) const
+{
+	if (!pages_[index].data_offset)
+		return NULL;
+	return (const uint8_t *)file_.data() + pages_[index].data_offset;
+}
+
+//==============================================================================
+void FlashDelta::save(const String &file_name, const DataSectionStore &new_image,
+		size_t page_size, const PageChangeList &changes)
+{
+	DataBlockView view;
+	view.reset(new_image, page_size, PAGE_FILLER);
+
+	FlashDeltaHeader header;
+	memset(&header, 0, sizeof(header));
+	mapped_file_header_init(header.format, FLASH_DELTA_FORMAT);
+	header.page_size = page_size;
+	header.page_count = changes.size();
+
+	size_t data_size = 0;
+	foreach (const PageChange &change, changes)
+	{
+		if (!change.new_blank)
+			data_size += align_up(page_size, MAPPED_FILE_DATA_ALIGNMENT);
+		header.upper_address = change.address + page_size;
+	}
+
+	size_t data_offset = align_up(sizeof(FlashDeltaHeader) +
+			header.page_count * sizeof(FlashDeltaPage), MAPPED_FILE_DATA_ALIGNMENT);
+
+	ByteVector content(data_offset + data_size, PAGE_FILLER);
+	memcpy(&content[0], &header, sizeof(header));
+
+	FlashDeltaPage *pages = (FlashDeltaPage *)&content[sizeof(header)];
+	for (size_t i = 0; i < changes.size(); i++)
+	{
+		const PageChange &change = changes[i];
+
+		FlashDeltaPage &page = pages[i];
+		page.address = change.address;
+		page.data_offset = 0;
+		page.old_crc = change.old_crc;
+		page.new_crc = change.new_crc;
+		page.reserved = 0;
+
+		if (change.new_blank)
+			continue;
+
+		page.data_offset = data_offset;
+		memcpy(&content[data_offset], view.block(change.address / page_size), page_size);
+		data_offset += align_up(page_size, MAPPED_FILE_DATA_ALIGNMENT);
+	}
+
+	file_replace(file_name, content);
+}
@@ -0,0 +1,71 @@
+/*
+ * flash_delta.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _FLASH_DELTA_H_
+#define _FLASH_DELTA_H_
+
+#include "common.h"
+#include "data_section_store.h"
+#include "image_pages.h"
+#include "file.h"
+
+/// Delta file layout, all fields are in host byte order:
+/// header, page table, data of pages (MAPPED_FILE_DATA_ALIGNMENT aligned)
+struct FlashDeltaHeader
+{
+	MappedFileHeader format;
+	uint32_t page_size;
+	uint32_t page_count;
+	uint32_t upper_address;	// end of the last page
+	uint32_t reserved;
+};
+
+struct FlashDeltaPage
+{
+	uint32_t address;
+	uint32_t data_offset;	// from the beginning of the file, 0 if page is blank
+	uint16_t old_crc;		// CRC of the page in the base image
+	uint16_t new_crc;
+	uint32_t reserved;
+};
+
+/// Pages that differ between two images: content of the new image and CRC
+/// of the page in both images. Target is updated by rewriting these pages
+/// only, if they hold the base image. The file is mapped to memory.
+class FlashDelta : boost::noncopyable
+{
+public:
+	/// Map delta and check its consistency
+	void open(const String &file_name); // throw
+	void close();
+	bool opened() const;
+
+	const FlashDeltaHeader &header() const;
+	const String &file_name() const;
+
+	size_t page_count() const;
+	const FlashDeltaPage &page(size_t index) const;
+	/// @return NULL if page is blank in the new image
+	const uint8_t *page_data(size_t index) const;
+
+	/// Save changes found by image_page_changes, page data are taken from
+	/// the new image
+	static void save(const String &file_name, const DataSectionStore &new_image,
+			size_t page_size, const PageChangeList &changes); // throw
+
+	FlashDelta();
+
+private:
+	MappedFile file_;
+	String file_name_;
+	const FlashDeltaHeader *header_;
+	const FlashDeltaPage *pages_;
+};
+
+#endif // !_FLASH_DELTA_H_
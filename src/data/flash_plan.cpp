@@ -0,0 +1,198 @@
+/*
+ * flash_plan.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include "data_block_view.h"
+#include "flash_plan.h"
+
+const MappedFileFormat FLASH_PLAN_FORMAT =
+		{ "flash plan", { 'C', 'C', 'P', 'L', 'A', 'N', 0, 0 }, 1 };
+
+//==============================================================================
+void flash_block_crcs(const DataSectionStore &store, size_t block_size,
+		size_t bank_size, FlashBlockCrcList &blocks)
+{
+	foreach (const DataSection &section, store.sections())
+	{
+		size_t offset = 0;
+		while (offset < section.size())
+		{
+			size_t address = section.address + offset;
+			size_t count = std::min(section.size() - offset, block_size);
+			count = std::min(count, bank_size - address % bank_size);
+
+			CrcCalculator crc_calc;
+			crc_calc.process_bytes(&section.data[offset], count);
+
+			FlashBlockCrc block;
+			block.address = address;
+			block.size = count;
+			block.crc = crc_calc.checksum();
+			blocks.push_back(block);
+
+			offset += count;
+		}
+	}
+}
+
+//==============================================================================
+FlashPlan::FlashPlan() :
+		header_(NULL),
+		blocks_(NULL)
+{ }
+
+//==============================================================================
+void FlashPlan::open(const String &file_name)
+{
+	close();
+	mapped_file_open(file_, file_name, FLASH_PLAN_FORMAT, sizeof(FlashPlanHeader));
+	file_name_ = file_name;
+
+	size_t size = file_.size();
+	const FlashPlanHeader *header = (const FlashPlanHeader *)file_.data();
+	if (!header->block_size || header->block_count >
+			(size - sizeof(FlashPlanHeader)) / sizeof(FlashPlanBlock))
+		mapped_file_error(file_name, "bad block table");
+
+	const FlashPlanBlock *blocks = (const FlashPlanBlock *)(header + 1);
+	uint_t next_address = 0;
+	for (size_t i = 0; i < header->block_count; i++)
+	{
+		const FlashPlanBlock &block = blocks[i];
+		if (block.address < next_address ||
+				block.address % header->block_size ||
+				block.size > header->block_size ||
+				block.address > header->flash_size ||
+				block.size > header->flash_size - block.address ||
+				block.data_offset % MAPPED_FILE_DATA_ALIGNMENT ||
+				block.data_offset > size || block.size > size - block.data_offset)
+			mapped_file_error(file_name, "bad block " + number_to_string(i));
+
+		next_address = block.address + block.size;
+	}
+
+	header_ = header;
+	blocks_ = blocks;
+}
+
+//==============================================================================
+void FlashPlan::close()
+{
+	file_.close();
+	file_name_.clear();
+	header_ = NULL;
+	blocks_ = NULL;
+}
+
+//==============================================================================
+bool FlashPlan::opened() const
+{	return header_ != NULL; }
+
+//==============================================================================
+const FlashPlanHeader &FlashPlan::header() const
+{	return *header_; }
+
+//==============================================================================
+const String &FlashPlan::file_name() const
+{	return file_name_; }
+
+//==============================================================================
+size_t FlashPlan::block_count() const
+{	return header_ ? header_->block_count : 0; }
+
+//==============================================================================
+const FlashPlanBlock &FlashPlan::block(size_t index) const
+{	return blocks_[index]; }
+
+//==============================================================================
+const uint8_t *FlashPlan::block_data(size_t index) const
+{	return (const uint8_t *)file_.data() + blocks_[index].data_offset; }
+
+//==============================================================================
+void FlashPlan::get_sections(DataSectionStore &store) const
+{
+	size_t first = 0;
+	while (first < block_count())
+	{
+		size_t last = first + 1;
+		size_t size = blocks_[first].size;
+		while (last < block_count() &&
+				blocks_[last].address == blocks_[last - 1].address + blocks_[last - 1].size)
+			size += blocks_[last++].size;
+
+		DataSection section;
+		section.address = blocks_[first].address;
+		section.data.resize(size);
+
+		size_t offset = 0;
+		for (size_t i = first; i < last; i++)
+		{
+			memcpy(&section.data[offset], block_data(i), blocks_[i].size);
+			offset += blocks_[i].size;
+		}
+		store.take_section(section, true);
+		first = last;
+	}
+}
+
+//==============================================================================
+void FlashPlan::get_block_crcs(FlashBlockCrcList &blocks) const
+{
+	blocks.resize(block_count());
+	for (size_t i = 0; i < block_count(); i++)
+	{
+		blocks[i].address = blocks_[i].address;
+		blocks[i].size = blocks_[i].size;
+		blocks[i].crc = blocks_[i].crc;
+	}
+}
+
+//==============================================================================
+void FlashPlan::save(const String &file_name, FlashPlanHeader &header,
+		const DataSectionStore &store)
+{
+	const uint8_t FILLER = 0xFF;
+
+	DataBlockView view;
+	view.reset(store, header.block_size, FILLER);
+
+	mapped_file_header_init(header.format, FLASH_PLAN_FORMAT);
+	header.block_count = view.used_block_count();
+
+	size_t data_offset = align_up(sizeof(FlashPlanHeader) +
+			header.block_count * sizeof(FlashPlanBlock), MAPPED_FILE_DATA_ALIGNMENT);
+	size_t block_step = align_up(header.block_size, MAPPED_FILE_DATA_ALIGNMENT);
+
+	ByteVector content(data_offset + header.block_count * block_step, FILLER);
+	memcpy(&content[0], &header, sizeof(header));
+
+	FlashPlanBlock *blocks = (FlashPlanBlock *)&content[sizeof(header)];
+	size_t n = 0;
+	for (size_t i = 0; i < view.block_count(); i++)
+	{
+		if (!view.block_used(i))
+			continue;
+
+		const uint8_t *data = view.block(i);
+		CrcCalculator crc_calc;
+		crc_calc.process_bytes(data, header.block_size);
+
+		FlashPlanBlock &block = blocks[n++];
+		block.address = i * header.block_size;
+		block.size = header.block_size;
+		block.data_offset = data_offset;
+		block.crc = crc_calc.checksum();
+		block.reserved = 0;
+
+		memcpy(&content[data_offset], data, header.block_size);
+		data_offset += block_step;
+	}
+
+	// a station mapping the plan never sees it partially written
+	file_replace(file_name, content);
+}
@@ -0,0 +1,97 @@
+/*
+ * flash_plan.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _FLASH_PLAN_H_
+#define _FLASH_PLAN_H_
+
+#include <boost/crc.hpp>
+#include "common.h"
+#include "data_section_store.h"
+#include "file.h"
+
+/// CRC16 of the target's DMA CRC unit (seed 0xFFFF)
+typedef boost::crc_optimal<16, 0x8005, 0xFFFF, 0, false, false> CrcCalculator;
+
+/// Flash block with expected CRC, the block must not cross a flash bank
+struct FlashBlockCrc
+{
+	uint_t address;
+	size_t size;
+	uint16_t crc;
+};
+
+typedef std::vector<FlashBlockCrc> FlashBlockCrcList;
+
+/// Split sections the way flash is verified by CRC: blocks of up to
+/// block_size from the beginning of a section, not crossing bank_size boundary
+void flash_block_crcs(const DataSectionStore &store, size_t block_size,
+		size_t bank_size, FlashBlockCrcList &blocks);
+
+/// Plan file layout, all fields are in host byte order:
+/// header, block table, data of blocks (MAPPED_FILE_DATA_ALIGNMENT aligned)
+struct FlashPlanHeader
+{
+	MappedFileHeader format;
+	char unit_name[16];
+	uint32_t unit_id;
+	uint32_t flash_size;	// bytes
+	uint32_t block_size;
+	uint32_t block_count;
+	uint32_t lock_offset;	// lock data slot, size is 0 if target has no one in flash
+	uint32_t lock_size;
+	uint32_t mac_offset;	// mac address slot
+	uint32_t mac_size;
+};
+
+struct FlashPlanBlock
+{
+	uint32_t address;
+	uint32_t size;
+	uint32_t data_offset;	// from the beginning of the file
+	uint16_t crc;
+	uint16_t reserved;
+};
+
+/// Flash image prepared for a target: aligned non-empty blocks with their
+/// CRC, so production run takes the image without parsing. The file is
+/// mapped to memory and block data are used in place.
+class FlashPlan : boost::noncopyable
+{
+public:
+	/// Map plan and check its consistency
+	void open(const String &file_name); // throw
+	void close();
+	bool opened() const;
+
+	const FlashPlanHeader &header() const;
+	const String &file_name() const;
+
+	size_t block_count() const;
+	const FlashPlanBlock &block(size_t index) const;
+	const uint8_t *block_data(size_t index) const;
+
+	/// Sections of adjacent blocks
+	void get_sections(DataSectionStore &store) const;
+	void get_block_crcs(FlashBlockCrcList &blocks) const;
+
+	/// Split store into aligned blocks of header.block_size, blank blocks
+	/// are skipped. Fields of header other than target description are set here
+	static void save(const String &file_name, FlashPlanHeader &header,
+			const DataSectionStore &store); // throw
+
+	FlashPlan();
+
+private:
+	MappedFile file_;
+	String file_name_;
+	const FlashPlanHeader *header_;
+	const FlashPlanBlock *blocks_;
+};
+
+#endif // !_FLASH_PLAN_H_
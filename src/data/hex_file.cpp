@@ -8,8 +8,6 @@
  *
  */
 
-#include <numeric>
-#include <fstream>
 #include "file.h"
 #include "hex_file.h"
 
@@ -30,9 +28,13 @@ public:
 		ERROR_SECTION_OVERLAPPING,
 	};
 
-	Error read_next_record(const String &record_line);
+	/// @param record text of the record without end of line, not empty
+	Error read_next_record(const char record[], size_t size);
 	Error read_complete();
 
+	/// Ranges of the last overlapping error
+	const AddressRangeList &overlaps() const;
+
 	HexDataReader(DataSectionStore &sections, bool ignore_crc);
 
 private:
@@ -42,6 +44,7 @@ private:
 	//Error error_;
 	DataSection section_;
 	bool ignore_crc_;
+	AddressRangeList overlaps_;
 };
 
 struct Record
@@ -57,15 +60,23 @@ struct Record
 		MAX_TYPE_NUMBER	= RT_START_LINEAR_ADDRESS,
 	};
 
+	enum {
+		HEADER_SIZE 	= 4, // size, address, type
+		MAX_DATA_SIZE 	= 0xFF,
+		// ':', header, data, checksum
+		MAX_TEXT_SIZE 	= 1 + (HEADER_SIZE + MAX_DATA_SIZE + 1) * 2
+	};
+
 	Type type;
 	uint_t address;
-	ByteVector data;
+	size_t size;
 };
 
 static void hex_file_error(
 		const String &file_name,
 		HexDataReader::Error error,
-		uint_t line_number); // throw
+		uint_t line_number,
+		const AddressRangeList &overlaps = AddressRangeList()); // throw
 
 //==============================================================================
 std::ostream& operator <<(std::ostream &os, const Record &o)
@@ -88,93 +99,59 @@ std::ostream& operator <<(std::ostream &os, const Record &o)
 
 	os << std::uppercase << std::hex << std::setfill('0');
 	os << "address: " << std::setw(8) << o.address  << ", ";
-	os << "size: " << std::dec << o.data.size();
+	os << "size: " << std::dec << o.size;
 
 	return os;
 }
 
-//==============================================================================
-static bool hex_to_byte(char low_part, char high_part, uint8_t &out_byte)
+/// Value of hex digit by character, 0xFF for other characters
+class HexDigitTable
 {
-	if (!isxdigit(low_part) || !isxdigit(high_part))
-		return false;
-
-	char buffer[3] = { low_part, high_part, 0 };
-	out_byte = strtoul(buffer, NULL, 16);
-	return true;
-}
+public:
+	uint8_t operator [](char c) const
+	{	return table_[(uint8_t)c]; }
 
-//==============================================================================
-static bool hex_to_binary(const char data[], size_t size, uint8_t out[])
-{
-	for (size_t i = 0; i < size; i += 2)
+	HexDigitTable()
 	{
-		if (!hex_to_byte(data[i], data[i + 1], out[i / 2]))
-			return false;
+		memset(table_, 0xFF, sizeof(table_));
+		for (uint8_t i = 0; i < 10; i++)
+			table_['0' + i] = i;
+		for (uint8_t i = 0; i < 6; i++)
+			table_['A' + i] = table_['a' + i] = 10 + i;
 	}
-	return true;
-}
 
-//==============================================================================
-static uint_t make_word(uint8_t low_byte, uint8_t high_byte, bool big_endian = true)
-{
-	return big_endian ? (low_byte << 8) | high_byte : (high_byte << 8) | low_byte;
-}
+private:
+	uint8_t table_[256];
+};
+
+static const HexDigitTable hex_digits;
 
 //==============================================================================
-static HexDataReader::Error parse_record(const String &line, Record &record, bool ignore_crc)
+/// Decode size bytes from 2 * size hex characters, bytes are added to crc
+/// @return false if there is a non hex character
+static bool hex_to_binary(const char data[], size_t size, uint8_t out[], uint8_t &crc)
 {
-	if (line[0] != ':')
-		return HexDataReader::ERROR_RECORD_NO_HEADER;
-
-	if (!(line.size() % 2) || line.size() > 1024)
-		return HexDataReader::ERROR_RECORD_SIZE_MISMATCH;
-
-	size_t record_size = line.size() / 2;
-	uint8_t data[record_size];
-
-	if (!hex_to_binary(line.c_str() + 1, line.size() - 1, data))
-		return HexDataReader::ERROR_RECORD_BAD_CHARACTER;
-
-	uint8_t crc = 0;
-	if (!ignore_crc && std::accumulate(data, data + record_size, crc) != 0)
-		return HexDataReader::ERROR_RECORD_CRC_MISMATCH;
-
-	uint8_t data_size = data[0];
-	if (data_size != (record_size - 5)) // 5 - header size
-		return HexDataReader::ERROR_RECORD_SIZE_MISMATCH;
-
-	uint8_t record_type = data[3];
-	if (record_type > Record::MAX_TYPE_NUMBER)
-		return HexDataReader::ERROR_RECORD_UNKNOWN_TYPE;
-
-	if (record_type == Record::RT_DATA)
-		record.data.assign(data + 4, data + 4 + data_size);
-	else
-		record.data.clear();
-
-	uint_t address = make_word(data[1], data[2]);
-
-	if (record_type == Record::RT_EX_SEGMENT_ADDRESS)
-	{
-		if (data_size != 2 || address)
-			return HexDataReader::ERROR_RECORD_BAD_FORMAT;
-
-		address = make_word(data[4], data[5]) << 4;
-	}
+	uint8_t sum = crc;
+	uint8_t invalid = 0;
 
-	if (record_type == Record::RT_EX_LINEAR_ADDRESS)
+	for (size_t i = 0; i < size; i++)
 	{
-		if (data_size != 2 || address)
-			return HexDataReader::ERROR_RECORD_BAD_FORMAT;
+		uint8_t high = hex_digits[data[i * 2]];
+		uint8_t low = hex_digits[data[i * 2 + 1]];
 
-		address = make_word(data[4], data[5]) << 16;
+		// only invalid characters have the high bit set
+		invalid |= high | low;
+		out[i] = (high << 4) | (low & 0x0F);
+		sum += out[i];
 	}
+	crc = sum;
+	return !(invalid & 0x80);
+}
 
-	record.type = (Record::Type)record_type;
-	record.address = address;
-
-	return HexDataReader::ERROR_OK;
+//==============================================================================
+static uint_t make_word(uint8_t low_byte, uint8_t high_byte, bool big_endian = true)
+{
+	return big_endian ? (low_byte << 8) | high_byte : (high_byte << 8) | low_byte;
 }
 
 //==============================================================================
@@ -187,26 +164,45 @@ HexDataReader::HexDataReader(DataSectionStore &store, bool ignore_crc) :
 
 // Do not pass empty lines here!
 //==============================================================================
-HexDataReader::Error HexDataReader::read_next_record(const String &record_line)
+HexDataReader::Error HexDataReader::read_next_record(const char line[], size_t size)
 {
+	if (line[0] != ':')
+		return ERROR_RECORD_NO_HEADER;
+
+	if (!(size % 2) || size > Record::MAX_TEXT_SIZE ||
+			size < 1 + (Record::HEADER_SIZE + 1) * 2)
+		return ERROR_RECORD_SIZE_MISMATCH;
+
+	uint8_t crc = 0;
+	uint8_t header[Record::HEADER_SIZE];
+	if (!hex_to_binary(line + 1, Record::HEADER_SIZE, header, crc))
+		return ERROR_RECORD_BAD_CHARACTER;
+
 	Record record;
+	record.size = header[0];
+	if (record.size != size / 2 - Record::HEADER_SIZE - 1)
+		return ERROR_RECORD_SIZE_MISMATCH;
 
-	HexDataReader::Error error = parse_record(record_line, record, ignore_crc_);
-	if (error != ERROR_OK)
-		return error;
+	if (header[3] > Record::MAX_TYPE_NUMBER)
+		return ERROR_RECORD_UNKNOWN_TYPE;
 
-	if (record.type == Record::RT_EOF)
-		return ERROR_OK;
+	record.type = (Record::Type)header[3];
+	record.address = make_word(header[1], header[2]);
+
+	const char *text = line + 1 + Record::HEADER_SIZE * 2;
+	uint8_t data[Record::MAX_DATA_SIZE];
 
 	if (record.type == Record::RT_DATA)
 	{
-		record.address |= address_prefix_;
+		record.address += address_prefix_;
 		if (section_started_ && section_.next_address() != record.address)
 		{
-			if (!store_.add_section(section_, false))
+			if (!store_.take_section(section_, false))
+			{
+				store_.find_overlaps(section_, overlaps_);
 				return ERROR_SECTION_OVERLAPPING;
+			}
 
-			section_.data.clear();
 			section_started_ = false;
 		}
 
@@ -215,13 +211,38 @@ HexDataReader::Error HexDataReader::read_next_record(const String &record_line)
 			section_started_ = true;
 			section_.address = record.address;
 		}
-		section_.data.insert(section_.data.end(), record.data.begin(), record.data.end());
+
+		// decode right into the section
+		size_t offset = section_.data.size();
+		section_.data.resize(offset + record.size);
+		if (record.size && !hex_to_binary(text, record.size, &section_.data[offset], crc))
+			return ERROR_RECORD_BAD_CHARACTER;
 	}
+	else if (!hex_to_binary(text, record.size, data, crc))
+		return ERROR_RECORD_BAD_CHARACTER;
+
+	uint8_t checksum = 0;
+	if (!hex_to_binary(text + record.size * 2, 1, &checksum, crc))
+		return ERROR_RECORD_BAD_CHARACTER;
+
+	if (!ignore_crc_ && crc)
+		return ERROR_RECORD_CRC_MISMATCH;
+
 	if (record.type == Record::RT_EX_SEGMENT_ADDRESS)
-		address_prefix_ = record.address;
+	{
+		if (record.size != 2 || record.address)
+			return ERROR_RECORD_BAD_FORMAT;
+
+		address_prefix_ = make_word(data[0], data[1]) << 4;
+	}
 
 	if (record.type == Record::RT_EX_LINEAR_ADDRESS)
-		address_prefix_ = record.address;
+	{
+		if (record.size != 2 || record.address)
+			return ERROR_RECORD_BAD_FORMAT;
+
+		address_prefix_ = make_word(data[0], data[1]) << 16;
+	}
 
 	return ERROR_OK;
 }
@@ -229,127 +250,245 @@ HexDataReader::Error HexDataReader::read_next_record(const String &record_line)
 //==============================================================================
 HexDataReader::Error HexDataReader::read_complete()
 {
-	if (section_started_ && !store_.add_section(section_, false))
+	if (section_started_ && !store_.take_section(section_, false))
+	{
+		store_.find_overlaps(section_, overlaps_);
 		return ERROR_SECTION_OVERLAPPING;
+	}
 	return ERROR_OK;
 }
 
+//==============================================================================
+const AddressRangeList &HexDataReader::overlaps() const
+{	return overlaps_; }
+
 //==============================================================================
 void hex_file_load(const String &file_name,
 		DataSectionStore &section_store, bool ignore_crc_mismatch)
 {
-	std::ifstream in(file_name.c_str());
-	if (!in)
-		throw std::runtime_error("Unable to open file " + file_name);
+	MappedFile file;
+	file.open(file_name);
 
 	HexDataReader::Error error = HexDataReader::ERROR_OK;
 	uint_t line_number = 0;
 
 	HexDataReader reader(section_store, ignore_crc_mismatch);
-	String record_line;
-	while (in)
+
+	const char *line = file.data();
+	const char *end = line + file.size();
+	while (line < end)
 	{
 		line_number++;
-		std::getline(in, record_line);
 
-		if (!record_line.empty() && *record_line.rbegin() == '\r')
-			record_line.erase(record_line.end() - 1);
+		const char *next = (const char *)memchr(line, '\n', end - line);
+		if (!next)
+			next = end;
 
-		if (record_line.empty())
-			continue;
+		size_t size = next - line;
+		if (size && line[size - 1] == '\r')
+			size--;
 
-		error = reader.read_next_record(record_line);
-		if (error != HexDataReader::ERROR_OK)
-			hex_file_error(file_name, error, line_number);
+		if (size)
+		{
+			error = reader.read_next_record(line, size);
+			if (error != HexDataReader::ERROR_OK)
+				hex_file_error(file_name, error, line_number, reader.overlaps());
+		}
+		line = next + 1;
 	}
 
 	error = reader.read_complete();
 	if (error != HexDataReader::ERROR_OK)
-		hex_file_error(file_name, error, line_number);
-
-	//return section_store;
+		hex_file_error(file_name, error, line_number, reader.overlaps());
 }
 
+/// Hex text of all byte values
+class HexByteTable
+{
+public:
+	const char *operator [](uint8_t byte) const
+	{	return table_[byte]; }
+
+	HexByteTable()
+	{
+		const char DIGITS[] = "0123456789ABCDEF";
+		for (size_t i = 0; i < 256; i++)
+		{
+			table_[i][0] = DIGITS[i >> 4];
+			table_[i][1] = DIGITS[i & 0x0F];
+		}
+	}
+
+private:
+	char table_[256][2];
+};
+
+static const HexByteTable hex_bytes;
+
 //==============================================================================
-static void write_eof_record(std::ostream &out)
+static char *binary_to_hex(const uint8_t data[], size_t size, char out[], uint8_t &crc)
 {
-	out << ":00000001FF";
-	out << "\r\n";
+	for (size_t i = 0; i < size; i++)
+	{
+		memcpy(out, hex_bytes[data[i]], 2);
+		out += 2;
+		crc += data[i];
+	}
+	return out;
 }
 
 //==============================================================================
-static void write_data_record(std::ostream &out, uint_t address,
+/// @return position right after the record
+static char *write_record(char out[], uint8_t type, uint16_t address,
 		const uint8_t data[], size_t size)
 {
-	const uint8_t buffer[] = { LOBYTE(size), HIBYTE(address), LOBYTE(address), 0x00 };
+	const uint8_t header[] = { LOBYTE(size), HIBYTE(address), LOBYTE(address), type };
 
 	uint8_t crc = 0;
-	crc = std::accumulate(buffer, buffer + ARRAY_SIZE(buffer), crc);
-	crc = std::accumulate(data, data + size, crc);
-	crc = 0x100 - crc;
-
-	out << ":";
-	out << binary_to_hex(buffer, ARRAY_SIZE(buffer));
-	out << binary_to_hex(data, size);
-	out << binary_to_hex(&crc, 1);
-	out << "\r\n";
+	*out++ = ':';
+	out = binary_to_hex(header, ARRAY_SIZE(header), out, crc);
+	out = binary_to_hex(data, size, out, crc);
+
+	uint8_t checksum = 0x100 - crc;
+	out = binary_to_hex(&checksum, 1, out, crc);
+	*out++ = '\r';
+	*out++ = '\n';
+	return out;
 }
 
+const size_t SEGMENT_SIZE = 0x10000; // addressed by a data record
+
 //==============================================================================
-static void write_segment_record(std::ostream &out, uint16_t address)
+HexWriter::HexWriter(File &file, size_t record_size, size_t buffer_size) :
+		file_(file),
+		record_size_(record_size),
+		text_(std::max<size_t>(buffer_size, Record::MAX_TEXT_SIZE + 2)),
+		text_size_(0),
+		segment_(0),
+		record_address_(0)
 {
-	const uint8_t buffer[] = { 0x02, 0x00, 0x00, 0x02, HIBYTE(address), LOBYTE(address) };
+	if (!record_size || record_size > Record::MAX_DATA_SIZE)
+		throw std::runtime_error("invalid hex record size " +
+				number_to_string(record_size));
+	record_.reserve(record_size);
+}
 
-	uint8_t crc = 0;
-	crc = 0x100 - std::accumulate(buffer, buffer + ARRAY_SIZE(buffer), crc);
+//==============================================================================
+void HexWriter::write(uint_t address, const uint8_t data[], size_t size)
+{
+	while (size)
+	{
+		if (!record_.empty() && record_address_ + record_.size() != address)
+			flush_record();
+
+		if (record_.empty())
+			record_address_ = address;
+
+		// records don't cross segment boundary
+		size_t limit = std::min<size_t>(record_size_,
+				SEGMENT_SIZE - record_address_ % SEGMENT_SIZE);
+		size_t count = std::min(size, limit - record_.size());
 
-	out << ":";
-	out << binary_to_hex(buffer, ARRAY_SIZE(buffer));
-	out << binary_to_hex(&crc, 1);
-	out << "\r\n";
+		if (record_.empty() && count == limit)
+			put_data_record(address, data, count);
+		else
+		{
+			record_.insert(record_.end(), data, data + count);
+			if (record_.size() == limit)
+				flush_record();
+		}
+
+		address += count;
+		data += count;
+		size -= count;
+	}
 }
 
 //==============================================================================
-void hex_file_save(const String &file_name, const DataSectionStore &section_store)
+void HexWriter::finish()
 {
-	std::ofstream out(file_name.c_str());
-	if (!out)
-		throw FileException("Unable to open file" + file_name);
+	flush_record();
+	put_record(Record::RT_EOF, 0, NULL, 0);
+	flush_text();
+}
 
-	uint_t offset = 0;
-	foreach (const DataSection &section, section_store.sections())
+//==============================================================================
+void HexWriter::put_data_record(uint_t address, const uint8_t data[], size_t size)
+{
+	if (address / SEGMENT_SIZE != segment_)
 	{
-		uint_t address = section.address;
-		uint_t size    = section.size();
+		segment_ = address / SEGMENT_SIZE;
 
-		while (size)
-		{
-			if ((address - offset) > 0xFFFF)
-			{
-				offset = address & ~0x0F;
-				write_segment_record(out, offset >> 4);
-			}
+		const uint8_t segment[] = { HIBYTE(segment_), LOBYTE(segment_) };
+		put_record(Record::RT_EX_LINEAR_ADDRESS, 0, segment, ARRAY_SIZE(segment));
+	}
+	put_record(Record::RT_DATA, address % SEGMENT_SIZE, data, size);
+}
+
+//==============================================================================
+void HexWriter::put_record(uint8_t type, uint16_t address,
+		const uint8_t data[], size_t size)
+{
+	if (text_size_ + Record::MAX_TEXT_SIZE + 2 > text_.size())
+		flush_text();
 
-			const uint_t RECORD_MAX_DATA_SIZE = 16;
-			const uint_t record_size = std::min(RECORD_MAX_DATA_SIZE, size);
+	char *start = (char *)&text_[0];
+	char *end = write_record(start + text_size_, type, address, data, size);
+	text_size_ = end - start;
+}
 
-			write_data_record(out,
-					address - offset,
-					&section.data[address - section.address],
-					record_size);
+//==============================================================================
+void HexWriter::flush_record()
+{
+	if (record_.empty())
+		return;
 
-			address += record_size;
-			size -= record_size;
-		}
-	}
-	write_eof_record(out);
+	put_data_record(record_address_, &record_[0], record_.size());
+	record_.clear();
+}
+
+//==============================================================================
+void HexWriter::flush_text()
+{
+	if (text_size_)
+		file_.write(&text_[0], text_size_);
+	text_size_ = 0;
+}
+
+//==============================================================================
+void hex_file_save(const String &file_name, const DataSectionStore &section_store,
+		size_t record_size)
+{
+	// ':', header, checksum, end of line
+	const size_t RECORD_OVERHEAD = 1 + (Record::HEADER_SIZE + 1) * 2 + 2;
+
+	// Upper bound of the text size, the whole file is written at once.
+	// Records are split at segment boundaries, there is an extended linear
+	// address record per segment
+	size_t record_count = 1;
+	foreach (const DataSection &section, section_store.sections())
+		record_count += section.size() / std::max<size_t>(record_size, 1) + 1 +
+				(section.size() / SEGMENT_SIZE + 2) * 2;
+
+	File file;
+	HexWriter writer(file, record_size, section_store.actual_size() * 2 +
+			record_count * (RECORD_OVERHEAD + 4));
+
+	file.open(file_name, "wb");
+
+	foreach (const DataSection &section, section_store.sections())
+		writer.write(section.address, &section.data[0], section.size());
+	writer.finish();
+
+	file.close();
 }
 
 //==============================================================================
 static void hex_file_error(
 		const String &file_name,
 		HexDataReader::Error error,
-		uint_t line_number)
+		uint_t line_number,
+		const AddressRangeList &overlaps)
 {
 	std::stringstream ss;
 
@@ -382,7 +521,8 @@ static void hex_file_error(
 		break;
 
 	case HexDataReader::ERROR_SECTION_OVERLAPPING:
-		ss << "Sections overlapped";
+		ss << "Sections overlapped at " << overlaps;
+		break;
 
 	case HexDataReader::ERROR_OK:
 	default:
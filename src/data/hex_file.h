@@ -13,6 +13,7 @@
 
 #include "common.h"
 #include "data_section_store.h"
+#include "file.h"
 
 class HexFile
 {
@@ -23,7 +24,40 @@ public:
 	static void save(const String &file_name, const DataSectionStore &section_store);
 };
 
+/// Data bytes per record written by default, up to 255 is allowed
+const size_t HEX_RECORD_SIZE = 32;
+
+/// Hex file written by blocks of data in ascending address order.
+/// A block adjacent to the previous one continues its record
+class HexWriter
+{
+public:
+	void write(uint_t address, const uint8_t data[], size_t size);
+
+	/// Write pending data and end of file record
+	void finish();
+
+	/// @param buffer_size text is written to the file by blocks of this size
+	HexWriter(File &file, size_t record_size = HEX_RECORD_SIZE,
+			size_t buffer_size = 64 * 1024);
+
+private:
+	void put_data_record(uint_t address, const uint8_t data[], size_t size);
+	void put_record(uint8_t type, uint16_t address, const uint8_t data[], size_t size);
+	void flush_record();
+	void flush_text();
+
+	File &file_;
+	size_t record_size_;
+	ByteVector text_;
+	size_t text_size_;
+	uint_t segment_;
+	uint_t record_address_;
+	ByteVector record_; // data of the record not completed yet
+};
+
 void hex_file_load(const String &file_name, DataSectionStore &section_store, bool ignore_crc_mismatch = false);
-void hex_file_save(const String &file_name, const DataSectionStore &section_store);
+void hex_file_save(const String &file_name, const DataSectionStore &section_store,
+		size_t record_size = HEX_RECORD_SIZE);
 
 #endif // !_HEX_FILE_H_
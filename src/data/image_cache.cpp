@@ -0,0 +1,316 @@
+/*
+ * image_cache.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+#include "hex_file.h"
+#include "image_cache.h"
+
+const MappedFileFormat IMAGE_CACHE_FORMAT =
+		{ "cache entry", { 'C', 'C', 'C', 'A', 'C', 'H', 'E', 0 }, 1 };
+
+/// Entry layout, all fields are in host byte order: header, path of the file,
+/// section table, data of sections, CRC lists (block size, count, blocks)
+struct ImageCacheHeader
+{
+	MappedFileHeader format;
+	uint64_t file_size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t content_hash;
+	uint32_t path_size;
+	uint32_t section_count;
+	uint32_t crc_list_count;
+	uint32_t reserved;
+};
+
+struct ImageCacheSection
+{
+	uint32_t address;
+	uint32_t size;
+};
+
+struct ImageCacheCrc
+{
+	uint32_t address;
+	uint32_t size;
+	uint16_t crc;
+	uint16_t reserved;
+};
+
+/// Reads entry fields one after another, fails on reading past the end
+class EntryReader
+{
+public:
+	/// @return NULL if there is not enough data
+	const uint8_t *take(size_t size)
+	{
+		if (size > size_ - offset_)
+			return NULL;
+		offset_ += size;
+		return data_ + offset_ - size;
+	}
+
+	template <class T> bool read(T &value)
+	{
+		const uint8_t *data = take(sizeof(value));
+		if (data)
+			memcpy(&value, data, sizeof(value));
+		return data != NULL;
+	}
+
+	EntryReader(const char data[], size_t size) :
+			data_((const uint8_t *)data),
+			size_(size),
+			offset_(0)
+	{ }
+
+private:
+	const uint8_t *data_;
+	size_t size_;
+	size_t offset_;
+};
+
+//==============================================================================
+template <class T>
+static void put(ByteVector &entry, const T &value)
+{	vector_append(entry, (const uint8_t *)&value, sizeof(value)); }
+
+//==============================================================================
+/// Fast non-cryptographic hash to detect change of a file content
+static uint64_t content_hash(const uint8_t data[], size_t size)
+{
+	const uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+	uint64_t hash = 0xCBF29CE484222325ULL ^ size;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * MULTIPLIER;
+		hash ^= hash >> 32;
+	}
+	for (; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * MULTIPLIER;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+//==============================================================================
+/// Fill size, modification time and content hash of the file
+static bool read_file_stamp(const String &file_name, ImageCacheHeader &header)
+{
+	struct stat file_stat;
+	if (stat(file_name.c_str(), &file_stat) || !S_ISREG(file_stat.st_mode))
+		return false;
+
+	MappedFile file;
+	file.open(file_name);
+	if (file.size() != (size_t)file_stat.st_size)
+		return false; // changed while reading
+
+	header.file_size = file_stat.st_size;
+	header.mtime_sec = file_stat.st_mtim.tv_sec;
+	header.mtime_nsec = file_stat.st_mtim.tv_nsec;
+	header.content_hash = content_hash((const uint8_t *)file.data(), file.size());
+	return true;
+}
+
+//==============================================================================
+static bool read_entry(const String &entry_name, const String &path,
+		const ImageCacheHeader &stamp, DataSectionStore &store,
+		FlashBlockCrcMap &crcs)
+{
+	MappedFile entry;
+	try
+	{
+		mapped_file_open(entry, entry_name, IMAGE_CACHE_FORMAT,
+				sizeof(ImageCacheHeader));
+	}
+	catch (FileException &)
+	{
+		return false;
+	}
+
+	EntryReader reader(entry.data(), entry.size());
+	ImageCacheHeader header;
+	if (!reader.read(header) ||
+			header.file_size != stamp.file_size ||
+			header.mtime_sec != stamp.mtime_sec ||
+			header.mtime_nsec != stamp.mtime_nsec ||
+			header.content_hash != stamp.content_hash ||
+			header.path_size != path.size())
+		return false;
+
+	const uint8_t *entry_path = reader.take(header.path_size);
+	if (!entry_path || memcmp(entry_path, path.data(), path.size()))
+		return false;
+
+	const ImageCacheSection *sections = (const ImageCacheSection *)
+			reader.take(header.section_count * sizeof(ImageCacheSection));
+	if (!sections)
+		return false;
+
+	for (size_t i = 0; i < header.section_count; i++)
+	{
+		ImageCacheSection item;
+		memcpy(&item, &sections[i], sizeof(item));
+
+		const uint8_t *data = reader.take(item.size);
+		if (!data)
+			return false;
+
+		DataSection section(item.address, data, item.size);
+		if (!store.take_section(section, false))
+			return false;
+	}
+
+	for (size_t i = 0; i < header.crc_list_count; i++)
+	{
+		uint32_t block_size = 0, count = 0;
+		if (!reader.read(block_size) || !reader.read(count))
+			return false;
+
+		const ImageCacheCrc *items = (const ImageCacheCrc *)
+				reader.take(count * sizeof(ImageCacheCrc));
+		if (!items)
+			return false;
+
+		FlashBlockCrcList &blocks = crcs[block_size];
+		blocks.resize(count);
+		for (size_t n = 0; n < count; n++)
+		{
+			ImageCacheCrc item;
+			memcpy(&item, &items[n], sizeof(item));
+			blocks[n].address = item.address;
+			blocks[n].size = item.size;
+			blocks[n].crc = item.crc;
+		}
+	}
+	return true;
+}
+
+//==============================================================================
+/// Entry is written to a temporary file and renamed, so a reader never sees
+/// it incomplete
+static void write_entry(const String &entry_name, const ByteVector &entry)
+{
+	try
+	{
+		file_replace(entry_name, entry);
+	}
+	catch (FileException &)
+	{ }
+}
+
+//==============================================================================
+ImageCache::ImageCache() :
+		bank_size_(0)
+{ }
+
+//==============================================================================
+void ImageCache::set_crc_blocks(const UintVector &block_sizes, size_t bank_size)
+{
+	block_sizes_ = block_sizes;
+	bank_size_ = bank_size;
+}
+
+//==============================================================================
+void ImageCache::set_directory(const String &directory)
+{	directory_ = directory; }
+
+//==============================================================================
+bool ImageCache::enabled() const
+{	return !directory_.empty(); }
+
+//==============================================================================
+String ImageCache::default_directory()
+{
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	if (cache_home && *cache_home)
+		return String(cache_home) + "/cc-tool";
+
+	const char *home = getenv("HOME");
+	return String(home ? home : ".") + "/.cache/cc-tool";
+}
+
+//==============================================================================
+String ImageCache::entry_name(const String &path) const
+{
+	uint64_t hash = content_hash((const uint8_t *)path.data(), path.size());
+
+	uint8_t key[sizeof(hash)];
+	memcpy(key, &hash, sizeof(hash));
+	return directory_ + "/" + binary_to_hex(key, sizeof(key)) + ".cache";
+}
+
+//==============================================================================
+void ImageCache::hex_file_load(const String &file_name, DataSectionStore &store,
+		FlashBlockCrcMap &crcs) const
+{
+	ImageCacheHeader header;
+	memset(&header, 0, sizeof(header));
+
+	String path = boost::filesystem::absolute(file_name).string();
+	if (!enabled() || !read_file_stamp(file_name, header))
+	{
+		::hex_file_load(file_name, store);
+		return;
+	}
+
+	String entry_name = this->entry_name(path);
+	if (read_entry(entry_name, path, header, store, crcs))
+		return;
+
+	store.remove_sections();
+	crcs.clear();
+	::hex_file_load(file_name, store);
+
+	foreach (uint_t block_size, block_sizes_)
+		flash_block_crcs(store, block_size, bank_size_, crcs[block_size]);
+
+	mapped_file_header_init(header.format, IMAGE_CACHE_FORMAT);
+	header.path_size = path.size();
+	header.section_count = store.sections().size();
+	header.crc_list_count = crcs.size();
+
+	ByteVector entry;
+	entry.reserve(sizeof(header) + path.size() + store.actual_size() +
+			header.section_count * sizeof(ImageCacheSection));
+
+	put(entry, header);
+	vector_append(entry, (const uint8_t *)path.data(), path.size());
+
+	foreach (const DataSection &section, store.sections())
+	{
+		ImageCacheSection item = { section.address, (uint32_t)section.size() };
+		put(entry, item);
+	}
+	foreach (const DataSection &section, store.sections())
+		vector_append(entry, &section.data[0], section.size());
+
+	for (FlashBlockCrcMap::const_iterator it = crcs.begin(); it != crcs.end(); ++it)
+	{
+		put(entry, (uint32_t)it->first);
+		put(entry, (uint32_t)it->second.size());
+		foreach (const FlashBlockCrc &block, it->second)
+		{
+			ImageCacheCrc item = { block.address, (uint32_t)block.size, block.crc, 0 };
+			put(entry, item);
+		}
+	}
+
+	// a failure to cache doesn't fail loading
+	boost::system::error_code error;
+	boost::filesystem::create_directories(directory_, error);
+	write_entry(entry_name, entry);
+}
@@ -0,0 +1,53 @@
+/*
+ * image_cache.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _IMAGE_CACHE_H_
+#define _IMAGE_CACHE_H_
+
+#include <map>
+#include "common.h"
+#include "data_section_store.h"
+#include "flash_plan.h"
+
+/// Block CRCs of an image by verify block size
+typedef std::map<size_t, FlashBlockCrcList> FlashBlockCrcMap;
+
+/// On-disk cache of parsed hex files. An entry is found by the file path and
+/// is valid while size, modification time and content hash of the file match.
+/// Entry keeps sections of the file and their CRCs for every verify block
+/// size, so neither parsing nor CRC calculation is repeated.
+/// Methods may be called from several threads at once.
+class ImageCache
+{
+public:
+	/// @param bank_size CRC blocks don't cross its boundaries
+	void set_crc_blocks(const UintVector &block_sizes, size_t bank_size);
+
+	/// Empty directory disables the cache
+	void set_directory(const String &directory);
+	bool enabled() const;
+
+	/// Load file from the cache or parse it and update the cache
+	void hex_file_load(const String &file_name, DataSectionStore &store,
+			FlashBlockCrcMap &crcs) const; // throw
+
+	/// $XDG_CACHE_HOME/cc-tool or ~/.cache/cc-tool
+	static String default_directory();
+
+	ImageCache();
+
+private:
+	String entry_name(const String &file_name) const;
+
+	String directory_;
+	UintVector block_sizes_;
+	size_t bank_size_;
+};
+
+#endif // !_IMAGE_CACHE_H_
@@ -0,0 +1,73 @@
+/*
+ * image_pages.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include "data_block_view.h"
+#include "image_pages.h"
+
+//==============================================================================
+static uint16_t page_crc(const uint8_t data[], size_t size)
+{
+	CrcCalculator crc_calc;
+	crc_calc.process_bytes(data, size);
+	return crc_calc.checksum();
+}
+
+//==============================================================================
+void image_page_crcs(const DataSectionStore &store, size_t page_size,
+		FlashBlockCrcList &pages)
+{
+	DataBlockView view;
+	view.reset(store, page_size, PAGE_FILLER);
+
+	pages.reserve(pages.size() + view.used_block_count());
+	for (size_t i = 0; i < view.block_count(); i++)
+	{
+		if (!view.block_used(i))
+			continue;
+
+		FlashBlockCrc page;
+		page.address = i * page_size;
+		page.size = page_size;
+		page.crc = page_crc(view.block(i), page_size);
+		pages.push_back(page);
+	}
+}
+
+//==============================================================================
+void image_page_changes(const DataSectionStore &old_image,
+		const DataSectionStore &new_image, size_t page_size,
+		PageChangeList &changes)
+{
+	DataBlockView old_view, new_view;
+	old_view.reset(old_image, page_size, PAGE_FILLER);
+	new_view.reset(new_image, page_size, PAGE_FILLER);
+
+	ByteVector blank(page_size, PAGE_FILLER);
+	uint16_t blank_crc = page_crc(&blank[0], page_size);
+
+	size_t count = std::max(old_view.block_count(), new_view.block_count());
+	for (size_t i = 0; i < count; i++)
+	{
+		PageChange change;
+		change.old_blank = !old_view.block_used(i);
+		change.new_blank = !new_view.block_used(i);
+		if (change.old_blank && change.new_blank)
+			continue;
+
+		const uint8_t *old_data = change.old_blank ? &blank[0] : old_view.block(i);
+		const uint8_t *new_data = change.new_blank ? &blank[0] : new_view.block(i);
+		if (!memcmp(old_data, new_data, page_size))
+			continue;
+
+		change.address = i * page_size;
+		change.old_crc = change.old_blank ? blank_crc : page_crc(old_data, page_size);
+		change.new_crc = change.new_blank ? blank_crc : page_crc(new_data, page_size);
+		changes.push_back(change);
+	}
+}
@@ -0,0 +1,42 @@
+/*
+ * image_pages.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _IMAGE_PAGES_H_
+#define _IMAGE_PAGES_H_
+
+#include "common.h"
+#include "data_section_store.h"
+#include "flash_plan.h"
+
+/// Flash content is compared by pages as it's erased: a page holds data of
+/// the image and 0xFF (erased flash) elsewhere
+const uint8_t PAGE_FILLER = 0xFF;
+
+/// CRC of every page with data as target's DMA CRC unit computes it
+void image_page_crcs(const DataSectionStore &store, size_t page_size,
+		FlashBlockCrcList &pages);
+
+/// Page which content differs in two images, CRC of blank page is the CRC
+/// of erased flash
+struct PageChange
+{
+	uint_t address;
+	bool old_blank;
+	bool new_blank;
+	uint16_t old_crc;
+	uint16_t new_crc;
+};
+
+typedef std::vector<PageChange> PageChangeList;
+
+void image_page_changes(const DataSectionStore &old_image,
+		const DataSectionStore &new_image, size_t page_size,
+		PageChangeList &changes);
+
+#endif // !_IMAGE_PAGES_H_
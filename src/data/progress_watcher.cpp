@@ -8,8 +8,23 @@
  *
  */
 
+#include "trace.h"
 #include "progress_watcher.h"
 
+//==============================================================================
+/// Add throughput since the previous call to the trace counter track
+static void trace_throughput(const char name[], uint_t done_chunk,
+		uint64_t &last_time)
+{
+	if (!trace_get().enabled())
+		return;
+
+	uint64_t time = get_monotonic_time();
+	if (last_time && time > last_time)
+		trace_get().counter(name, done_chunk * 1000000.0 / 1024 / (time - last_time));
+	last_time = time;
+}
+
 //==============================================================================
 void ProgressWatcher::do_on_read_progress(const OnProgress::slot_type &slot)
 {	on_read_progress_.connect(slot); }
@@ -25,6 +40,7 @@ void ProgressWatcher::read_progress(uint_t done_chunk)
 	{
 		done_read_ += done_chunk;
 		on_read_progress_(done_read_, total_read_);
+		trace_throughput("read, KB/s", done_chunk, last_progress_time_);
 	}
 }
 
@@ -35,6 +51,7 @@ void ProgressWatcher::write_progress(uint_t done_chunk)
 	{
 		done_write_ += done_chunk;
 		on_write_progress_(done_write_, total_write_);
+		trace_throughput("write, KB/s", done_chunk, last_progress_time_);
 	}
 }
 
@@ -47,6 +64,7 @@ void ProgressWatcher::read_start(size_t total_size)
 	read_started_ = true;
 	total_read_ = total_size;
 	done_read_ = 0;
+	last_progress_time_ = get_monotonic_time();
 }
 
 //==============================================================================
@@ -69,6 +87,7 @@ void ProgressWatcher::write_start(size_t total_size)
 	write_started_ = true;
 	total_write_ = total_size;
 	done_write_ = 0;
+	last_progress_time_ = get_monotonic_time();
 }
 
 //==============================================================================
@@ -94,5 +113,6 @@ ProgressWatcher::ProgressWatcher() :
 		write_started_(false),
 		done_read_(0),
 		done_write_(0),
+		last_progress_time_(0),
 		enabled_(true)
 { }
@@ -42,6 +42,7 @@ private:
 	bool write_started_;
 	uint_t done_read_;
 	uint_t done_write_;
+	uint64_t last_progress_time_;
 	bool enabled_;
 	OnProgress on_read_progress_;
 	OnProgress on_write_progress_;
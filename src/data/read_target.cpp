@@ -10,9 +10,6 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
-#include "data/data_section_store.h"
-#include "data/hex_file.h"
-#include "data/binary_file.h"
 #include "read_target.h"
 #include "common/common.h"
 
@@ -26,28 +23,99 @@ static String file_extention(const String path)
 #endif
 }
 
+//==============================================================================
+static uint_t range_number(const String &text, const String &input)
+{
+	char *bad_character = NULL;
+	unsigned long long number = strtoull(text.c_str(), &bad_character, 0);
+	if (text.empty() || *bad_character != '\0' || number > 0xFFFFFFFFULL)
+		throw std::runtime_error("bad address range (" + input + ")");
+	return number;
+}
+
+//==============================================================================
+static void extract_address_range(const String &text, const String &input,
+		AddressRange &range)
+{
+	size_t plus = text.find('+');
+	if (plus == String::npos)
+		throw std::runtime_error("address range must be 'address+size' (" + input + ")");
+
+	range.begin = range_number(text.substr(0, plus), input);
+	uint_t size = range_number(text.substr(plus + 1), input);
+	if (!size || size > 0xFFFFFFFFU - range.begin)
+		throw std::runtime_error("bad address range (" + input + ")");
+	range.end = range.begin + size;
+}
+
 //==============================================================================
 ReadTarget::ReadTarget() :
+			hex_record_size_(HEX_RECORD_SIZE),
 			source_type_(ST_CONSOLE)
 { }
 
+//==============================================================================
+void ReadTarget::set_hex_record_size(size_t record_size)
+{	hex_record_size_ = record_size; }
+
 //==============================================================================
 ReadTarget::SourceType ReadTarget::source_type() const
 {	return source_type_; }
 
 //==============================================================================
-void ReadTarget::on_read(const ByteVector &data) const
+bool ReadTarget::standard_output() const
+{	return source_type_ == ST_FILE && file_name_ == "-"; }
+
+//==============================================================================
+const AddressRange &ReadTarget::range() const
+{	return range_; }
+
+//==============================================================================
+void ReadTarget::open()
 {
+	if (source_type_ != ST_FILE)
+		return;
+
+	if (standard_output())
+		file_.attach(stdout, "stdout");
+	else
+		file_.open(file_name_, "wb");
+
 	if (file_format_ == "hex")
+		hex_writer_.reset(new HexWriter(file_, hex_record_size_));
+}
+
+//==============================================================================
+void ReadTarget::write(size_t offset, const uint8_t data[], size_t size)
+{
+	if (source_type_ != ST_FILE)
+		return;
+
+	if (hex_writer_)
+		hex_writer_->write(offset, data, size);
+	else
+		file_.write(data, size);
+}
+
+//==============================================================================
+void ReadTarget::close()
+{
+	if (hex_writer_)
 	{
-		DataSectionStore store;
-		store.add_section(DataSection(0, data), true);
-		hex_file_save(file_name_, store);
+		hex_writer_->finish();
+		hex_writer_.reset();
 	}
-	if (file_format_ == "bin")
-		binary_file_save(file_name_, data);
+	file_.close();
 }
 
+//==============================================================================
+void ReadTarget::on_read(const ByteVector &data)
+{
+	open();
+	if (!data.empty())
+		write(0, &data[0], data.size());
+	close();
+}
 
 //==============================================================================
 void ReadTarget::set_source(const String &input)
@@ -59,6 +127,11 @@ void ReadTarget::set_source(const String &input)
 		OptionFileInfo file_info;
 		option_extract_file_info(input, file_info, false);
 
+		// '@address+size' alone is dumped to console
+		range_ = file_info.range;
+		if (file_info.name.empty())
+			return;
+
 		source_type_ = ST_FILE;
 		file_format_ = file_info.type;
 		file_name_ = file_info.name;
@@ -69,8 +142,17 @@ void ReadTarget::set_source(const String &input)
 void option_extract_file_info(const String &input, OptionFileInfo &file_info,
 		bool support_offset)
 {
+	file_info.range = AddressRange();
+	String name = input;
+	size_t at = input.rfind('@');
+	if (at != String::npos)
+	{
+		extract_address_range(input.substr(at + 1), input, file_info.range);
+		name.erase(at);
+	}
+
 	StringVector strs;
-	boost::split(strs, input, boost::is_any_of(":"));
+	boost::split(strs, name, boost::is_any_of(":"));
 
 	if (strs.size() > 3)
 		throw std::runtime_error("bad file name format (" + input + ")");
@@ -101,6 +183,9 @@ void option_extract_file_info(const String &input, OptionFileInfo &file_info,
 		type = "bin";
 	if (file_info.type == "hex" || file_info.type == "ihex")
 		type = "hex";
+	// flash plan is only read, offset is supported for input files
+	if (file_info.type == "plan" && support_offset)
+		type = "plan";
 	if (type.empty())
 		throw std::runtime_error("unknown file type (" + input + ")");
 	file_info.type = type;
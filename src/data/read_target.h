@@ -11,33 +11,64 @@
 #ifndef _READ_TARGET_H_
 #define _READ_TARGET_H_
 
+#include <boost/scoped_ptr.hpp>
 #include "common.h"
+#include "data_sink.h"
+#include "file.h"
+#include "hex_file.h"
+#include "data_section.h"
 
 struct OptionFileInfo
 {
 	String type;
 	String name;
 	size_t offset;
+	AddressRange range; // empty if whole file/flash is meant
 };
 
+/// Parse 'file_name[:type[:offset]][@address+size]', numbers of the range
+/// are decimal or hexadecimal with 0x prefix
 void option_extract_file_info(const String &input, OptionFileInfo &file_info,
 		bool support_offset);
 
-class ReadTarget
+/// Destination of data read from target: binary or hex file, file name '-'
+/// means standard output
+class ReadTarget : public DataSink
 {
 public:
 	enum SourceType { ST_CONSOLE, ST_FILE };
 
 	SourceType source_type() const;
 	void set_source(const String &input);
-	void on_read(const ByteVector &data) const;
+
+	/// @return true if data is written to standard output
+	bool standard_output() const;
+
+	/// Flash range to read, empty for the whole flash
+	const AddressRange &range() const;
+
+	/// Data bytes per record of hex file
+	void set_hex_record_size(size_t record_size);
+
+	/// Open the file, then data is written as it comes
+	void open();
+	virtual void write(size_t offset, const uint8_t data[], size_t size);
+	void close();
+
+	/// Write all data at once
+	void on_read(const ByteVector &data);
 
 	ReadTarget();
 
 private:
+	size_t hex_record_size_;
 	String file_format_;
 	String file_name_;
+	AddressRange range_;
 	SourceType source_type_;
+
+	File file_;
+	boost::scoped_ptr<HexWriter> hex_writer_;
 };
 
 #endif // !_READ_TARGET_H_
@@ -0,0 +1,226 @@
+/*
+ * symbol_map.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <algorithm>
+#include <map>
+#include <boost/regex.hpp>
+#include <boost/algorithm/string.hpp>
+#include "symbol_map.h"
+
+// Banked code is linked at bank << 16 | 0x8000..0xFFFF
+const uint_t CODE_BANK_SIZE = 0x8000;
+
+// Function without end in the last position isn't stretched further
+const uint_t MAX_OPEN_SYMBOL_SIZE = 0x1000;
+
+//==============================================================================
+static void symbol_map_error(const String &file_name, const String &message)
+{	throw FileException("File '" + file_name + "' load error: " + message); }
+
+//==============================================================================
+static uint_t code_offset(uint_t address)
+{
+	uint_t bank = address >> 16;
+	uint_t near = address & 0xFFFF;
+	if (!bank || near < CODE_BANK_SIZE)
+		return near;
+	return bank * CODE_BANK_SIZE + near - CODE_BANK_SIZE;
+}
+
+//==============================================================================
+static uint_t parse_hex(const String &str)
+{	return strtoul(str.c_str(), NULL, 16); }
+
+//==============================================================================
+static bool symbol_less(const CodeSymbol &left, const CodeSymbol &right)
+{	return left.address < right.address; }
+
+//==============================================================================
+static bool address_less(uint_t address, const CodeSymbol &symbol)
+{	return address < symbol.address; }
+
+//==============================================================================
+SymbolMap::SymbolMap() :
+		sorted_(true)
+{ }
+
+//==============================================================================
+void SymbolMap::add(uint_t address, uint_t end, const String &name)
+{
+	CodeSymbol symbol;
+	symbol.address = address;
+	symbol.end = end;
+	symbol.name = name;
+	symbols_.push_back(symbol);
+	sorted_ = false;
+}
+
+//==============================================================================
+void SymbolMap::sort() const
+{
+	if (sorted_)
+		return;
+	std::stable_sort(symbols_.begin(), symbols_.end(), symbol_less);
+	sorted_ = true;
+}
+
+//==============================================================================
+const CodeSymbolVector &SymbolMap::symbols() const
+{
+	sort();
+	return symbols_;
+}
+
+//==============================================================================
+bool SymbolMap::empty() const
+{	return symbols_.empty(); }
+
+//==============================================================================
+const CodeSymbol *SymbolMap::find(uint_t address) const
+{
+	sort();
+
+	CodeSymbolVector::const_iterator it = std::upper_bound(symbols_.begin(),
+			symbols_.end(), address, address_less);
+	if (it == symbols_.begin())
+		return NULL;
+
+	CodeSymbolVector::const_iterator next = it--;
+	if (it->end)
+		return address < it->end ? &*it : NULL;
+
+	if (next != symbols_.end())
+		return &*it;
+	return address - it->address < MAX_OPEN_SYMBOL_SIZE ? &*it : NULL;
+}
+
+//==============================================================================
+const CodeSymbol *SymbolMap::find_by_name(const String &name) const
+{
+	foreach (const CodeSymbol &symbol, symbols_)
+		if (symbol.name == name)
+			return &symbol;
+	return NULL;
+}
+
+//==============================================================================
+void SymbolMap::load(const String &file_name)
+{
+	String extension = boost::algorithm::to_lower_copy(
+			file_name.substr(std::min(file_name.rfind('.'), file_name.size())));
+
+	if (extension == ".rel")
+		symbol_map_error(file_name, "object file is not linked, "
+				"use .map or .cdb of the firmware");
+
+	MappedFile file;
+	file.open(file_name);
+	std::istringstream in(String(file.data(), file.size()));
+
+	size_t count = symbols_.size();
+	if (extension == ".cdb")
+		load_cdb(in);
+	else
+		load_map(in);
+
+	if (symbols_.size() == count)
+		symbol_map_error(file_name, "no code symbols found");
+}
+
+//==============================================================================
+/// SDCC .map lists symbols by area:
+///   CSEG    00000062    0000012F =    303. bytes (REL,CON,CODE)
+///      C:  00000062  _main    main
+/// older versions have no 'C:' and print the value first: '0062  _main'.
+/// IAR ILINK lists entries with type: 'main  0x1234  0x2a  Code  Gb  main.o',
+/// XLINK lists entries after a segment line:
+///   Relative segment, address: CODE 0000008A - 000000F3 (0x6a bytes)
+///   main    0000008A    ?cmain (?cstartup)
+void SymbolMap::load_map(std::istream &in)
+{
+	const boost::regex SDCC_AREA("^(\\S+)\\s+[0-9A-Fa-f]+\\s+[0-9A-Fa-f]+\\s+=.*\\((.*)\\)\\s*$");
+	const boost::regex SDCC_CODE("^\\s*C:\\s+([0-9A-Fa-f]+)\\s+(\\S+).*$");
+	const boost::regex SDCC_VALUE("^\\s*([0-9A-Fa-f]{4,8})\\s+(\\S+).*$");
+	const boost::regex SDCC_AREA_LIMIT("^[sl]_\\w+$");
+	const boost::regex XLINK_SEGMENT("^.*segment, address:\\s*(\\w+).*$");
+	const boost::regex IAR_ENTRY("^\\s*([A-Za-z_?$][\\w?$.]*)\\s+(?:0x)?([0-9A-Fa-f]{4,8})\\b(.*)$");
+	const boost::regex ILINK_CODE("^\\s*(?:0x[0-9A-Fa-f]+\\s+)?Code\\b.*$");
+
+	bool code_area = false;
+	String line;
+	while (std::getline(in, line))
+	{
+		boost::algorithm::trim_right(line);
+		boost::smatch what;
+
+		if (boost::regex_match(line, what, SDCC_AREA))
+		{
+			code_area = what[2].str().find("CODE") != String::npos;
+			continue;
+		}
+		if (boost::regex_match(line, what, XLINK_SEGMENT))
+		{
+			code_area = what[1].str().find("CODE") != String::npos;
+			continue;
+		}
+
+		if (boost::regex_match(line, what, SDCC_CODE) ||
+				(code_area && boost::regex_match(line, what, SDCC_VALUE)))
+		{
+			String name = what[2];
+			if (boost::regex_match(name, SDCC_AREA_LIMIT))
+				continue;
+			if (name.size() > 1 && name[0] == '_') // C symbol
+				name.erase(0, 1);
+			add(code_offset(parse_hex(what[1])), 0, name);
+			continue;
+		}
+
+		if (boost::regex_match(line, what, IAR_ENTRY) &&
+				(code_area || boost::regex_match(what[3].str(), ILINK_CODE)))
+			add(code_offset(parse_hex(what[2])), 0, what[1]);
+	}
+}
+
+//==============================================================================
+/// SDCC debug info, function start and its last byte:
+///   L:G$main$0$0:62  L:XG$main$0$0:D3
+///   L:Fuart$send$0$0:1A4  L:XFuart$send$0$0:1C0 (static function)
+/// Globals have start records too, only symbols with end are taken.
+void SymbolMap::load_cdb(std::istream &in)
+{
+	const boost::regex CDB_LINKER("^L:(X?)(G|F[^$]*)\\$([^$]+)\\$[^:]*:([0-9A-Fa-f]+)\\s*$");
+
+	typedef std::map<String, uint_t> AddressMap;
+	AddressMap starts, ends;
+	std::map<String, String> names;
+
+	String line;
+	while (std::getline(in, line))
+	{
+		boost::smatch what;
+		if (!boost::regex_match(line, what, CDB_LINKER))
+			continue;
+
+		String key = what[2] + "$" + what[3];
+		uint_t address = code_offset(parse_hex(what[4]));
+		if (what[1].matched && what[1].length())
+			ends[key] = address + 1;
+		else
+			starts[key] = address;
+		names[key] = what[3];
+	}
+
+	foreach (const AddressMap::value_type &start, starts)
+	{
+		AddressMap::const_iterator end = ends.find(start.first);
+		if (end != ends.end() && end->second > start.second)
+			add(start.second, end->second, names[start.first]);
+	}
+}
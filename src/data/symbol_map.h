@@ -0,0 +1,59 @@
+/*
+ * symbol_map.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _SYMBOL_MAP_H_
+#define _SYMBOL_MAP_H_
+
+#include "common.h"
+#include "file.h"
+
+/// Firmware function, addresses are flash offsets (banked code included)
+struct CodeSymbol
+{
+	uint_t address;
+	uint_t end;		// first address after the function, 0 if unknown
+	String name;
+};
+
+typedef std::vector<CodeSymbol> CodeSymbolVector;
+
+/// Code symbols of the linked firmware, loaded from linker output:
+/// SDCC .map (aslink) or .cdb (debug info), IAR XLINK/ILINK .map.
+/// Banked addresses (bank << 16 | address) are converted to flash offsets.
+class SymbolMap
+{
+public:
+	/// Format is chosen by file extension
+	void load(const String &file_name); // throw
+
+	void add(uint_t address, uint_t end, const String &name);
+
+	/// Function the flash offset belongs to. Function without known end
+	/// lasts up to the next one.
+	/// @return NULL if address is not within a known function
+	const CodeSymbol *find(uint_t address) const;
+	/// @return NULL if there is no function of the name
+	const CodeSymbol *find_by_name(const String &name) const;
+
+	const CodeSymbolVector &symbols() const;
+	bool empty() const;
+
+	SymbolMap();
+
+private:
+	void sort() const;
+
+	void load_map(std::istream &in);
+	void load_cdb(std::istream &in);
+
+	mutable CodeSymbolVector symbols_;
+	mutable bool sorted_;
+};
+
+#endif // !_SYMBOL_MAP_H_
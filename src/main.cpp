@@ -9,10 +9,14 @@
  */
 
 #include "application/cc_flasher.h"
+#include "application/cc_image_tool.h"
 
 //==============================================================================
 int main(int argc, char **argv)
 {
+	if (argc > 1 && !strcmp(argv[1], "image"))
+		return CC_ImageTool().execute(argc - 1, argv + 1);
+
 	CC_Flasher cc_flasher;
 
 	return cc_flasher.execute(argc, argv) ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -12,40 +12,12 @@
 #include "cc_debug_interface.h"
 #include "cc_243x.h"
 
-const uint16_t XREG_FMAP = 0xDF9F;
+const uint16_t XREG_FMAP = CC_243x_Family::FMAP;
 
 //==============================================================================
 CC_243x::CC_243x(USB_Device &programmer, ProgressWatcher &pw) :
-		CC_UnitDriver(programmer, pw)
-{
-	UnitCoreInfo reg_info;
-
-	reg_info.lock_size 			= 1;
-	reg_info.flash_word_size	= 4;
-	reg_info.write_block_size	= 1024;
-	reg_info.verify_block_size	= 1024;
-	reg_info.xbank_offset		= 0x8000;
-	reg_info.dma0_cfg_offset	= 0x0800;
-	reg_info.dma_data_offset	= 0x0000;
-
-	reg_info.memctr		= 0xDFC7;
-	reg_info.fmap		= XREG_FMAP;
-	reg_info.faddrh		= 0xDFAD;
-	reg_info.faddrl		= 0xDFAC;
-	reg_info.fctl		= 0xDFAE;
-	reg_info.fwdata		= 0xDFAF;//
-	reg_info.rndh		= 0xDFBD;
-	reg_info.rndl		= 0xDFBC;
-	reg_info.dma0_cfgh	= 0xDFD5;
-	reg_info.dma0_cfgl	= 0xDFD4;
-	reg_info.dma_arm	= 0xDFD6;
-	reg_info.dma_req	= 0xDFD7;
-	reg_info.dma_irq	= 0xDFD1;
-
-	reg_info.fctl_write	= 0x02;
-
-	set_reg_info(reg_info);
-}
+		CC_FamilyDriver<CC_243x_Family>(programmer, pw)
+{ }
 
 //==============================================================================
 void CC_243x::supported_units(Unit_ID_List &units)
@@ -11,9 +11,9 @@
 #ifndef _CC_243X_H_
 #define _CC_243X_H_
 
-#include "cc_unit_driver.h"
+#include "cc_family_driver.h"
 
-class CC_243x : public CC_UnitDriver
+class CC_243x : public CC_FamilyDriver<CC_243x_Family>
 {
 public:
 	virtual void supported_units(Unit_ID_List &units);
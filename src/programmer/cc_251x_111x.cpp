@@ -11,40 +11,10 @@
 #include "cc_251x_111x.h"
 #include "cc_debug_interface.h"
 
-const uint16_t XDATA_RAM_OFFSET	= 0xF000;
-const uint16_t XDATA_SFR_OFFSET	= 0xDF00;
-
 //==============================================================================
 CC_251x_111x::CC_251x_111x(USB_Device &programmer, ProgressWatcher &pw) :
-		CC_UnitDriver(programmer, pw)
-{
-	UnitCoreInfo reg_info;
-
-	reg_info.lock_size 			= 1;
-	reg_info.flash_word_size	= 2;
-	reg_info.verify_block_size	= 512;
-	reg_info.write_block_size	= 512;
-	reg_info.xbank_offset		= 0;
-
-	reg_info.dma0_cfg_offset	= XDATA_RAM_OFFSET + 0x0F00;
-	reg_info.dma_data_offset	= XDATA_RAM_OFFSET + 0x0000;
-
-	reg_info.rndh		= 0xDFBD;
-	reg_info.rndl		= 0xDFBC;
-	reg_info.dma0_cfgh	= 0xDFD5;
-	reg_info.dma0_cfgl	= 0xDFD4;
-	reg_info.dma_arm	= 0xDFD6;
-	reg_info.dma_req	= 0xDFD7;
-	reg_info.dma_irq	= 0xDFD1;
-	reg_info.fctl		= 0xDFAE;
-	reg_info.fwdata		= 0xDFAF;
-	reg_info.faddrl		= 0xDFAC;
-	reg_info.faddrh		= 0xDFAD;
-
-	reg_info.fctl_write	= 0x02;
-
-	set_reg_info(reg_info);
-}
+		CC_FamilyDriver<CC_251x_111x_Family>(programmer, pw)
+{ }
 
 //==============================================================================
 void CC_251x_111x::supported_units(Unit_ID_List &units)
@@ -11,9 +11,9 @@
 #ifndef _CC_251X_111X_H_
 #define _CC_251X_111X_H_
 
-#include "cc_unit_driver.h"
+#include "cc_family_driver.h"
 
-class CC_251x_111x : public CC_UnitDriver
+class CC_251x_111x : public CC_FamilyDriver<CC_251x_111x_Family>
 {
 public:
 	virtual void supported_units(Unit_ID_List &units);
@@ -10,29 +10,40 @@
 
 #include <boost/regex.hpp>
 #include "log.h"
+#include "trace.h"
 #include "cc_253x_254x.h"
 
 #include "data/hex_file.h"
 #include "data/binary_file.h"
 
-const size_t LOCK_DATA_SIZE 	= 16;
+const size_t LOCK_DATA_SIZE 	= CC_253x_254x_Family::LOCK_SIZE;
 const size_t MAX_PAGE_COUNT 	= LOCK_DATA_SIZE * 8;
 const size_t INFO_PAGE_OFFSET 	= 0x7800;
 const size_t INFO_PAGE_SIZE 	= 0x800;
 
-const uint16_t XREG_DBGDATA 	= 0x6260;
-const uint16_t XREG_FWDATA 		= 0x6273;
-const uint16_t XREG_FCTL 		= 0x6270;
-const uint16_t XREG_FADDRL 		= 0x6271;
-const uint16_t XREG_FADDRH 		= 0x6272;
-const uint16_t XREG_DMA1CFGL 	= 0x70D2;
-const uint16_t XREG_DMA1CFGH 	= 0x70D3;
-const uint16_t XREG_DMAARM 		= 0x70D6;
-const uint16_t XREG_DMAREQ 		= 0x70D7;
-const uint16_t XREG_DMAIRQ 		= 0x70D1;
+const uint16_t XREG_DBGDATA 	= CC_253x_254x_Family::DBGDATA;
+const uint16_t XREG_FWDATA 		= CC_253x_254x_Family::FWDATA;
+const uint16_t XREG_FCTL 		= CC_253x_254x_Family::FCTL;
+const uint16_t XREG_FADDRL 		= CC_253x_254x_Family::FADDRL;
+const uint16_t XREG_FADDRH 		= CC_253x_254x_Family::FADDRH;
+const uint16_t XREG_DMA1CFGL 	= CC_253x_254x_Family::DMA1CFGL;
+const uint16_t XREG_DMA1CFGH 	= CC_253x_254x_Family::DMA1CFGH;
+const uint16_t XREG_DMAARM 		= CC_253x_254x_Family::DMAARM;
+const uint16_t XREG_DMAREQ 		= CC_253x_254x_Family::DMAREQ;
+const uint16_t XREG_DMAIRQ 		= CC_253x_254x_Family::DMAIRQ;
 
-const uint16_t XREG_MEMCTR 		= 0x70C7;
-const uint16_t XREG_FMAP 		= 0x709F;
+const uint16_t XREG_MEMCTR 		= CC_253x_254x_Family::MEMCTR;
+const uint16_t XREG_FMAP 		= CC_253x_254x_Family::FMAP;
+
+const uint8_t SFR_CLKCONSTA		= 0x9E;
+const uint8_t SFR_SLEEPCMD		= 0xBE;
+const uint8_t SFR_CLKCONCMD		= 0xC6;
+
+const uint8_t CLKCON_OSC		= 0x40; // 1: 16 MHz RC oscillator
+const uint8_t CLKCON_CLKSPD		= 0x07; // system clock divider
+const uint8_t SLEEPCMD_OSC_PD	= 0x04; // oscillator not selected is powered down
+
+const uint64_t XOSC_STABLE_TIMEOUT	= 100000; // us, typical startup is below 1 ms
 
 //==============================================================================
 static void read_range(const String& input, BoolVector& range,
@@ -71,36 +82,10 @@ static void read_range(const String& input, BoolVector& range,
 
 //==============================================================================
 CC_253x_254x::CC_253x_254x(USB_Device &usb_device, ProgressWatcher &pw) :
-		CC_UnitDriver(usb_device, pw)
-{
-	UnitCoreInfo reg_info;
-
-	reg_info.lock_size 			= 16;
-	reg_info.flash_word_size	= 4;
-	reg_info.write_block_size	= 1024;
-	reg_info.verify_block_size	= 1024;
-	reg_info.xbank_offset		= 0x8000;
-	reg_info.dma0_cfg_offset	= 0x0800;
-	reg_info.dma_data_offset	= 0x0000;
-
-	reg_info.memctr		= XREG_MEMCTR;
-	reg_info.fmap		= XREG_FMAP;
-	reg_info.faddrh		= XREG_FADDRH;
-	reg_info.faddrl		= XREG_FADDRL;
-	reg_info.fctl		= XREG_FCTL;
-	reg_info.fwdata		= XREG_FWDATA;
-	reg_info.rndh		= 0x70BD;
-	reg_info.rndl		= 0x70BC;
-	reg_info.dma0_cfgh	= 0x70D5;
-	reg_info.dma0_cfgl	= 0x70D4;
-	reg_info.dma_arm	= XREG_DMAARM;
-	reg_info.dma_req	= XREG_DMAREQ;
-	reg_info.dma_irq	= XREG_DMAIRQ;
-
-	reg_info.fctl_write	= 0x06;
-
-	set_reg_info(reg_info);
-}
+		CC_FamilyDriver<CC_253x_254x_Family>(usb_device, pw),
+		clkconcmd_(0),
+		sleepcmd_(0)
+{ }
 
 //==============================================================================
 void CC_253x_254x::supported_units(Unit_ID_List &units)
@@ -183,14 +168,12 @@ void CC_253x_254x::find_unit_info(UnitInfo &unit_info)
 		unit_info.flash_page_size = 1;
 		unit_info.max_flash_size = 32;
 
-		UnitCoreInfo reg_info(get_reg_info());
-
-		reg_info.write_block_size	= 512;
-		reg_info.verify_block_size	= 512;
-		reg_info.dma0_cfg_offset	= 0x0200;
-		set_reg_info(reg_info);
+		select_family_variant<CC_2543_2545_Family>();
 	}
 
+	// internal RAM is the last 256 bytes of SRAM (1..8 KB at xdata 0)
+	set_iram_offset(unit_info.ram_size * 1024 - 0x100);
+
 	read_xdata_memory(0x6249, 1, sfr);
 	unit_info.revision = sfr[0];
 
@@ -211,7 +194,7 @@ void CC_253x_254x::read_info_page(ByteVector &info_page)
 
 	while (total_size)
 	{
-		size_t count = std::min(XDATA_READ_CHUNK_SIZE, total_size);
+		size_t count = std::min(xdata_read_chunk_size_, total_size);
 		read_xdata_memory(address, count, data);
 		info_page.insert(info_page.end(), data.begin(), data.end());
 		total_size -= count;
@@ -255,14 +238,92 @@ bool CC_253x_254x::erase_check_comleted()
 	return !(status & DEBUG_STATUS_CHIP_ERASE_BUSY);
 }
 
+//==============================================================================
+bool CC_253x_254x::wait_sfr(uint8_t address, uint8_t mask, uint8_t expected,
+		uint64_t timeout)
+{
+	uint64_t start_time = usb_device_.transport_time();
+	uint_t polls = 0;
+	uint8_t value = 0;
+
+	do
+	{
+		read_sfr(address, value);
+		polls++;
+	}
+	while ((value & mask) != expected &&
+			usb_device_.transport_time() - start_time <= timeout);
+
+	add_poll_stats(polls, usb_device_.transport_time() - start_time);
+	return (value & mask) == expected;
+}
+
+//==============================================================================
+bool CC_253x_254x::clock_boost()
+{
+	TraceScope trace("clock_boost", "driver");
+
+	read_sfr(SFR_CLKCONCMD, clkconcmd_);
+	read_sfr(SFR_SLEEPCMD, sleepcmd_);
+	log_info("programmer, clock boost, CLKCONCMD: %02Xh, SLEEPCMD: %02Xh",
+			clkconcmd_, sleepcmd_);
+
+	// power up both oscillators and wait until the crystal is stable
+	write_sfr(SFR_SLEEPCMD, sleepcmd_ & ~SLEEPCMD_OSC_PD);
+
+	uint64_t start_time = usb_device_.transport_time();
+	uint_t polls = 0;
+	uint8_t status = 0;
+	do
+	{
+		read_debug_status(status);
+		polls++;
+	}
+	while (!(status & DEBUG_STATUS_OSCILLATOR_STABLE) &&
+			usb_device_.transport_time() - start_time <= XOSC_STABLE_TIMEOUT);
+	add_poll_stats(polls, usb_device_.transport_time() - start_time);
+
+	if (!(status & DEBUG_STATUS_OSCILLATOR_STABLE))
+	{
+		log_info("programmer, crystal oscillator isn't stable");
+		write_sfr(SFR_SLEEPCMD, sleepcmd_);
+		return false;
+	}
+
+	// 32 MHz crystal, undivided system clock, timer tick is kept
+	uint8_t clkcon = clkconcmd_ & ~(CLKCON_OSC | CLKCON_CLKSPD);
+	write_sfr(SFR_CLKCONCMD, clkcon);
+	if (!wait_sfr(SFR_CLKCONSTA, CLKCON_OSC | CLKCON_CLKSPD, 0, XOSC_STABLE_TIMEOUT))
+	{
+		log_info("programmer, clock switch failed");
+		clock_restore();
+		return false;
+	}
+	return true;
+}
+
+//==============================================================================
+void CC_253x_254x::clock_restore()
+{
+	TraceScope trace("clock_restore", "driver");
+
+	log_info("programmer, clock restore, CLKCONCMD: %02Xh, SLEEPCMD: %02Xh",
+			clkconcmd_, sleepcmd_);
+
+	// oscillator in use mustn't be powered down before the switch is done
+	write_sfr(SFR_CLKCONCMD, clkconcmd_);
+	wait_sfr(SFR_CLKCONSTA, CLKCON_OSC | CLKCON_CLKSPD,
+			clkconcmd_ & (CLKCON_OSC | CLKCON_CLKSPD), XOSC_STABLE_TIMEOUT);
+	write_sfr(SFR_SLEEPCMD, sleepcmd_);
+}
+
 //==============================================================================
 void CC_253x_254x::flash_select_bank(uint_t bank)
 {
 	log_info("programmer, set flash bank %u", bank);
 
-	uint8_t command[] = { 0xBE, 0x57, 0x75, 0x9F, LOBYTE(bank) };
-
-	usb_device_.bulk_write(endpoint_out_, sizeof(command), &command[0]);
+	// FMAP SFR is mapped to xdata, keep it known to the shadow
+	write_xdata_register(XREG_FMAP, LOBYTE(bank));
 }
 
 //==============================================================================
@@ -382,30 +443,35 @@ bool CC_253x_254x::config_write(const ByteVector &mac_address,
 	return memcmp(&check_block[0], &block[0], block.size()) == 0;
 }
 
+// Buffers for flash write
+const uint16_t ADDR_BUF0     	= 0x0000; // 1K
+const uint16_t ADDR_BUF1     	= 0x0400; // 1K
+const uint16_t ADDR_DMA_DESC 	= 0x0800; // 32 bytes
+
+const uint16_t PROG_BLOCK_SIZE 	= 1024;
+
 //==============================================================================
-void CC_253x_254x::flash_write(const DataSectionStore &sections)
+static bool slow_flash_write(uint_t unit_ID)
 {
-	if (unit_info_.ID == 0x2543 ||
-		unit_info_.ID == 0x2544 ||
-		unit_info_.ID == 0x2545)
+	return unit_ID == 0x2543 || unit_ID == 0x2544 || unit_ID == 0x2545;
+}
+
+//==============================================================================
+void CC_253x_254x::flash_write_prepare(const DataSectionStore &sections)
+{
+	if (slow_flash_write(unit_info_.ID))
 	{
-		write_flash_slow(sections);
+		CC_UnitDriver::flash_write_prepare(sections);
 		return;
 	}
 
-	// Buffers
-	const uint16_t ADDR_BUF0     = 0x0000; // 1K
-	const uint16_t ADDR_BUF1     = 0x0400; // 1K
-	const uint16_t ADDR_DMA_DESC = 0x0800; // 32 bytes
-
-	// DMA Channels
-	const uint8_t CH_DBG_TO_BUF0   = 0x02;
-	const uint8_t CH_DBG_TO_BUF1   = 0x04;
-	const uint8_t CH_BUF0_TO_FLASH = 0x08;
-	const uint8_t CH_BUF1_TO_FLASH = 0x10;
-
-	const uint16_t PROG_BLOCK_SIZE = 1024;
+	TraceScope trace("flash_write_prepare", "driver");
+	prepare_write_view(sections, PROG_BLOCK_SIZE);
+}
 
+//==============================================================================
+void CC_253x_254x::load_dma_descriptors()
+{
 	const uint8_t dma_desc[32] = {
 		// Debug Interface -> Buffer 0 (Channel 1)
 		HIBYTE(XREG_DBGDATA), // src[15:8]
@@ -440,28 +506,54 @@ void CC_253x_254x::flash_write(const DataSectionStore &sections)
 		0x42 // increment source
 	};
 
-	ByteVector xsfr;
-
 	// Load dma descriptors
-	write_xdata_memory(ADDR_DMA_DESC, dma_desc, sizeof(dma_desc));
+	load_xdata_block(ADDR_DMA_DESC, dma_desc, sizeof(dma_desc));
+}
 
-	// Set the pointer to the DMA descriptors
-	write_xdata_memory(XREG_DMA1CFGL, LOBYTE(ADDR_DMA_DESC));
-	write_xdata_memory(XREG_DMA1CFGH, HIBYTE(ADDR_DMA_DESC));
+//==============================================================================
+void CC_253x_254x::flash_write(const DataSectionStore &sections)
+{
+	if (slow_flash_write(unit_info_.ID))
+	{
+		write_flash_slow(sections);
+		return;
+	}
 
-	write_xdata_memory(XREG_FADDRL, 0);
-	write_xdata_memory(XREG_FADDRH, 0);
+	// DMA Channels
+	const uint8_t CH_DBG_TO_BUF0   = 0x02;
+	const uint8_t CH_DBG_TO_BUF1   = 0x04;
+	const uint8_t CH_BUF0_TO_FLASH = 0x08;
+	const uint8_t CH_BUF1_TO_FLASH = 0x10;
 
-	ByteVector data;
-	sections.create_image(FLASH_EMPTY_BYTE, data);
-	data.resize(align_up(sections.upper_address(), PROG_BLOCK_SIZE), FLASH_EMPTY_BYTE);
+	if (!write_prepared(sections))
+		flash_write_prepare(sections);
 
-	pw_.write_start(data.size());
+	DataBlockView &view = take_write_view();
+
+	// target may have been reset since prepare, don't rely on its RAM
+	load_dma_descriptors();
+
+	// Set the pointer to the DMA descriptors
+	write_xdata_register(XREG_DMA1CFGL, LOBYTE(ADDR_DMA_DESC));
+	write_xdata_register(XREG_DMA1CFGH, HIBYTE(ADDR_DMA_DESC));
+
+	pw_.write_start(view.block_count() * PROG_BLOCK_SIZE);
 
 	uint8_t dbg_arm, flash_arm;
-	for (size_t i = 0; i < (data .size() / PROG_BLOCK_SIZE); i++)
+	uint64_t write_start_time = 0;
+	size_t written = 0;
+	size_t next_block = (size_t)-1; // block FADDR points to
+	for (size_t i = 0; i < view.block_count(); i++)
 	{
-		if ((i & 0x0001) == 0)
+		pw_.write_progress(PROG_BLOCK_SIZE);
+
+		// erased flash is left as is, blank blocks are skipped
+		if (!view.block_used(i))
+			continue;
+
+		TraceScope trace("flash_write_block", "driver", "offset", i * PROG_BLOCK_SIZE);
+
+		if ((written & 0x0001) == 0)
 		{
 			dbg_arm = CH_DBG_TO_BUF0;
 			flash_arm = CH_BUF0_TO_FLASH;
@@ -474,24 +566,34 @@ void CC_253x_254x::flash_write(const DataSectionStore &sections)
 		// transfer next buffer (first buffer when i == 0)
 		write_xdata_memory(XREG_DMAARM, dbg_arm);
 
-		ByteVector command;
-		command.push_back(0xEE);
-		command.push_back(0x84);
-		command.push_back(0x00);
-		command.insert(command.end(), &data[i * PROG_BLOCK_SIZE],
-				&data[i * PROG_BLOCK_SIZE] + PROG_BLOCK_SIZE);
+		command_.clear();
+		command_.put_burst_write(PROG_BLOCK_SIZE);
+		command_.append(view.block(i), PROG_BLOCK_SIZE);
 
-		usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
+		usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
 
-		// wait for write to finish
-		while (read_xdata_memory(XREG_FCTL) & 0x80);
+		// wait for previous write to finish, its buffer is filled next time
+		if (written)
+			wait_flash_ready(write_start_time, flash_write_time(PROG_BLOCK_SIZE));
+
+		// flash controller advances FADDR, it's set only after a gap
+		if (i != next_block)
+		{
+			size_t faddr = i * PROG_BLOCK_SIZE / CC_253x_254x_Family::FLASH_WORD_SIZE;
+			write_xdata_register(XREG_FADDRL, LOBYTE(faddr));
+			write_xdata_register(XREG_FADDRH, HIBYTE(faddr));
+		}
 
 		write_xdata_memory(XREG_DMAARM, flash_arm);
-		write_xdata_memory(XREG_FCTL, 0x06);
+		write_xdata_memory(XREG_FCTL, CC_253x_254x_Family::FCTL_WRITE);
+		write_start_time = usb_device_.transport_time();
 
-		pw_.write_progress(PROG_BLOCK_SIZE);
+		next_block = i + 1;
+		written++;
 	}
-	while (read_xdata_memory(XREG_FCTL) & FCTL_BUSY); // wait for the last buffer
+	// wait for the last buffer
+	if (written)
+		wait_flash_ready(write_start_time, flash_write_time(PROG_BLOCK_SIZE));
 
 	pw_.write_finish();
 }
@@ -12,9 +12,9 @@
 #define _CC_253X_254X_H_
 
 #include "cc_debug_interface.h"
-#include "cc_unit_driver.h"
+#include "cc_family_driver.h"
 
-class CC_253x_254x : public CC_UnitDriver
+class CC_253x_254x : public CC_FamilyDriver<CC_253x_254x_Family>
 {
 public:
 	virtual void supported_units(Unit_ID_List &units);
@@ -22,9 +22,13 @@ public:
 	virtual void read_info_page(ByteVector &info_page);
 	virtual bool erase_check_comleted();
 
+	virtual bool clock_boost();
+	virtual void clock_restore();
+
 	/// @param offset must be at page boundaries
 	virtual void mac_address_read(size_t index, ByteVector &mac_address);
 	virtual void flash_write(const DataSectionStore &sections);
+	virtual void flash_write_prepare(const DataSectionStore &sections);
 	virtual bool config_write(const ByteVector &mac_address,
 			const ByteVector &lock_data);
 
@@ -40,9 +44,16 @@ public:
 
 private:
 	virtual void flash_read_block(size_t offset, size_t size, ByteVector &flash_data);
+	/// Descriptors of the double-buffered write
+	void load_dma_descriptors();
 
 //	void flash_read_page(uint16_t address, ByteVector &flash_data);
 	void flash_select_bank(uint_t bank);
+
+	/// Poll SFR until (value & mask) == expected
+	/// @return false on timeout
+	bool wait_sfr(uint8_t address, uint8_t mask, uint8_t expected,
+			uint64_t timeout);
 //	void flash_read_start();
 //	void flash_read_end();
 
@@ -50,6 +61,10 @@ private:
 	uint_t mac_address_offset() const;
 	/// Return absolute flash offset where lock data is stored
 	uint_t lock_data_offset() const;
+
+	// clock setting saved by clock_boost
+	uint8_t clkconcmd_;
+	uint8_t sleepcmd_;
 };
 
 #endif // !_CC_253X_2540_H_
@@ -0,0 +1,166 @@
+/*
+ * cc_debug_instr.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_DEBUG_INSTR_H_
+#define _CC_DEBUG_INSTR_H_
+
+#include <string.h>
+#include <boost/static_assert.hpp>
+#include "cc_debug_interface.h"
+
+/// 8051 instruction executed by the debug interface as it's sent to the
+/// programmer: tag, DEBUG_INSTR command with the operand count, opcode and
+/// operands. Bit 0 of the tag makes the programmer return accumulator
+/// to the host.
+template <uint8_t TAG_, uint8_t OPCODE_, uint8_t OPERANDS_ = 0>
+struct CC_Instr
+{
+	enum {
+		TAG 		= TAG_,
+		COMMAND 	= DEBUG_COMMAND_DEBUG_INSTR + OPERANDS_,
+		OPCODE 		= OPCODE_,
+		OPERANDS 	= OPERANDS_,
+		SIZE 		= 3 + OPERANDS_
+	};
+
+	/// @return position right after the instruction
+	static uint8_t *put(uint8_t *out)
+	{
+		BOOST_STATIC_ASSERT(OPERANDS == 0);
+		out[0] = TAG; out[1] = COMMAND; out[2] = OPCODE;
+		return out + SIZE;
+	}
+
+	/// Same as put, accumulator is returned to the host
+	static uint8_t *put_output(uint8_t *out)
+	{
+		BOOST_STATIC_ASSERT(OPERANDS == 0);
+		out[0] = TAG | 1; out[1] = COMMAND; out[2] = OPCODE;
+		return out + SIZE;
+	}
+
+	static uint8_t *put(uint8_t *out, uint8_t operand)
+	{
+		BOOST_STATIC_ASSERT(OPERANDS == 1);
+		out[0] = TAG; out[1] = COMMAND; out[2] = OPCODE; out[3] = operand;
+		return out + SIZE;
+	}
+
+	static uint8_t *put_output(uint8_t *out, uint8_t operand)
+	{
+		BOOST_STATIC_ASSERT(OPERANDS == 1);
+		out[0] = TAG | 1; out[1] = COMMAND; out[2] = OPCODE; out[3] = operand;
+		return out + SIZE;
+	}
+
+	static uint8_t *put(uint8_t *out, uint8_t operand1, uint8_t operand2)
+	{
+		BOOST_STATIC_ASSERT(OPERANDS == 2);
+		out[0] = TAG; out[1] = COMMAND; out[2] = OPCODE;
+		out[3] = operand1; out[4] = operand2;
+		return out + SIZE;
+	}
+};
+
+typedef CC_Instr<0x40, 0x00> 	CC_Nop;				// NOP
+typedef CC_Instr<0x5E, 0xE4> 	CC_ClrA;			// CLR A
+typedef CC_Instr<0x8E, 0x74, 1> CC_MovA_Imm;		// MOV A,#data
+typedef CC_Instr<0x7E, 0xE5, 1> CC_MovA_Direct;		// MOV A,direct
+typedef CC_Instr<0xBE, 0x75, 2> CC_MovDirect_Imm;	// MOV direct,#data
+typedef CC_Instr<0xBE, 0x90, 2> CC_MovDptr_Imm;		// MOV DPTR,#data16
+typedef CC_Instr<0x4E, 0xE0> 	CC_MovxA_Dptr;		// MOVX A,@DPTR
+typedef CC_Instr<0x5E, 0xF0> 	CC_MovxDptr_A;		// MOVX @DPTR,A
+typedef CC_Instr<0x5E, 0xA3> 	CC_IncDptr;			// INC DPTR
+typedef CC_Instr<0x4E, 0x93> 	CC_MovcA_Dptr;		// MOVC A,@A+DPTR
+
+/// Save slots of the programmer keep values for the duration of a command
+/// (slot is bits 1..3 of the tag). CC_Nop keeps accumulator in slot 0,
+/// instructions below keep register in slot 1..6 and restore it: immediate
+/// data of a restoring instruction are taken from the slot and aren't sent
+template <uint8_t SLOT>
+struct CC_SaveDirect : CC_Instr<0x70 | SLOT << 1, 0xE5, 1> { };	// MOV A,direct
+
+template <uint8_t SLOT>
+struct CC_RestoreDirect : CC_Instr<0xC0 | SLOT << 1, 0x75, 2> { };	// MOV direct,#slot
+
+template <uint8_t SLOT>
+struct CC_RestoreDptr : CC_Instr<0xD0 | SLOT << 1, 0x90, 2> { };	// MOV DPTR,#slot,slot+1
+
+typedef CC_Instr<0x90, 0x74, 1> CC_RestoreA;			// MOV A,#slot 0
+
+/// Instruction without operands as initializer list items
+#define CC_INSTR(I) 		I::TAG, I::COMMAND, I::OPCODE
+#define CC_INSTR_OUTPUT(I) 	I::TAG | 1, I::COMMAND, I::OPCODE
+/// Instruction with its operands sent in the command
+#define CC_INSTR_1(I, operand) 	I::TAG, I::COMMAND, I::OPCODE, operand
+#define CC_INSTR_2(I, operand1, operand2) \
+	I::TAG, I::COMMAND, I::OPCODE, operand1, operand2
+
+/// Command assembled in place, no heap allocation
+template <size_t CAPACITY>
+class CC_CommandBuffer
+{
+public:
+	enum { MAX_SIZE = CAPACITY };
+
+	void clear()
+	{	size_ = 0; }
+
+	const uint8_t *data() const
+	{	return data_; }
+
+	size_t size() const
+	{	return size_; }
+
+	void append(const uint8_t data[], size_t size)
+	{
+		assert(size_ + size <= CAPACITY);
+		memcpy(data_ + size_, data, size);
+		size_ += size;
+	}
+
+	template <class I> void put()
+	{	size_ = I::put(reserve(I::SIZE)) - data_; }
+
+	template <class I> void put_output()
+	{	size_ = I::put_output(reserve(I::SIZE)) - data_; }
+
+	template <class I> void put(uint8_t operand)
+	{	size_ = I::put(reserve(I::SIZE), operand) - data_; }
+
+	template <class I> void put_output(uint8_t operand)
+	{	size_ = I::put_output(reserve(I::SIZE), operand) - data_; }
+
+	template <class I> void put(uint8_t operand1, uint8_t operand2)
+	{	size_ = I::put(reserve(I::SIZE), operand1, operand2) - data_; }
+
+	/// Header of the burst write command, count bytes of data should follow
+	void put_burst_write(uint16_t count)
+	{
+		uint8_t *out = reserve(3);
+		out[0] = 0xEE;
+		out[1] = DEBUG_COMMAND_BURST_WRITE | HIBYTE(count);
+		out[2] = LOBYTE(count);
+		size_ += 3;
+	}
+
+	CC_CommandBuffer() : size_(0) { }
+
+private:
+	uint8_t *reserve(size_t size)
+	{
+		assert(size_ + size <= CAPACITY);
+		return data_ + size_;
+	}
+
+	uint8_t data_[CAPACITY];
+	size_t size_;
+};
+
+#endif // !_CC_DEBUG_INSTR_H_
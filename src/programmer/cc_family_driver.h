@@ -0,0 +1,203 @@
+/*
+ * cc_family_driver.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_FAMILY_DRIVER_H_
+#define _CC_FAMILY_DRIVER_H_
+
+#include "cc_unit_driver.h"
+
+/// Register map, geometry and timing of a target family.
+/// A family variant derives from the base family and hides differing values.
+struct CC_243x_Family
+{
+	enum {
+		LOCK_SIZE 			= 1,
+		FLASH_WORD_SIZE 	= 4,
+		WRITE_BLOCK_SIZE 	= 1024,
+		VERIFY_BLOCK_SIZE 	= 1024,
+		XBANK_OFFSET 		= 0x8000,
+		DMA0_CFG_OFFSET 	= 0x0800,
+		DMA_DATA_OFFSET 	= 0x0000,
+		IRAM_OFFSET 		= 0xFF00, // internal RAM mirrored in xdata
+
+		MEMCTR 		= 0xDFC7,
+		FMAP 		= 0xDF9F,
+		FADDRH 		= 0xDFAD,
+		FADDRL 		= 0xDFAC,
+		FCTL 		= 0xDFAE,
+		FWDATA 		= 0xDFAF,
+		RNDH 		= 0xDFBD,
+		RNDL 		= 0xDFBC,
+		DMA0CFGH 	= 0xDFD5,
+		DMA0CFGL 	= 0xDFD4,
+		DMAARM 		= 0xDFD6,
+		DMAREQ 		= 0xDFD7,
+		DMAIRQ 		= 0xDFD1,
+		CLOCK_STATUS= 0xDFC6, // CLKCON
+
+		FCTL_WRITE 	= 0x02,
+
+		FLASH_WORD_TIME = 20,	// us
+		PAGE_ERASE_TIME = 20,	// ms
+		CHIP_ERASE_TIME = 200	// ms
+	};
+};
+
+struct CC_251x_111x_Family
+{
+	enum {
+		XDATA_RAM_OFFSET 	= 0xF000,
+
+		LOCK_SIZE 			= 1,
+		FLASH_WORD_SIZE 	= 2,
+		WRITE_BLOCK_SIZE 	= 512,
+		VERIFY_BLOCK_SIZE 	= 512,
+		XBANK_OFFSET 		= 0,
+		DMA0_CFG_OFFSET 	= XDATA_RAM_OFFSET + 0x0F00,
+		DMA_DATA_OFFSET 	= XDATA_RAM_OFFSET + 0x0000,
+		IRAM_OFFSET 		= XDATA_RAM_OFFSET + 0x0F00,
+
+		MEMCTR 		= 0, // no flash banks
+		FMAP 		= 0,
+		FADDRH 		= 0xDFAD,
+		FADDRL 		= 0xDFAC,
+		FCTL 		= 0xDFAE,
+		FWDATA 		= 0xDFAF,
+		RNDH 		= 0xDFBD,
+		RNDL 		= 0xDFBC,
+		DMA0CFGH 	= 0xDFD5,
+		DMA0CFGL 	= 0xDFD4,
+		DMAARM 		= 0xDFD6,
+		DMAREQ 		= 0xDFD7,
+		DMAIRQ 		= 0xDFD1,
+		CLOCK_STATUS= 0xDFC6,
+
+		FCTL_WRITE 	= 0x02,
+
+		FLASH_WORD_TIME = 20,
+		PAGE_ERASE_TIME = 20,
+		CHIP_ERASE_TIME = 200
+	};
+};
+
+struct CC_253x_254x_Family
+{
+	enum {
+		LOCK_SIZE 			= 16,
+		FLASH_WORD_SIZE 	= 4,
+		WRITE_BLOCK_SIZE 	= 1024,
+		VERIFY_BLOCK_SIZE 	= 1024,
+		XBANK_OFFSET 		= 0x8000,
+		DMA0_CFG_OFFSET 	= 0x0800,
+		DMA_DATA_OFFSET 	= 0x0000,
+		IRAM_OFFSET 		= 0x1F00, // 8 KB SRAM, found by RAM size on connect
+
+		MEMCTR 		= 0x70C7,
+		FMAP 		= 0x709F,
+		FADDRH 		= 0x6272,
+		FADDRL 		= 0x6271,
+		FCTL 		= 0x6270,
+		FWDATA 		= 0x6273,
+		RNDH 		= 0x70BD,
+		RNDL 		= 0x70BC,
+		DMA0CFGH 	= 0x70D5,
+		DMA0CFGL 	= 0x70D4,
+		DMAARM 		= 0x70D6,
+		DMAREQ 		= 0x70D7,
+		DMAIRQ 		= 0x70D1,
+		CLOCK_STATUS= 0x709E, // CLKCONSTA
+
+		DBGDATA 	= 0x6260,
+		DMA1CFGL 	= 0x70D2,
+		DMA1CFGH 	= 0x70D3,
+
+		FCTL_WRITE 	= 0x06,
+
+		FLASH_WORD_TIME = 20,
+		PAGE_ERASE_TIME = 20,
+		CHIP_ERASE_TIME = 20
+	};
+};
+
+/// CC2543/44/45: less RAM, flash is written by the slow method
+struct CC_2543_2545_Family : CC_253x_254x_Family
+{
+	enum {
+		WRITE_BLOCK_SIZE 	= 512,
+		VERIFY_BLOCK_SIZE 	= 512,
+		DMA0_CFG_OFFSET 	= 0x0200
+	};
+};
+
+//==============================================================================
+template <class FAMILY>
+const UnitCoreInfo &family_core_info()
+{
+	struct Builder
+	{
+		static UnitCoreInfo build()
+		{
+			UnitCoreInfo info;
+
+			info.lock_size 			= FAMILY::LOCK_SIZE;
+			info.flash_word_size 	= FAMILY::FLASH_WORD_SIZE;
+			info.write_block_size 	= FAMILY::WRITE_BLOCK_SIZE;
+			info.verify_block_size 	= FAMILY::VERIFY_BLOCK_SIZE;
+			info.xbank_offset 		= FAMILY::XBANK_OFFSET;
+			info.dma0_cfg_offset 	= FAMILY::DMA0_CFG_OFFSET;
+			info.dma_data_offset 	= FAMILY::DMA_DATA_OFFSET;
+			info.iram_offset 		= FAMILY::IRAM_OFFSET;
+
+			info.memctr 	= FAMILY::MEMCTR;
+			info.fmap 		= FAMILY::FMAP;
+			info.faddrh 	= FAMILY::FADDRH;
+			info.faddrl 	= FAMILY::FADDRL;
+			info.fctl 		= FAMILY::FCTL;
+			info.fwdata 	= FAMILY::FWDATA;
+			info.rndh 		= FAMILY::RNDH;
+			info.rndl 		= FAMILY::RNDL;
+			info.dma0_cfgh 	= FAMILY::DMA0CFGH;
+			info.dma0_cfgl 	= FAMILY::DMA0CFGL;
+			info.dma_arm 	= FAMILY::DMAARM;
+			info.dma_req 	= FAMILY::DMAREQ;
+			info.dma_irq 	= FAMILY::DMAIRQ;
+			info.clock_status = FAMILY::CLOCK_STATUS;
+
+			info.fctl_write = FAMILY::FCTL_WRITE;
+
+			info.flash_word_time = FAMILY::FLASH_WORD_TIME;
+			info.page_erase_time = FAMILY::PAGE_ERASE_TIME;
+			info.chip_erase_time = FAMILY::CHIP_ERASE_TIME;
+			return info;
+		}
+	};
+
+	static const UnitCoreInfo info = Builder::build();
+	return info;
+}
+
+/// Base of family drivers. Register map is taken from the family description,
+/// code specific to the family may use its constants directly.
+/// CC_Programmer works with drivers through CC_UnitDriver interface.
+template <class FAMILY>
+class CC_FamilyDriver : public CC_UnitDriver
+{
+protected:
+	typedef FAMILY Family;
+
+	/// Switch to a variant of the family found on connect
+	template <class VARIANT> void select_family_variant()
+	{	select_core_info(family_core_info<VARIANT>()); }
+
+	CC_FamilyDriver(USB_Device &programmer, ProgressWatcher &pw) :
+			CC_UnitDriver(programmer, pw, family_core_info<FAMILY>())
+	{ }
+};
+
+#endif // !_CC_FAMILY_DRIVER_H_
@@ -0,0 +1,159 @@
+/*
+ * cc_latency.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <algorithm>
+#include "log.h"
+#include "cc_latency.h"
+
+const size_t ENTRY_BREAKPOINT = 0;
+const size_t EXIT_BREAKPOINT = 1;
+
+const size_t HISTOGRAM_WIDTH = 50;
+
+//==============================================================================
+/// Address the CPU sees for a flash offset, banked code is mapped at 0x8000
+static uint16_t code_address(uint_t offset)
+{
+	if (offset < FLASH_MAPPED_BANK_OFFSET)
+		return offset;
+	return FLASH_MAPPED_BANK_OFFSET + offset % FLASH_BANK_SIZE;
+}
+
+//==============================================================================
+/// Bucket n holds values 2^n..2^(n+1)-1, 0 goes to the first one
+static size_t bucket_of(uint_t value)
+{
+	size_t bucket = 0;
+	while (value >>= 1)
+		bucket++;
+	return bucket;
+}
+
+//==============================================================================
+CC_LatencyMeter::CC_LatencyMeter(CC_Programmer &programmer) :
+		programmer_(programmer),
+		divider_(1)
+{ }
+
+//==============================================================================
+void CC_LatencyMeter::start_timer(uint_t divider)
+{
+	divider_ = divider;
+	programmer_.unit_start_timer(divider);
+}
+
+//==============================================================================
+bool CC_LatencyMeter::run(uint_t entry, uint_t exit, size_t count, uint64_t timeout)
+{
+	log_info("latency, run, entry: %06Xh, exit: %06Xh, count: %u", entry, exit, count);
+
+	latencies_.clear();
+
+	CC_Breakpoint breakpoint;
+	breakpoint.number = ENTRY_BREAKPOINT;
+	breakpoint.address = entry;
+	programmer_.unit_set_breakpoint(breakpoint);
+	breakpoint.number = EXIT_BREAKPOINT;
+	breakpoint.address = exit;
+	programmer_.unit_set_breakpoint(breakpoint);
+
+	programmer_.unit_run();
+
+	uint_t cycles_per_tick = 0;
+	bool entered = false;
+	uint16_t entry_time = 0;
+	bool result = true;
+
+	while (latencies_.size() < count)
+	{
+		if (!programmer_.unit_wait_halted(timeout))
+		{
+			result = false;
+			break;
+		}
+		// firmware has set up its clock by the first hit
+		if (!cycles_per_tick)
+			cycles_per_tick = programmer_.unit_cycles_per_timer_tick();
+
+		uint16_t pc = 0, timer = 0;
+		programmer_.unit_breakpoint_continue(pc, timer);
+
+		// a repeated entry (e.g. nested interrupt) restarts the run,
+		// exit without entry is not counted
+		if (pc == code_address(entry))
+		{
+			entered = true;
+			entry_time = timer;
+		}
+		else
+		if (pc == code_address(exit) && entered)
+		{
+			uint16_t ticks = timer - entry_time; // timer may wrap once
+			latencies_.push_back((uint_t)ticks * divider_ * cycles_per_tick);
+			entered = false;
+		}
+	}
+
+	programmer_.unit_clear_breakpoint(ENTRY_BREAKPOINT);
+	programmer_.unit_clear_breakpoint(EXIT_BREAKPOINT);
+	return result;
+}
+
+//==============================================================================
+const UintVector &CC_LatencyMeter::latencies() const
+{	return latencies_; }
+
+//==============================================================================
+void CC_LatencyMeter::print_histogram(std::ostream &os) const
+{
+	if (latencies_.empty())
+	{
+		os << "  Latency: no runs measured\n";
+		return;
+	}
+
+	UintVector sorted(latencies_);
+	std::sort(sorted.begin(), sorted.end());
+
+	double sum = 0;
+	foreach (uint_t latency, sorted)
+		sum += latency;
+
+	os << "  Latency: " << sorted.size() << " runs, cycles min " << sorted.front()
+			<< ", median " << sorted[sorted.size() / 2]
+			<< ", mean " << std::fixed << std::setprecision(1) << sum / sorted.size()
+			<< ", max " << sorted.back() << "\n";
+	os.unsetf(std::ios::fixed);
+
+	size_t first = bucket_of(sorted.front());
+	std::vector<size_t> buckets(bucket_of(sorted.back()) - first + 1);
+	foreach (uint_t latency, sorted)
+		buckets[bucket_of(latency) - first]++;
+	size_t max_runs = *std::max_element(buckets.begin(), buckets.end());
+
+	os << std::setfill(' ') << "   " << std::left << std::setw(24) << "Cycles"
+			<< std::right << std::setw(8) << "Runs" << "\n";
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		uint64_t low = (uint64_t)1 << (first + i);
+		if (!first && !i)
+			low = 0;
+		std::stringstream range;
+		range << low << ".." << ((uint64_t)2 << (first + i)) - 1;
+
+		size_t bar = buckets[i] * HISTOGRAM_WIDTH / max_runs;
+		if (buckets[i] && !bar)
+			bar = 1;
+		os << "   " << std::left << std::setw(24) << range.str() << std::right
+				<< std::setw(8) << buckets[i];
+		if (bar)
+			os << "  " << String(bar, '#');
+		os << "\n";
+	}
+}
@@ -0,0 +1,48 @@
+/*
+ * cc_latency.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_LATENCY_H_
+#define _CC_LATENCY_H_
+
+#include "cc_programmer.h"
+
+/// Measures how long the running firmware takes from one code address to
+/// another (e.g. function entry to its return, ISR vector to RETI) without
+/// instrumenting it. Hardware breakpoints halt the unit at both addresses,
+/// Timer 1 is read at each hit. Timers are suspended while the unit is
+/// halted, so the debugger doesn't add to the result.
+class CC_LatencyMeter : boost::noncopyable
+{
+public:
+	/// Take Timer 1 and start it, the unit must be halted (just connected)
+	/// @param divider Timer 1 divider 1, 8, 32 or 128, latency must stay
+	/// below 65536 ticks of the divided clock
+	void start_timer(uint_t divider);
+
+	/// Let the unit run until count runs are measured
+	/// @param entry, exit flash offsets
+	/// @param timeout us, max wait for a single breakpoint hit
+	/// @return false if timed out, latencies taken so far are kept
+	bool run(uint_t entry, uint_t exit, size_t count, uint64_t timeout);
+
+	/// Measured runs in system clock cycles
+	const UintVector &latencies() const;
+
+	/// Summary and histogram by power of two buckets
+	void print_histogram(std::ostream &os) const;
+
+	CC_LatencyMeter(CC_Programmer &programmer);
+
+private:
+	CC_Programmer &programmer_;
+	uint_t divider_;
+	UintVector latencies_;
+};
+
+#endif // !_CC_LATENCY_H_
@@ -0,0 +1,221 @@
+/*
+ * cc_profiler.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <unistd.h>
+#include <boost/algorithm/string/join.hpp>
+#include "log.h"
+#include "data/file.h"
+#include "cc_profiler.h"
+
+const char UNKNOWN_FUNCTION[] = "[unknown]";
+
+// Deeper stacks are cut, 8051 internal RAM can't hold much more anyway
+const size_t MAX_STACK_DEPTH = 32;
+
+// The shortest call instruction (ACALL)
+const uint_t MIN_CALL_SIZE = 2;
+
+//==============================================================================
+/// Flash offset of a code address, bank is the one mapped at 0x8000
+static uint_t code_offset(uint16_t address, uint8_t bank)
+{
+	if (address < FLASH_MAPPED_BANK_OFFSET)
+		return address;
+	return bank * FLASH_BANK_SIZE + address - FLASH_MAPPED_BANK_OFFSET;
+}
+
+//==============================================================================
+CC_Profiler::CC_Profiler(CC_Programmer &programmer, const SymbolMap &symbols) :
+		programmer_(programmer),
+		symbols_(symbols),
+		run_time_(0),
+		halt_time_(0)
+{ }
+
+//==============================================================================
+void CC_Profiler::run(uint_t rate, size_t sample_count, bool read_stacks)
+{
+	log_info("profiler, run, rate: %u, samples: %u", rate, sample_count);
+
+	samples_.clear();
+	samples_.reserve(sample_count);
+	run_time_ = 0;
+	halt_time_ = 0;
+
+	programmer_.unit_run();
+
+	uint64_t interval = rate ? 1000000 / rate : 0;
+	uint64_t start_time = programmer_.transport_time();
+	uint64_t next_time = start_time + interval;
+
+	for (size_t i = 0; i < sample_count; i++)
+	{
+		uint64_t time = programmer_.transport_time();
+		if (time < next_time)
+		{
+			usleep(next_time - time);
+			time = next_time;
+		}
+		// a late sample shifts the following ones instead of bursting
+		next_time = std::max(next_time, time) + interval;
+
+		CC_PcSample sample;
+		uint64_t halt_start = programmer_.transport_time();
+		programmer_.unit_sample_pc(sample, read_stacks);
+		halt_time_ += programmer_.transport_time() - halt_start;
+
+		samples_.push_back(sample);
+	}
+	run_time_ = programmer_.transport_time() - start_time;
+}
+
+//==============================================================================
+size_t CC_Profiler::sample_count() const
+{	return samples_.size(); }
+
+//==============================================================================
+uint64_t CC_Profiler::run_time() const
+{	return run_time_; }
+
+//==============================================================================
+uint64_t CC_Profiler::halt_time() const
+{	return halt_time_; }
+
+//==============================================================================
+void CC_Profiler::unwind(const CC_PcSample &sample, CC_ProfileStack &stack) const
+{
+	stack.clear();
+
+	// LCALL pushes low byte of the return address first, the innermost
+	// caller is on top. A return address follows a call instruction, so it
+	// can't be close to the start of a function.
+	const ByteVector &ram = sample.stack;
+	for (size_t i = ram.size(); i >= 2 && stack.size() < MAX_STACK_DEPTH; )
+	{
+		uint_t offset = code_offset(ram[i - 1] << 8 | ram[i - 2], sample.bank);
+		const CodeSymbol *symbol = symbols_.find(offset);
+		if (symbol && offset >= symbol->address + MIN_CALL_SIZE)
+		{
+			stack.push_back(symbol->name);
+			i -= 2;
+		}
+		else
+			i--;
+	}
+	std::reverse(stack.begin(), stack.end());
+
+	const CodeSymbol *symbol = symbols_.find(code_offset(sample.pc, sample.bank));
+	stack.push_back(symbol ? symbol->name : UNKNOWN_FUNCTION);
+}
+
+//==============================================================================
+void CC_Profiler::stacks(std::vector<CC_ProfileStack> &stacks) const
+{
+	stacks.resize(samples_.size());
+	for (size_t i = 0; i < samples_.size(); i++)
+		unwind(samples_[i], stacks[i]);
+}
+
+//==============================================================================
+struct FlatEntry
+{
+	String name;
+	size_t self;
+	size_t total;
+
+	FlatEntry() : self(0), total(0) { }
+
+	bool operator<(const FlatEntry &o) const
+	{
+		if (self != o.self)
+			return self > o.self;
+		if (total != o.total)
+			return total > o.total;
+		return name < o.name;
+	}
+};
+
+//==============================================================================
+void CC_Profiler::print_flat(std::ostream &os) const
+{
+	std::vector<CC_ProfileStack> all;
+	stacks(all);
+
+	typedef std::map<String, FlatEntry> EntryMap;
+	EntryMap entries;
+	foreach (const CC_ProfileStack &stack, all)
+	{
+		// recursion counts once to total
+		std::set<String> functions(stack.begin(), stack.end());
+		foreach (const String &name, functions)
+		{
+			FlatEntry &entry = entries[name];
+			entry.name = name;
+			entry.total++;
+		}
+		entries[stack.back()].self++;
+	}
+
+	std::vector<FlatEntry> flat;
+	foreach (const EntryMap::value_type &entry, entries)
+		flat.push_back(entry.second);
+	std::sort(flat.begin(), flat.end());
+
+	double run_time = (double)run_time_ / 1000000;
+	double count = samples_.empty() ? 1 : samples_.size();
+
+	os << "  Profile: " << samples_.size() << " samples in "
+			<< std::fixed << std::setprecision(1) << run_time << " s, target halted "
+			<< (run_time_ ? 100.0 * halt_time_ / run_time_ : 0) << "% of the time\n";
+	os << std::setfill(' ') << std::right << "   "
+			<< std::setw(8) << "Self"
+			<< std::setw(8) << "%"
+			<< std::setw(8) << "Total"
+			<< std::setw(8) << "%"
+			<< "  Function\n";
+
+	foreach (const FlatEntry &entry, flat)
+		os << "   "
+			<< std::setw(8) << entry.self
+			<< std::setw(8) << 100.0 * entry.self / count
+			<< std::setw(8) << entry.total
+			<< std::setw(8) << 100.0 * entry.total / count
+			<< "  " << entry.name << "\n";
+
+	os.unsetf(std::ios::fixed);
+}
+
+//==============================================================================
+void CC_Profiler::write_folded(std::ostream &os) const
+{
+	std::vector<CC_ProfileStack> all;
+	stacks(all);
+
+	typedef std::map<String, size_t> CountMap;
+	CountMap counts;
+	foreach (const CC_ProfileStack &stack, all)
+		counts[boost::algorithm::join(stack, ";")]++;
+
+	foreach (const CountMap::value_type &item, counts)
+		os << item.first << " " << item.second << "\n";
+}
+
+//==============================================================================
+void CC_Profiler::save_folded(const String &file_name) const
+{
+	std::ofstream out(file_name.c_str());
+	write_folded(out);
+	out.close();
+	if (!out)
+		throw FileException("Unable to write file " + file_name);
+}
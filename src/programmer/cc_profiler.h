@@ -0,0 +1,58 @@
+/*
+ * cc_profiler.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_PROFILER_H_
+#define _CC_PROFILER_H_
+
+#include "data/symbol_map.h"
+#include "cc_programmer.h"
+
+/// Function names of a sample, outermost caller first, sampled function last
+typedef StringVector CC_ProfileStack;
+
+/// Statistical profiler of the running firmware: the unit is periodically
+/// halted, its PC and stack are read and the unit is let go. Callers are
+/// found by scanning the stack for return addresses inside known functions,
+/// so a stack may miss frames or show stale ones.
+class CC_Profiler : boost::noncopyable
+{
+public:
+	/// Let the unit run and take sample_count samples
+	/// @param rate samples per second, 0 - as fast as transport allows
+	/// @param read_stacks false to sample PC only, halts are shorter
+	void run(uint_t rate, size_t sample_count, bool read_stacks);
+
+	size_t sample_count() const;
+	/// Time from the first sample to the last one, us (transport time)
+	uint64_t run_time() const;
+	/// Time the unit spent halted by sampling, us
+	uint64_t halt_time() const;
+
+	/// Functions of every sample, unknown code is named '[unknown]'
+	void stacks(std::vector<CC_ProfileStack> &stacks) const;
+
+	/// Self and total samples per function, the most sampled first
+	void print_flat(std::ostream &os) const;
+	/// Collapsed stacks 'outer;...;inner count', input of flamegraph.pl
+	void write_folded(std::ostream &os) const;
+	void save_folded(const String &file_name) const; // throw
+
+	CC_Profiler(CC_Programmer &programmer, const SymbolMap &symbols);
+
+private:
+	void unwind(const CC_PcSample &sample, CC_ProfileStack &stack) const;
+
+	CC_Programmer &programmer_;
+	const SymbolMap &symbols_;
+	std::vector<CC_PcSample> samples_;
+	uint64_t run_time_;
+	uint64_t halt_time_;
+};
+
+#endif // !_CC_PROFILER_H_
@@ -14,6 +14,7 @@
 #include "cc_253x_254x.h"
 #include "cc_243x.h"
 #include "log.h"
+#include "trace.h"
 
 const uint_t DEFAULT_TIMEOUT = 3000;
 const uint_t MAX_ERASE_TIME	= 8000;
@@ -52,7 +53,27 @@ static void log_add_programmer_info(const CC_ProgrammerInfo &info)
 }
 
 //==============================================================================
-CC_Programmer::CC_Programmer()
+CC_Programmer::CC_Programmer() :
+		usb_device_(libusb_device_),
+		erase_start_time_(0),
+		clock_boost_(false),
+		clock_boosted_(false)
+{
+	init_drivers();
+}
+
+//==============================================================================
+CC_Programmer::CC_Programmer(USB_Device &usb_device) :
+		usb_device_(usb_device),
+		erase_start_time_(0),
+		clock_boost_(false),
+		clock_boosted_(false)
+{
+	init_drivers();
+}
+
+//==============================================================================
+void CC_Programmer::init_drivers()
 {
 	usb_device_.set_transfer_timeout(DEFAULT_TIMEOUT);
 
@@ -110,6 +131,15 @@ bool CC_Programmer::unit_set_flash_size(uint_t flash_size)
 	return driver_->set_flash_size(flash_size);
 }
 
+//==============================================================================
+void CC_Programmer::unit_set_read_chunk_sizes(size_t flash_chunk_size,
+		size_t xdata_chunk_size)
+{
+	log_info("programmer, set read chunk sizes %u, %u", flash_chunk_size,
+			xdata_chunk_size);
+	driver_->set_read_chunk_sizes(flash_chunk_size, xdata_chunk_size);
+}
+
 //==============================================================================
 bool CC_Programmer::programmer_info(CC_ProgrammerInfo &info)
 {
@@ -255,7 +285,62 @@ void CC_Programmer::unit_status(String &name, bool &supported) const
 
 //==============================================================================
 void CC_Programmer::unit_close()
-{	driver_->reset(false); }
+{
+	if (clock_boosted_)
+		driver_->clock_restore();
+	clock_boosted_ = false;
+
+	driver_->reset(false);
+}
+
+//==============================================================================
+void CC_Programmer::unit_run()
+{
+	log_info("programmer, run target");
+
+	if (clock_boosted_)
+		driver_->clock_restore();
+	clock_boosted_ = false;
+
+	driver_->write_debug_config(DEBUG_CONFIG_TIMER_SUSPEND);
+	driver_->resume();
+}
+
+//==============================================================================
+void CC_Programmer::unit_sample_pc(CC_PcSample &sample, bool read_stack)
+{	driver_->sample_pc(sample, read_stack); }
+
+//==============================================================================
+void CC_Programmer::unit_set_breakpoint(const CC_Breakpoint &breakpoint)
+{	driver_->set_hw_breakpoint(breakpoint.number, breakpoint.address, true); }
+
+//==============================================================================
+void CC_Programmer::unit_clear_breakpoint(size_t number)
+{	driver_->set_hw_breakpoint(number, 0, false); }
+
+//==============================================================================
+bool CC_Programmer::unit_wait_halted(uint64_t timeout)
+{	return driver_->wait_halted(timeout); }
+
+//==============================================================================
+void CC_Programmer::unit_breakpoint_continue(uint16_t &pc, uint16_t &timer)
+{	driver_->breakpoint_continue(pc, timer); }
+
+//==============================================================================
+void CC_Programmer::unit_start_timer(uint_t divider)
+{	driver_->start_timer(divider); }
+
+//==============================================================================
+uint_t CC_Programmer::unit_cycles_per_timer_tick()
+{	return driver_->cycles_per_timer_tick(); }
+
+//==============================================================================
+void CC_Programmer::set_clock_boost(bool enable)
+{	clock_boost_ = enable; }
+
+//==============================================================================
+bool CC_Programmer::unit_clock_boosted() const
+{	return clock_boosted_; }
 
 //==============================================================================
 void CC_Programmer::enter_debug_mode()
@@ -298,6 +383,7 @@ bool CC_Programmer::unit_connect(UnitInfo &info)
 
 	enter_debug_mode();
 	driver_->reset(true);
+	clock_boosted_ = false; // reset is back to default clock
 
 	uint8_t status = 0;
 	driver_->read_debug_status(status);
@@ -317,6 +403,12 @@ bool CC_Programmer::unit_connect(UnitInfo &info)
 	driver_->write_debug_config(DEBUG_CONFIG_TIMER_SUSPEND | DEBUG_CONFIG_SOFT_POWER_MODE);
 	driver_->find_unit_info(unit_info_);
 
+	if (clock_boost_)
+	{
+		clock_boosted_ = driver_->clock_boost();
+		log_info("programmer, clock boosted: %u", clock_boosted_);
+	}
+
 	log_add_target_info(unit_info_);
 
 	info = unit_info_;
@@ -327,24 +419,67 @@ bool CC_Programmer::unit_connect(UnitInfo &info)
 bool CC_Programmer::unit_reset()
 {
 	driver_->reset(false);
+	clock_boosted_ = false;
 	return true;
 }
 
 //==============================================================================
-bool CC_Programmer::unit_erase()
+void CC_Programmer::unit_erase_start()
 {
 	driver_->erase();
+	erase_start_time_ = usb_device_.transport_time();
+}
+
+//==============================================================================
+bool CC_Programmer::unit_erase_wait()
+{
+	const uint64_t MIN_POLL_INTERVAL = 1000; // us
+
+	uint64_t start_time = get_monotonic_time();
+	uint64_t expected_time = (uint64_t)driver_->chip_erase_time() * 1000;
+	uint64_t max_interval = std::max(expected_time / 4, MIN_POLL_INTERVAL);
+	uint64_t interval = MIN_POLL_INTERVAL;
+	uint_t polls = 0;
+	bool result = false;
+
+	// Don't poll before erase could complete, then poll often at first
+	// and back off to a quarter of the expected time
+	uint64_t elapsed = usb_device_.transport_time() - erase_start_time_;
+	if (elapsed < expected_time * 3 / 4)
+	{
+		TraceScope trace("erase_wait", "programmer");
+		usleep(expected_time * 3 / 4 - elapsed);
+	}
 
-	uint_t erase_timer = get_tick_count();
 	do
 	{
-		if (driver_->erase_check_comleted())
-			return true;
-		usleep(500 * 1000);
+		polls++;
+		if ((result = driver_->erase_check_comleted()))
+			break;
+
+		TraceScope trace("erase_wait", "programmer");
+		usleep(interval);
+		interval = std::min(interval * 2, max_interval);
 	}
-	while ((get_tick_count() - erase_timer) <= MAX_ERASE_TIME);
+	while (usb_device_.transport_time() - erase_start_time_ <= MAX_ERASE_TIME * 1000);
+
+	driver_->add_poll_stats(polls, get_monotonic_time() - start_time);
+	return result; // false on erase timeout
+}
+
+//==============================================================================
+bool CC_Programmer::unit_erase()
+{
+	unit_erase_start();
+	return unit_erase_wait();
+}
+
+//==============================================================================
+bool CC_Programmer::unit_erase_page(uint_t address)
+{
+	log_info("programmer, erase page %06Xh", address);
 
-	return false; // erase timeout
+	return driver_->erase_page(address);
 }
 
 //==============================================================================
@@ -382,6 +517,37 @@ bool CC_Programmer::flash_image_embed_lock_data(DataSectionStore &sections,
 	return driver_->flash_image_embed_lock_data(sections, lock_data);
 }
 
+//==============================================================================
+static bool embedded_range(const DataSectionStore &store, AddressRange &range)
+{
+	if (store.sections().empty())
+		return false;
+
+	range = AddressRange(store.lower_address(), store.upper_address());
+	return true;
+}
+
+//==============================================================================
+bool CC_Programmer::flash_image_mac_address_range(AddressRange &range)
+{
+	DataSectionStore store;
+	ByteVector mac_address(unit_info_.mac_address_size, 0xFF);
+
+	return !mac_address.empty() &&
+			driver_->flash_image_embed_mac_address(store, mac_address) &&
+			embedded_range(store, range);
+}
+
+//==============================================================================
+bool CC_Programmer::flash_image_lock_data_range(AddressRange &range)
+{
+	DataSectionStore store;
+	ByteVector lock_data(driver_->lock_data_size(), 0xFF);
+
+	return driver_->flash_image_embed_lock_data(store, lock_data) &&
+			embedded_range(store, range);
+}
+
 //==============================================================================
 uint_t CC_Programmer::unit_lock_data_size() const
 {
@@ -408,6 +574,36 @@ void CC_Programmer::unit_flash_read(ByteVector &flash_data)
 	pw_.read_finish();
 }
 
+//==============================================================================
+void CC_Programmer::unit_flash_read(DataSink &sink)
+{	unit_flash_read(AddressRange(0, unit_info_.actual_flash_size()), sink); }
+
+//==============================================================================
+void CC_Programmer::unit_flash_read(const AddressRange &range, DataSink &sink)
+{
+	const size_t READ_BLOCK_SIZE = 8192;
+
+	log_info("programmer, read flash %06Xh-%06Xh", range.begin, range.end);
+
+	pw_.enable(true);
+	pw_.read_start(range.end - range.begin);
+
+	driver_->flash_read_start();
+
+	ByteVector data;
+	data.reserve(READ_BLOCK_SIZE);
+	for (size_t offset = range.begin; offset < range.end; offset += READ_BLOCK_SIZE)
+	{
+		data.clear();
+		driver_->flash_read_block(offset,
+				std::min(READ_BLOCK_SIZE, range.end - offset), data);
+		sink.write(offset, &data[0], data.size());
+	}
+	driver_->flash_read_end();
+
+	pw_.read_finish();
+}
+
 //==============================================================================
 bool CC_Programmer::unit_flash_verify(const DataSectionStore &sections,
 		CC_Programmer::VerifyMethod method)
@@ -421,6 +617,45 @@ bool CC_Programmer::unit_flash_verify(const DataSectionStore &sections,
 	return driver_->flash_verify_by_read(sections);
 }
 
+//==============================================================================
+bool CC_Programmer::unit_flash_verify(const FlashBlockCrcList &blocks)
+{
+	log_info("programmer, verify flash by plan, %u blocks", blocks.size());
+
+	pw_.enable(true);
+	return driver_->flash_verify_by_crc(blocks);
+}
+
+//==============================================================================
+void CC_Programmer::unit_flash_crc(FlashBlockCrcList &blocks)
+{
+	log_info("programmer, flash crc, %u blocks", blocks.size());
+
+	pw_.enable(true);
+	driver_->flash_read_crc(blocks);
+}
+
+//==============================================================================
+size_t CC_Programmer::unit_verify_block_size() const
+{	return driver_->verify_block_size(); }
+
+//==============================================================================
+UintVector CC_Programmer::verify_block_sizes() const
+{
+	UintVector sizes;
+	foreach (const CC_UnitDriverPtr &driver, unit_drviers_)
+	{
+		uint_t size = driver->verify_block_size();
+		if (std::find(sizes.begin(), sizes.end(), size) == sizes.end())
+			sizes.push_back(size);
+	}
+	return sizes;
+}
+
+//==============================================================================
+void CC_Programmer::unit_flash_write_prepare(const DataSectionStore &sections)
+{	driver_->flash_write_prepare(sections); }
+
 //==============================================================================
 void CC_Programmer::unit_flash_write(const DataSectionStore &sections)
 {
@@ -428,6 +663,29 @@ void CC_Programmer::unit_flash_write(const DataSectionStore &sections)
 	driver_->flash_write(sections);
 }
 
+//==============================================================================
+uint64_t CC_Programmer::transport_time() const
+{	return usb_device_.transport_time(); }
+
+//==============================================================================
+const USB_TransferStats &CC_Programmer::transfer_stats() const
+{	return usb_device_.transfer_stats(); }
+
+//==============================================================================
+void CC_Programmer::reset_transfer_stats()
+{	usb_device_.reset_transfer_stats(); }
+
+//==============================================================================
+CC_PollStats CC_Programmer::poll_stats() const
+{	return driver_ ? driver_->poll_stats() : CC_PollStats(); }
+
+//==============================================================================
+void CC_Programmer::reset_poll_stats()
+{
+	if (driver_)
+		driver_->reset_poll_stats();
+}
+
 //==============================================================================
 void CC_Programmer::do_on_flash_read_progress(
 		const ProgressWatcher::OnProgress::slot_type &slot)
@@ -14,6 +14,7 @@
 #include "cc_unit_driver.h"
 #include "usb/usb_device.h"
 #include "data/data_section_store.h"
+#include "data/data_sink.h"
 
 struct USB_DeviceID
 {
@@ -68,6 +69,39 @@ public:
 
 	bool unit_set_flash_size(uint_t flash_size);
 
+	/// Run target on its high speed crystal oscillator while connected,
+	/// set before unit_connect. Original clock is restored by unit_close.
+	/// Supported by CC253x/CC254x only, ignored for other targets.
+	void set_clock_boost(bool enable);
+	/// @return true if clock of the connected unit is boosted
+	bool unit_clock_boosted() const;
+
+	/// Bytes per debug command in flash and info page reads, see CC_Tuner
+	void unit_set_read_chunk_sizes(size_t flash_chunk_size, size_t xdata_chunk_size);
+
+	/// Let the connected unit run its firmware from the current PC. Clock
+	/// boost is undone, timers are suspended while the debugger halts the
+	/// unit. unit_close or unit_connect stops it.
+	void unit_run();
+	/// Catch PC (and stack) of the running unit, see CC_UnitDriver::sample_pc
+	void unit_sample_pc(CC_PcSample &sample, bool read_stack);
+
+	/// Hardware breakpoint halts the unit when it reaches the address
+	/// (flash offset), CC_Breakpoint::number is below CC_BREAKPOINT_COUNT
+	void unit_set_breakpoint(const CC_Breakpoint &breakpoint);
+	void unit_clear_breakpoint(size_t number);
+	/// @param timeout us
+	/// @return false if the running unit hasn't halted in time
+	bool unit_wait_halted(uint64_t timeout);
+	/// Read PC and Timer 1 counter of the unit halted at a breakpoint and
+	/// let it run on
+	void unit_breakpoint_continue(uint16_t &pc, uint16_t &timer);
+
+	/// Run Timer 1 free, divider is 1, 8, 32 or 128. Firmware must not use it.
+	void unit_start_timer(uint_t divider);
+	/// System clock cycles per Timer 1 tick before divider
+	uint_t unit_cycles_per_timer_tick();
+
 	void unit_status(String &name, bool &supported) const;
 	bool unit_connect(UnitInfo &info);
 	void unit_close();
@@ -76,15 +110,43 @@ public:
 	bool unit_locked();
 	bool unit_erase();
 
+	/// Start flash erase and return immediately, host may do other work
+	/// (e.g. unit_flash_write_prepare) until unit_erase_wait
+	void unit_erase_start();
+	/// @return false on erase timeout
+	bool unit_erase_wait();
+
+	/// Erase a single flash page, address must be aligned to the page size
+	/// @return false if erase was aborted
+	bool unit_erase_page(uint_t address);
+
 	void unit_read_info_page(ByteVector &info_page);
 
 	void unit_mac_address_read(size_t index, ByteVector &mac_address);
 
 	void unit_flash_read(ByteVector &flash_data);
+	/// Read flash by blocks, each block is passed to sink as it's read
+	void unit_flash_read(DataSink &sink);
+	void unit_flash_read(const AddressRange &range, DataSink &sink);
 	void unit_flash_write(const DataSectionStore &sections);
 
+	/// Build flash image on the host in advance, the next unit_flash_write of
+	/// the same unchanged sections skips it
+	void unit_flash_write_prepare(const DataSectionStore &sections);
+
 	enum VerifyMethod { VM_BY_CRC, VM_BY_READ };
 	bool unit_flash_verify(const DataSectionStore &sections, VerifyMethod method);
+	/// Verify by CRC computed in advance (e.g. taken from FlashPlan)
+	bool unit_flash_verify(const FlashBlockCrcList &blocks);
+
+	/// Compute CRC of every block on target, block size isn't limited
+	void unit_flash_crc(FlashBlockCrcList &blocks);
+
+	/// Block size FlashPlan is to be compiled with for the target
+	size_t unit_verify_block_size() const;
+
+	/// Verify block sizes of all supported targets
+	UintVector verify_block_sizes() const;
 
 	bool unit_config_write(ByteVector &mac_address, ByteVector &lock_data);
 
@@ -99,23 +161,47 @@ public:
 	bool flash_image_embed_lock_data(DataSectionStore &sections,
 			const ByteVector &lock_data);
 
+	/// Flash range where mac address/lock data are embedded into flash image
+	/// @return false if target doesn't store them in flash
+	bool flash_image_mac_address_range(AddressRange &range);
+	bool flash_image_lock_data_range(AddressRange &range);
+
 
 	void do_on_flash_read_progress(const ProgressWatcher::OnProgress::slot_type&);
 	void do_on_flash_write_progress(const ProgressWatcher::OnProgress::slot_type&);
 
+	/// Clock of the transport, us. Simulated programmer charges modeled time
+	uint64_t transport_time() const;
+
+	const USB_TransferStats &transfer_stats() const;
+	void reset_transfer_stats();
+
+	/// Status polling of the connected unit, empty if no unit connected
+	CC_PollStats poll_stats() const;
+	void reset_poll_stats();
+
 	CC_Programmer();
 
+	/// Work through an alternative transport (e.g. simulated programmer),
+	/// usb_device must outlive the programmer object
+	CC_Programmer(USB_Device &usb_device);
+
 private:
+	void init_drivers();
 	void request_device_info();
 	void enter_debug_mode();
 	void init_device();
 
 	CC_ProgrammerInfo programmer_info_;
 	UnitInfo unit_info_;
-	USB_Device usb_device_;
+	USB_Device libusb_device_;
+	USB_Device &usb_device_;
 	CC_UnitDriverPtrList unit_drviers_;
 	CC_UnitDriverPtr driver_;
 	ProgressWatcher pw_;
+	uint64_t erase_start_time_;
+	bool clock_boost_;
+	bool clock_boosted_;
 	//CC_Breakpoint bps_[CC_BREAKPOINT_COUNT];
 };
 
@@ -0,0 +1,958 @@
+/*
+ * cc_simulator.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <time.h>
+#include "log.h"
+#include "cc_debug_interface.h"
+#include "cc_unit_driver.h"
+#include "cc_simulator.h"
+
+const uint16_t SIMULATOR_VENDOR_ID	= 0x0451;
+const uint16_t SIMULATOR_PRODUCT_ID	= 0x16A2;
+const uint16_t SIMULATOR_FW_VERSION	= 0x0044;
+const uint16_t SIMULATOR_FW_REVISION= 0x8200;
+const uint16_t SIMULATOR_DEBUGGER_ID= 0x5AB1;
+
+const size_t INFO_PAGE_SIZE			= 0x800;
+const uint16_t XREG_INFO_PAGE		= 0x7800; // CC253x only
+const uint16_t XREG_DBGDATA			= 0x6260; // CC253x only
+
+const uint8_t SFR_SP				= 0x81;
+const uint8_t SFR_DPL				= 0x82;
+const uint8_t SFR_DPH				= 0x83;
+const uint8_t IRAM_STACK_START		= 0x08;
+
+const uint8_t DMA_TRIGGER_FLASH		= 18;
+const uint8_t DMA_TRIGGER_DBG_BW	= 31;
+const uint_t DMA_CHANNEL_COUNT		= 5;
+
+//==============================================================================
+static uint64_t monotonic_time()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//==============================================================================
+static uint64_t thread_cpu_time()
+{
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//==============================================================================
+/// CRC16 as calculated by the target's random generator when RNDH is written
+static uint16_t crc16_update(uint16_t crc, uint8_t value)
+{
+	crc ^= value << 8;
+	for (size_t i = 0; i < 8; i++)
+		crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+	return crc;
+}
+
+//==============================================================================
+CC_Simulator::TimingModel::TimingModel() :
+		transaction_time(1000),
+		byte_time(4000),
+		fast_byte_time(2500),
+		flash_word_time(20),
+		page_erase_time(20000),
+		chip_erase_time(20000),
+		dma_byte_time(125),
+		xosc_startup_time(300)
+{ }
+
+//==============================================================================
+CC_Simulator::CallModel::CallModel() :
+		entry(0),
+		exit(0),
+		idle_cycles(0)
+{ }
+
+//==============================================================================
+CC_Simulator::CC_Simulator(uint_t unit_ID, uint_t flash_size) :
+		unit_ID_(unit_ID),
+		opened_(false),
+		acc_(0),
+		pc_(0),
+		random_(1),
+		debug_config_(0),
+		halted_(false),
+		erased_(false),
+		fast_speed_(false),
+		xosc_on_(false),
+		xosc_stable_time_(0),
+		crc_(0),
+		flash_pointer_(0),
+		flash_busy_until_(0),
+		erase_busy_until_(0),
+		open_time_(monotonic_time()),
+		charged_time_(0),
+		cpu_time_(0)
+{
+	memset(&regs_, 0, sizeof(regs_));
+	memset(iram_, 0, sizeof(iram_));
+	memset(slots_, 0, sizeof(slots_));
+
+	flash_.resize(flash_size * 1024, FLASH_EMPTY_BYTE);
+	info_page_.resize(INFO_PAGE_SIZE, FLASH_EMPTY_BYTE);
+	xdata_.resize(0x10000, 0);
+
+	if (unit_ID == 0x2430 || unit_ID == 0x2431)
+		family_ = F_CC243X;
+	else
+	if (unit_ID == 0x2510 || unit_ID == 0x2511 ||
+			unit_ID == 0x1110 || unit_ID == 0x1111)
+		family_ = F_CC251X;
+	else
+		family_ = F_CC253X;
+
+	bool small_unit = unit_ID == 0x2543 || unit_ID == 0x2544 || unit_ID == 0x2545;
+
+	if (family_ == F_CC253X)
+	{
+		flash_word_size_ = 4;
+		flash_page_size_ = (small_unit || unit_ID == 0x2533) ? 1024 : 2048;
+
+		regs_.sfr_base	= 0x7000;
+		regs_.fctl		= 0x6270;
+		regs_.faddrl	= 0x6271;
+		regs_.faddrh	= 0x6272;
+		regs_.fwdata	= 0x6273;
+		regs_.clkconsta	= regs_.sfr_base + 0x9E;
+		regs_.sleepcmd	= regs_.sfr_base + 0xBE;
+		regs_.clkconcmd	= regs_.sfr_base + 0xC6;
+	}
+	else
+	{
+		flash_word_size_ = (family_ == F_CC243X) ? 4 : 2;
+		flash_page_size_ = (family_ == F_CC243X) ? 2048 : 1024;
+
+		regs_.sfr_base	= 0xDF00;
+		regs_.fctl		= 0xDFAE;
+		regs_.faddrl	= 0xDFAC;
+		regs_.faddrh	= 0xDFAD;
+		regs_.fwdata	= 0xDFAF;
+		regs_.iram		= 0xFF00;
+	}
+	regs_.rndl		= regs_.sfr_base + 0xBC;
+	regs_.rndh		= regs_.sfr_base + 0xBD;
+	regs_.dma1_cfgl	= regs_.sfr_base + 0xD2;
+	regs_.dma1_cfgh	= regs_.sfr_base + 0xD3;
+	regs_.dma0_cfgl	= regs_.sfr_base + 0xD4;
+	regs_.dma0_cfgh	= regs_.sfr_base + 0xD5;
+	regs_.dma_arm	= regs_.sfr_base + 0xD6;
+	regs_.dma_req	= regs_.sfr_base + 0xD7;
+	regs_.dma_irq	= regs_.sfr_base + 0xD1;
+	regs_.t1cntl	= regs_.sfr_base + 0xE2;
+	regs_.t1cnth	= regs_.sfr_base + 0xE3;
+	regs_.t1ctl		= regs_.sfr_base + 0xE4;
+	if (family_ != F_CC251X)
+	{
+		regs_.memctr= regs_.sfr_base + 0xC7;
+		regs_.fmap	= regs_.sfr_base + 0x9F;
+	}
+
+	// Chip identification as read by the drivers' find_unit_info
+	const uint8_t mac[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x4B, 0x12 };
+	if (family_ == F_CC253X)
+	{
+		uint8_t flash_size_id = 0x04;
+		if (flash_size <= 32)
+			flash_size_id = small_unit ? 0x07 : 0x01;
+		else
+		if (flash_size <= 64)
+			flash_size_id = 0x02;
+		else
+		if (flash_size <= 128)
+			flash_size_id = 0x03;
+
+		xdata_[0x6276] = (flash_size_id << 4) |
+				((unit_ID == 0x2531 || unit_ID == 0x2511) ? 0x08 : 0x00);
+		// internal RAM is the last 256 bytes of SRAM
+		uint_t ram_size = 8; // KB
+		if (small_unit)
+			ram_size = unit_ID == 0x2544 ? 2 : 1;
+		xdata_[0x6277] = ram_size - 1;
+		regs_.iram = ram_size * 1024 - 0x100;
+		xdata_[0x6249] = 0x01;
+		xdata_[0x624A] = LOBYTE(unit_ID);
+
+		size_t mac_offset = (unit_ID == 0x2540 || unit_ID == 0x2541) ? 0x0E : 0x0C;
+		memcpy(&info_page_[mac_offset], mac, sizeof(mac));
+	}
+	if (family_ == F_CC243X)
+	{
+		xdata_[0xDF60] = 0x04;
+		xdata_[0xDF61] = 0x85;
+		memcpy(&xdata_[0xDF43], mac, sizeof(mac));
+	}
+	if (family_ == F_CC251X)
+	{
+		xdata_[0xDF36] = 0x04;
+		xdata_[0xDF37] = 0x81;
+	}
+	reset_target(false);
+}
+
+//==============================================================================
+void CC_Simulator::set_timing_model(const TimingModel &model)
+{	model_ = model; }
+
+//==============================================================================
+void CC_Simulator::set_cpu_states(const CpuStateVector &states)
+{	cpu_states_ = states; }
+
+//==============================================================================
+void CC_Simulator::set_call_model(const CallModel &model)
+{
+	call_model_ = model;
+	next_event_ = cpu_cycles_ + model.idle_cycles;
+	call_index_ = 0;
+	in_call_ = false;
+}
+
+//==============================================================================
+uint64_t CC_Simulator::clock() const
+{	return monotonic_time() - open_time_ + charged_time_ / 1000; }
+
+//==============================================================================
+uint64_t CC_Simulator::transport_time() const
+{	return clock(); }
+
+//==============================================================================
+uint64_t CC_Simulator::charged_time() const
+{	return charged_time_ / 1000; }
+
+//==============================================================================
+uint64_t CC_Simulator::cpu_time() const
+{	return cpu_time_; }
+
+//==============================================================================
+const ByteVector &CC_Simulator::flash() const
+{	return flash_; }
+
+//==============================================================================
+bool CC_Simulator::open_by_vid_pid(uint16_t vendor_id, uint16_t product_id)
+{
+	opened_ = vendor_id == SIMULATOR_VENDOR_ID && product_id == SIMULATOR_PRODUCT_ID;
+	if (opened_)
+		log_info("simulator, open device, target ID: %04Xh", unit_ID_);
+	return opened_;
+}
+
+//==============================================================================
+bool CC_Simulator::open_by_address(uint8_t, uint8_t)
+{
+	opened_ = true;
+	return true;
+}
+
+//==============================================================================
+bool CC_Simulator::opened() const
+{	return opened_; }
+
+//==============================================================================
+void CC_Simulator::close()
+{	opened_ = false; }
+
+//==============================================================================
+void CC_Simulator::reset_device()
+{ }
+
+//==============================================================================
+void CC_Simulator::set_configuration(uint_t)
+{ }
+
+//==============================================================================
+void CC_Simulator::claim_interface(uint_t)
+{ }
+
+//==============================================================================
+void CC_Simulator::release_interface(uint_t)
+{ }
+
+//==============================================================================
+void CC_Simulator::device_decriptor(libusb_device_descriptor &descriptor)
+{
+	memset(&descriptor, 0, sizeof(descriptor));
+	descriptor.idVendor = SIMULATOR_VENDOR_ID;
+	descriptor.idProduct = SIMULATOR_PRODUCT_ID;
+	descriptor.bcdDevice = SIMULATOR_DEBUGGER_ID;
+}
+
+//==============================================================================
+void CC_Simulator::string_descriptor_utf8(uint8_t, uint16_t, String &data)
+{	data = "CC Debugger (simulated)"; }
+
+//==============================================================================
+void CC_Simulator::string_descriptor_ascii(uint8_t, String &data)
+{	data = "CC Debugger (simulated)"; }
+
+//==============================================================================
+void CC_Simulator::charge(size_t count)
+{
+	charged_time_ += (uint64_t)model_.transaction_time * 1000 +
+			(uint64_t)(fast_speed_ ? model_.fast_byte_time : model_.byte_time) * count;
+}
+
+//==============================================================================
+int CC_Simulator::bulk_transfer(uint8_t endpoint, uint8_t data[], size_t count,
+		int &transfered)
+{
+	uint64_t cpu_start = thread_cpu_time();
+
+	if (endpoint & LIBUSB_ENDPOINT_IN)
+	{
+		transfered = std::min(count, pending_in_.size());
+		std::copy(pending_in_.begin(), pending_in_.begin() + transfered, data);
+		pending_in_.clear();
+	}
+	else
+	{
+		execute_commands(data, count);
+		transfered = count;
+	}
+	charge(transfered);
+
+	cpu_time_ += thread_cpu_time() - cpu_start;
+	return LIBUSB_SUCCESS;
+}
+
+//==============================================================================
+int CC_Simulator::control_transfer(uint8_t bmRequestType, uint8_t bRequest,
+		uint16_t wValue, uint16_t wIndex, uint8_t data[], size_t count)
+{
+	const uint8_t USB_REQUEST_GET_STATE	= 0xC0;
+	const uint8_t USB_REQUEST_RESET		= 0xC9;
+	const uint8_t USB_REQUEST_SET_SPEED	= 0xCF;
+
+	charge(count);
+
+	if (bRequest == USB_REQUEST_GET_STATE && count >= 6)
+	{
+		data[0] = LOBYTE(unit_ID_);
+		data[1] = HIBYTE(unit_ID_);
+		data[2] = LOBYTE(SIMULATOR_FW_VERSION);
+		data[3] = HIBYTE(SIMULATOR_FW_VERSION);
+		data[4] = LOBYTE(SIMULATOR_FW_REVISION);
+		data[5] = HIBYTE(SIMULATOR_FW_REVISION);
+		return count;
+	}
+	if (bRequest == USB_REQUEST_RESET)
+		reset_target(wIndex != 0);
+	if (bRequest == USB_REQUEST_SET_SPEED)
+		fast_speed_ = wValue == 0;
+
+	if (bmRequestType & LIBUSB_ENDPOINT_IN)
+		memset(data, 0, count);
+	return count;
+}
+
+//==============================================================================
+void CC_Simulator::reset_target(bool halt)
+{
+	halted_ = halt;
+	debug_config_ = 0;
+	acc_ = 0;
+	pc_ = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(breakpoints_); i++)
+		breakpoints_[i].enabled = false;
+	cpu_cycles_ = 0;
+	t1_start_ = 0;
+	set_call_model(call_model_);
+	xdata_[regs_.t1ctl] = 0;
+
+	xdata_[regs_.fctl] = 0;
+	xdata_[regs_.dma_arm] = 0;
+	xdata_[regs_.dma_irq] = 0;
+	if (regs_.memctr)
+		xdata_[regs_.memctr] = 0;
+	if (regs_.fmap)
+		xdata_[regs_.fmap] = 0x01;
+
+	// 16 MHz RC oscillator, crystal is powered down
+	xosc_on_ = false;
+	if (regs_.clkconcmd)
+	{
+		xdata_[regs_.clkconcmd] = 0xC9;
+		xdata_[regs_.clkconsta] = 0xC9;
+		xdata_[regs_.sleepcmd] = 0x04;
+	}
+}
+
+//==============================================================================
+void CC_Simulator::halt_target()
+{
+	halted_ = true;
+
+	uint_t total_weight = 0;
+	foreach (const CpuState &state, cpu_states_)
+		total_weight += state.weight;
+	if (!total_weight)
+		return;
+
+	// LCG, the same sequence on every run
+	random_ = random_ * 1103515245 + 12345;
+	uint_t pick = (random_ >> 8) % total_weight;
+
+	foreach (const CpuState &state, cpu_states_)
+	{
+		if (pick >= state.weight)
+		{
+			pick -= state.weight;
+			continue;
+		}
+
+		pc_ = state.pc;
+		if (regs_.fmap)
+			xdata_[regs_.fmap] = state.bank;
+
+		size_t size = std::min(state.stack.size(), (size_t)0x100 - IRAM_STACK_START);
+		for (size_t i = 0; i < size; i++)
+		{
+			uint8_t address = IRAM_STACK_START + i;
+			xdata_[regs_.iram + address] = state.stack[i];
+			if (address < 0x80)
+				iram_[address] = state.stack[i];
+		}
+		direct_write(SFR_SP, IRAM_STACK_START + size - 1);
+		return;
+	}
+}
+
+//==============================================================================
+bool CC_Simulator::breakpoint_at(uint16_t address) const
+{
+	for (size_t i = 0; i < ARRAY_SIZE(breakpoints_); i++)
+		if (breakpoints_[i].enabled && breakpoints_[i].address == address)
+			return true;
+	return false;
+}
+
+//==============================================================================
+void CC_Simulator::run_target()
+{
+	if (call_model_.durations.empty() ||
+			(!breakpoint_at(call_model_.entry) && !breakpoint_at(call_model_.exit)))
+		return;
+
+	// one of the next two events hits
+	for (;;)
+	{
+		// a step may have gone past a very short call
+		uint64_t cycles = std::max(cpu_cycles_, next_event_);
+		charged_time_ += (cycles - cpu_cycles_) * 125 * clock_divider() / 4;
+		cpu_cycles_ = cycles;
+
+		pc_ = in_call_ ? call_model_.exit : call_model_.entry;
+		if (in_call_)
+		{
+			next_event_ = cycles + call_model_.idle_cycles;
+			call_index_++;
+		}
+		else
+			next_event_ = cycles +
+					call_model_.durations[call_index_ % call_model_.durations.size()];
+		in_call_ = !in_call_;
+
+		if (breakpoint_at(pc_))
+		{
+			halted_ = true;
+			return;
+		}
+	}
+}
+
+//==============================================================================
+uint16_t CC_Simulator::timer1_count() const
+{
+	const uint_t DIVIDER_SHIFT[] = { 0, 3, 5, 7 };
+
+	uint8_t control = xdata_[regs_.t1ctl];
+	if ((control & 0x03) != 0x01) // free-running only
+		return xdata_[regs_.t1cnth] << 8 | xdata_[regs_.t1cntl];
+	return (cpu_cycles_ - t1_start_) >> DIVIDER_SHIFT[(control >> 2) & 0x03];
+}
+
+//==============================================================================
+uint8_t CC_Simulator::debug_status()
+{
+	uint8_t status = 0;
+
+	if (halted_)
+		status |= DEBUG_STATUS_CPU_HALTED;
+
+	// CC253x reports erase in progress, older families report erase done
+	bool erasing = clock() < erase_busy_until_;
+	if (family_ == F_CC253X ? erasing : (erased_ && !erasing))
+		status |= DEBUG_STATUS_CHIP_ERASE_BUSY;
+
+	if (xosc_stable())
+		status |= DEBUG_STATUS_OSCILLATOR_STABLE;
+
+	return status;
+}
+
+//==============================================================================
+// Every command starts with a programmer specific byte followed by the debug
+// command. For debug instructions the first byte tells which operands are
+// taken from the programmer's scratch registers (slots) instead of the stream
+// and where the resulting accumulator goes: to a slot or back to the host.
+void CC_Simulator::execute_commands(const uint8_t data[], size_t count)
+{
+	size_t pos = 0;
+	while (pos + 1 < count)
+	{
+		uint8_t flags = data[pos];
+		uint8_t command = data[pos + 1];
+		pos += 2;
+
+		if (command >= DEBUG_COMMAND_DEBUG_INSTR && command <= DEBUG_COMMAND_DEBUG_INSTR + 2)
+		{
+			size_t size = command - DEBUG_COMMAND_DEBUG_INSTR + 1;
+			uint_t slot = (flags >> 1) & 0x07;
+
+			size_t substituted = 0;
+			if ((flags & 0x80) && slot != 7)
+				substituted = ((flags & 0x40) && (flags & 0x10)) ? 2 : 1;
+
+			uint8_t instr[3];
+			size_t given = std::min(size - substituted, count - pos);
+			memcpy(instr, &data[pos], given);
+			for (size_t i = 0; i < substituted; i++)
+				instr[given + i] = slots_[(slot + i) & 0x07];
+			pos += given;
+
+			execute_instruction(instr, size);
+
+			if ((flags & 0xC0) == 0x40)
+			{
+				if (slot != 7)
+					slots_[slot] = acc_;
+				else
+				if ((flags & 0x30) != 0x10)
+					pending_in_.push_back(acc_);
+			}
+			continue;
+		}
+
+		if ((command & 0xF8) == DEBUG_COMMAND_BURST_WRITE)
+		{
+			if (pos >= count)
+				break;
+			size_t size = ((command & 0x07) << 8) | data[pos++];
+			size = std::min(size, count - pos);
+			burst_write(&data[pos], size);
+			pos += size;
+			continue;
+		}
+
+		switch (command)
+		{
+		case DEBUG_COMMAND_READ_STATUS:
+			pending_in_.push_back(debug_status());
+			break;
+
+		case DEBUG_COMMAND_RD_CONFIG:
+			pending_in_.push_back(debug_config_);
+			break;
+
+		case DEBUG_COMMAND_WR_CONFIG:
+			if (pos < count)
+				debug_config_ = data[pos++];
+			break;
+
+		case DEBUG_COMMAND_CHIP_ERASE:
+			std::fill(flash_.begin(), flash_.end(), FLASH_EMPTY_BYTE);
+			erased_ = true;
+			erase_busy_until_ = clock() + model_.chip_erase_time;
+			break;
+
+		case DEBUG_COMMAND_HALT:
+			if (!halted_)
+				halt_target();
+			break;
+
+		case DEBUG_COMMAND_GET_PC:
+			pending_in_.push_back(HIBYTE(pc_));
+			pending_in_.push_back(LOBYTE(pc_));
+			break;
+
+		case DEBUG_COMMAND_RESUME:
+			halted_ = false;
+			run_target();
+			break;
+
+		case DEBUG_COMMAND_STEP_INSTR:
+			// the call model has single cycle instructions
+			cpu_cycles_++;
+			pc_++;
+			break;
+
+		case DEBUG_COMMAND_SET_HW_BRKPNT:
+			if (pos + 3 <= count)
+			{
+				Breakpoint &breakpoint = breakpoints_[(data[pos] >> 3) & 0x03];
+				breakpoint.enabled = data[pos] & 0x04;
+				breakpoint.address = data[pos + 1] << 8 | data[pos + 2];
+			}
+			pos += 3;
+			break;
+		}
+	}
+}
+
+//==============================================================================
+void CC_Simulator::execute_instruction(const uint8_t instr[], size_t)
+{
+	switch (instr[0])
+	{
+	case 0x74: // MOV A, #data
+		acc_ = instr[1];
+		break;
+
+	case 0x75: // MOV direct, #data
+		direct_write(instr[1], instr[2]);
+		break;
+
+	case 0xE5: // MOV A, direct
+		acc_ = direct_read(instr[1]);
+		break;
+
+	case 0xF5: // MOV direct, A
+		direct_write(instr[1], acc_);
+		break;
+
+	case 0x90: // MOV DPTR, #data16
+		set_dptr((instr[1] << 8) | instr[2]);
+		break;
+
+	case 0xE0: // MOVX A, @DPTR
+		acc_ = xdata_read(dptr());
+		break;
+
+	case 0xF0: // MOVX @DPTR, A
+		xdata_write(dptr(), acc_);
+		break;
+
+	case 0xA3: // INC DPTR
+		set_dptr(dptr() + 1);
+		break;
+
+	case 0xE4: // CLR A
+		acc_ = 0;
+		break;
+
+	case 0x93: // MOVC A, @A+DPTR
+		acc_ = code_read(acc_ + dptr());
+		break;
+	}
+}
+
+//==============================================================================
+void CC_Simulator::burst_write(const uint8_t data[], size_t size)
+{
+	uint8_t armed = xdata_[regs_.dma_arm];
+
+	for (uint_t channel = 0; channel < DMA_CHANNEL_COUNT; channel++)
+	{
+		if (!(armed & (1 << channel)))
+			continue;
+
+		uint16_t desc = (channel == 0) ?
+			(xdata_[regs_.dma0_cfgh] << 8 | xdata_[regs_.dma0_cfgl]) :
+			(xdata_[regs_.dma1_cfgh] << 8 | xdata_[regs_.dma1_cfgl]) + 8 * (channel - 1);
+
+		if ((xdata_[(uint16_t)(desc + 6)] & 0x1F) != DMA_TRIGGER_DBG_BW)
+			continue;
+
+		uint16_t dest = xdata_[desc + 2] << 8 | xdata_[(uint16_t)(desc + 3)];
+		uint_t dest_inc = ((xdata_[(uint16_t)(desc + 7)] >> 4) & 0x03) == 1;
+
+		for (size_t i = 0; i < size; i++)
+			xdata_write(dest + i * dest_inc, data[i]);
+
+		xdata_[regs_.dma_arm] &= ~(1 << channel);
+		xdata_[regs_.dma_irq] |= 1 << channel;
+		return;
+	}
+}
+
+//==============================================================================
+uint16_t CC_Simulator::dptr()
+{	return direct_read(SFR_DPH) << 8 | direct_read(SFR_DPL); }
+
+//==============================================================================
+void CC_Simulator::set_dptr(uint16_t value)
+{
+	direct_write(SFR_DPH, HIBYTE(value));
+	direct_write(SFR_DPL, LOBYTE(value));
+}
+
+//==============================================================================
+uint8_t CC_Simulator::direct_read(uint8_t address)
+{
+	if (address < 0x80)
+		return iram_[address];
+	return xdata_read(regs_.sfr_base + address);
+}
+
+//==============================================================================
+void CC_Simulator::direct_write(uint8_t address, uint8_t value)
+{
+	if (address < 0x80)
+		iram_[address] = value;
+	else
+		xdata_write(regs_.sfr_base + address, value);
+}
+
+//==============================================================================
+ByteVector &CC_Simulator::flash_area()
+{
+	return (debug_config_ & DEBUG_CONFIG_SEL_FLASH_INFO_PAGE) ?
+			info_page_ : flash_;
+}
+
+//==============================================================================
+uint8_t CC_Simulator::code_read(uint16_t address)
+{
+	ByteVector &area = flash_area();
+
+	size_t offset = address;
+	if (regs_.fmap && address >= FLASH_MAPPED_BANK_OFFSET)
+		offset = (xdata_[regs_.fmap] & 0x07) * FLASH_BANK_SIZE +
+				address - FLASH_MAPPED_BANK_OFFSET;
+
+	return offset < area.size() ? area[offset] : FLASH_EMPTY_BYTE;
+}
+
+//==============================================================================
+uint8_t CC_Simulator::xdata_read(uint16_t address, bool dma)
+{
+	// CC243x DMA sees the whole flash bank, registers are hidden by it
+	bool flash_mapped = family_ == F_CC243X && dma &&
+			address >= FLASH_MAPPED_BANK_OFFSET;
+
+	if (!flash_mapped && address == regs_.fctl)
+		return (xdata_[address] & ~FCTL_BUSY) | (flash_busy() ? FCTL_BUSY : 0);
+	if (!flash_mapped && address == regs_.rndl)
+		return LOBYTE(crc_);
+	if (!flash_mapped && address == regs_.rndh)
+		return HIBYTE(crc_);
+	if (!flash_mapped && address == regs_.t1cntl)
+		return LOBYTE(timer1_count());
+	if (!flash_mapped && address == regs_.t1cnth)
+		return HIBYTE(timer1_count());
+
+	size_t offset = address;
+	switch (family_)
+	{
+	case F_CC253X:
+		if (address >= XREG_INFO_PAGE && address < FLASH_MAPPED_BANK_OFFSET)
+			return info_page_[address - XREG_INFO_PAGE];
+		flash_mapped = address >= FLASH_MAPPED_BANK_OFFSET;
+		break;
+
+	case F_CC243X:
+		flash_mapped |= address >= FLASH_MAPPED_BANK_OFFSET &&
+				address < regs_.sfr_base;
+		break;
+
+	case F_CC251X:
+		return (address < flash_.size()) ? flash_[address] : xdata_[address];
+	}
+
+	if (!flash_mapped)
+		return xdata_[address];
+
+	offset = (xdata_[regs_.memctr] & 0x07) * FLASH_BANK_SIZE +
+			address - FLASH_MAPPED_BANK_OFFSET;
+	return offset < flash_.size() ? flash_[offset] : FLASH_EMPTY_BYTE;
+}
+
+//==============================================================================
+void CC_Simulator::xdata_write(uint16_t address, uint8_t value)
+{
+	if (address == regs_.fctl)
+	{
+		xdata_[address] = value & ~FCTL_BUSY;
+		if (value & FCTL_ERASE)
+			page_erase();
+		else
+		if (value & 0x02)
+			flash_trigger();
+		return;
+	}
+	if (address == regs_.rndl)
+	{
+		crc_ = (crc_ << 8) | value;
+		return;
+	}
+	if (address == regs_.rndh)
+	{
+		crc_ = crc16_update(crc_, value);
+		return;
+	}
+	if (address == regs_.fwdata)
+	{
+		flash_program(value);
+		return;
+	}
+	if (address == regs_.t1ctl)
+	{
+		xdata_[address] = value;
+		t1_start_ = cpu_cycles_;
+		return;
+	}
+	if (address == regs_.dma_req)
+	{
+		for (uint_t channel = 0; channel < DMA_CHANNEL_COUNT; channel++)
+			if ((value & (1 << channel)) && (xdata_[regs_.dma_arm] & (1 << channel)))
+				charged_time_ += (uint64_t)model_.dma_byte_time * clock_divider() *
+						dma_transfer(channel);
+		return;
+	}
+	if (address && address == regs_.sleepcmd)
+	{
+		xdata_[address] = value;
+		if (!(value & 0x04) && !xosc_on_)
+		{
+			xosc_on_ = true;
+			xosc_stable_time_ = clock() + model_.xosc_startup_time;
+		}
+		// the oscillator in use isn't powered down
+		if ((value & 0x04) && (xdata_[regs_.clkconsta] & 0x40))
+			xosc_on_ = false;
+		return;
+	}
+	if (address && address == regs_.clkconcmd)
+	{
+		xdata_[address] = value;
+		xdata_[regs_.clkconsta] = xosc_stable() ? value : value | 0x40;
+		return;
+	}
+
+	if (family_ == F_CC253X && address >= XREG_INFO_PAGE)
+		return; // flash
+	if (family_ == F_CC243X && address >= FLASH_MAPPED_BANK_OFFSET &&
+			address < regs_.sfr_base)
+		return;
+	if (family_ == F_CC251X && address < flash_.size())
+		return;
+
+	xdata_[address] = value;
+}
+
+//==============================================================================
+size_t CC_Simulator::dma_transfer(uint_t channel)
+{
+	uint16_t desc = (channel == 0) ?
+		(xdata_[regs_.dma0_cfgh] << 8 | xdata_[regs_.dma0_cfgl]) :
+		(xdata_[regs_.dma1_cfgh] << 8 | xdata_[regs_.dma1_cfgl]) + 8 * (channel - 1);
+
+	uint8_t d[8];
+	for (size_t i = 0; i < sizeof(d); i++)
+		d[i] = xdata_[(uint16_t)(desc + i)];
+
+	uint16_t source = d[0] << 8 | d[1];
+	uint16_t dest = d[2] << 8 | d[3];
+	size_t size = ((d[4] & 0x1F) << 8) | d[5];
+	uint_t source_inc = ((d[7] >> 6) & 0x03) == 1;
+	uint_t dest_inc = ((d[7] >> 4) & 0x03) == 1;
+
+	for (size_t i = 0; i < size; i++)
+		xdata_write(dest + i * dest_inc, xdata_read(source + i * source_inc, true));
+
+	xdata_[regs_.dma_arm] &= ~(1 << channel);
+	xdata_[regs_.dma_irq] |= 1 << channel;
+	return size;
+}
+
+//==============================================================================
+bool CC_Simulator::xosc_stable() const
+{	return xosc_on_ && clock() >= xosc_stable_time_; }
+
+//==============================================================================
+uint_t CC_Simulator::clock_divider() const
+{
+	if (!regs_.clkconsta)
+		return 2; // older families run on 16 MHz RC oscillator
+
+	uint8_t clkcon = xdata_[regs_.clkconsta];
+	uint_t clkspd = clkcon & 0x07;
+	if ((clkcon & 0x40) && !clkspd)
+		clkspd = 1; // RC oscillator is 16 MHz at most
+	return 1 << clkspd;
+}
+
+//==============================================================================
+void CC_Simulator::flash_program(uint8_t value)
+{
+	ByteVector &area = flash_area();
+
+	if (flash_pointer_ < area.size())
+		area[flash_pointer_] &= value;
+	flash_pointer_++;
+}
+
+//==============================================================================
+void CC_Simulator::flash_trigger()
+{
+	flash_pointer_ = (xdata_[regs_.faddrh] << 8 | xdata_[regs_.faddrl]) *
+			flash_word_size_;
+	size_t start = flash_pointer_;
+
+	uint8_t armed = xdata_[regs_.dma_arm];
+	for (uint_t channel = 0; channel < DMA_CHANNEL_COUNT; channel++)
+	{
+		if (!(armed & (1 << channel)))
+			continue;
+
+		uint16_t desc = (channel == 0) ?
+			(xdata_[regs_.dma0_cfgh] << 8 | xdata_[regs_.dma0_cfgl]) :
+			(xdata_[regs_.dma1_cfgh] << 8 | xdata_[regs_.dma1_cfgl]) + 8 * (channel - 1);
+
+		if ((xdata_[(uint16_t)(desc + 6)] & 0x1F) == DMA_TRIGGER_FLASH)
+		{
+			dma_transfer(channel);
+			break;
+		}
+	}
+
+	size_t words = (flash_pointer_ - start) / flash_word_size_;
+	xdata_[regs_.faddrl] = LOBYTE(flash_pointer_ / flash_word_size_);
+	xdata_[regs_.faddrh] = HIBYTE(flash_pointer_ / flash_word_size_);
+
+	flash_busy_until_ = clock() + words * model_.flash_word_time;
+}
+
+//==============================================================================
+void CC_Simulator::page_erase()
+{
+	ByteVector &area = flash_area();
+
+	size_t offset = (xdata_[regs_.faddrh] << 8 | xdata_[regs_.faddrl]) *
+			flash_word_size_;
+	offset -= offset % flash_page_size_;
+
+	if (offset < area.size())
+		std::fill(area.begin() + offset,
+				area.begin() + std::min(area.size(), offset + flash_page_size_),
+				FLASH_EMPTY_BYTE);
+
+	flash_busy_until_ = clock() + model_.page_erase_time;
+}
+
+//==============================================================================
+bool CC_Simulator::flash_busy() const
+{	return clock() < flash_busy_until_; }
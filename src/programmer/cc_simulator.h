@@ -0,0 +1,220 @@
+/*
+ * cc_simulator.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_SIMULATOR_H_
+#define _CC_SIMULATOR_H_
+
+#include "usb/usb_device.h"
+
+/// Software model of CC Debugger with an attached target. It understands the
+/// subset of debug commands and 8051 instructions cc-tool sends, flash
+/// controller, DMA channels and CRC unit, so programmer code can run without
+/// hardware. Time is not spent but charged: every transfer, flash write and
+/// erase adds modeled time to the simulator clock.
+class CC_Simulator : public USB_Device
+{
+public:
+	struct TimingModel
+	{
+		uint_t transaction_time;	// us, per USB transfer
+		uint_t byte_time;			// ns, per transfered byte
+		uint_t fast_byte_time;		// ns, per byte at fast interface speed
+		uint_t flash_word_time;		// us, per programmed flash word
+		uint_t page_erase_time;		// us
+		uint_t chip_erase_time;		// us
+		uint_t dma_byte_time;		// ns, memory to memory DMA at 32 MHz
+		uint_t xosc_startup_time;	// us, crystal oscillator
+
+		TimingModel();
+	};
+
+	void set_timing_model(const TimingModel &model);
+
+	/// Where the simulated firmware may be caught when the running target
+	/// is halted, picked at random by weight
+	struct CpuState
+	{
+		uint16_t pc;
+		uint8_t bank;		// FMAP, ignored by targets without flash banks
+		ByteVector stack;	// internal RAM from 0x08 up to SP
+		uint_t weight;
+	};
+	typedef std::vector<CpuState> CpuStateVector;
+
+	void set_cpu_states(const CpuStateVector &states);
+
+	/// Firmware calling one function over and over, hardware breakpoints set
+	/// at its entry or exit halt the target there. Addresses are below 0x8000,
+	/// times are system clock cycles, Timer 1 counts them undivided.
+	struct CallModel
+	{
+		uint16_t entry;
+		uint16_t exit;
+		UintVector durations;	// entry to exit, taken in turn
+		uint_t idle_cycles;		// exit to the next entry
+
+		CallModel();
+	};
+
+	void set_call_model(const CallModel &model);
+
+	/// Real time passed since device was opened plus all charged time, us
+	uint64_t clock() const;
+
+	/// Simulated device runs on its own clock
+	virtual uint64_t transport_time() const;
+
+	/// Time charged by the model, us
+	uint64_t charged_time() const;
+
+	/// CPU time spent inside the simulator, us
+	uint64_t cpu_time() const;
+
+	const ByteVector &flash() const;
+
+	virtual bool open_by_vid_pid(uint16_t vendor_id, uint16_t product_id);
+	virtual bool open_by_address(uint8_t bus_number, uint8_t device_address);
+	virtual bool opened() const;
+	virtual void close();
+
+	virtual void reset_device();
+	virtual void set_configuration(uint_t configuration);
+	virtual void claim_interface(uint_t interface_number);
+	virtual void release_interface(uint_t interface_number);
+
+	virtual void device_decriptor(libusb_device_descriptor &descriptor);
+	virtual void string_descriptor_utf8(uint8_t index, uint16_t language, String &data);
+	virtual void string_descriptor_ascii(uint8_t index, String &data);
+
+	/// @param unit_ID target ID as reported by programmer, e.g. 0x2530
+	/// @param flash_size target flash size in KB
+	CC_Simulator(uint_t unit_ID, uint_t flash_size);
+
+protected:
+	virtual int bulk_transfer(uint8_t endpoint, uint8_t data[], size_t count,
+			int &transfered);
+	virtual int control_transfer(uint8_t bmRequestType, uint8_t bRequest,
+			uint16_t wValue, uint16_t wIndex, uint8_t data[], size_t count);
+
+private:
+	enum Family { F_CC253X, F_CC243X, F_CC251X };
+
+	/// Xdata addresses of the registers used by the model
+	struct Registers
+	{
+		uint16_t sfr_base;
+		uint16_t fctl;
+		uint16_t faddrl;
+		uint16_t faddrh;
+		uint16_t fwdata;
+		uint16_t rndl;
+		uint16_t rndh;
+		uint16_t dma0_cfgl;
+		uint16_t dma0_cfgh;
+		uint16_t dma1_cfgl;
+		uint16_t dma1_cfgh;
+		uint16_t dma_arm;
+		uint16_t dma_req;
+		uint16_t dma_irq;
+		uint16_t memctr;
+		uint16_t fmap;
+		uint16_t clkconcmd;	// CC253x only
+		uint16_t clkconsta;
+		uint16_t sleepcmd;
+		uint16_t t1cntl;
+		uint16_t t1cnth;
+		uint16_t t1ctl;
+		uint16_t iram;		// internal RAM mirror
+	};
+
+	struct Breakpoint
+	{
+		bool enabled;
+		uint16_t address;	// bank is ignored
+	};
+
+	void charge(size_t count);
+	void reset_target(bool halt);
+	/// Stop the running firmware in one of cpu_states_
+	void halt_target();
+	/// Let the call model run up to the next breakpoint hit, if there is one
+	void run_target();
+	bool breakpoint_at(uint16_t address) const;
+	uint16_t timer1_count() const;
+
+	void execute_commands(const uint8_t data[], size_t count);
+	void execute_instruction(const uint8_t instr[], size_t size);
+	void burst_write(const uint8_t data[], size_t size);
+	uint8_t debug_status();
+
+	uint8_t direct_read(uint8_t address);
+	void direct_write(uint8_t address, uint8_t value);
+	uint8_t xdata_read(uint16_t address, bool dma = false);
+	void xdata_write(uint16_t address, uint8_t value);
+	uint8_t code_read(uint16_t address);
+
+	uint16_t dptr();
+	void set_dptr(uint16_t value);
+
+	/// @return bytes transfered
+	size_t dma_transfer(uint_t channel);
+	void flash_program(uint8_t value);
+	void flash_trigger();
+	void page_erase();
+	bool flash_busy() const;
+	bool xosc_stable() const;
+	/// System clock divider against 32 MHz
+	uint_t clock_divider() const;
+
+	ByteVector &flash_area();
+
+	Family family_;
+	Registers regs_;
+	uint_t unit_ID_;
+	uint_t flash_word_size_;
+	uint_t flash_page_size_;
+	bool opened_;
+
+	ByteVector flash_;
+	ByteVector info_page_;
+	ByteVector xdata_;
+	uint8_t iram_[0x80];
+	uint8_t slots_[8];
+	uint8_t acc_;
+	uint16_t pc_;
+	CpuStateVector cpu_states_;
+	uint32_t random_;
+	CallModel call_model_;
+	Breakpoint breakpoints_[4];
+	uint64_t cpu_cycles_;
+	uint64_t next_event_;	// cycle of the next entry or exit
+	size_t call_index_;
+	bool in_call_;
+	uint64_t t1_start_;
+
+	uint8_t debug_config_;
+	bool halted_;
+	bool erased_;
+	bool fast_speed_;
+	bool xosc_on_;
+	uint64_t xosc_stable_time_;
+	uint16_t crc_;
+	size_t flash_pointer_;
+	uint64_t flash_busy_until_;
+	uint64_t erase_busy_until_;
+
+	ByteVector pending_in_;
+
+	TimingModel model_;
+	uint64_t open_time_;
+	uint64_t charged_time_;
+	uint64_t cpu_time_;
+};
+
+#endif // !_CC_SIMULATOR_H_
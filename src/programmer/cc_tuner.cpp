@@ -0,0 +1,317 @@
+/*
+ * cc_tuner.cpp
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include "log.h"
+#include "data/file.h"
+#include "data/image_cache.h"
+#include "cc_tuner.h"
+
+// Flash is sampled from the beginning, enough to see per transfer overhead
+const size_t TUNE_SAMPLE_SIZE = 8192;
+// Up to MAX_READ_CHUNK_SIZE
+const size_t READ_CHUNK_SIZES[] = { 64, 128, 256, 512, 1024 };
+
+/// Collects flash read into a vector
+class VectorSink : public DataSink
+{
+public:
+	virtual void write(size_t, const uint8_t data[], size_t size)
+	{	data_.insert(data_.end(), data, data + size); }
+
+	VectorSink(ByteVector &data) : data_(data) { }
+
+private:
+	ByteVector &data_;
+};
+
+//==============================================================================
+CC_Tuning::CC_Tuning() :
+		fast_speed(false),
+		flash_read_chunk_size(FLASH_READ_CHUNK_SIZE),
+		xdata_read_chunk_size(XDATA_READ_CHUNK_SIZE),
+		verify_method(CC_Programmer::VM_BY_CRC)
+{ }
+
+//==============================================================================
+std::ostream& operator <<(std::ostream &os, const CC_Tuning &o)
+{
+	os << (o.fast_speed ? "fast" : "slow") << " speed, "
+			<< "read chunk " << o.flash_read_chunk_size << " B, "
+			<< "info page chunk " << o.xdata_read_chunk_size << " B, "
+			<< "verify by " << (o.verify_method == CC_Programmer::VM_BY_CRC ?
+					"crc" : "read");
+	return os;
+}
+
+//==============================================================================
+CC_Tuner::CC_Tuner(CC_Programmer &programmer, const UnitInfo &unit_info) :
+		programmer_(programmer),
+		unit_info_(unit_info)
+{ }
+
+//==============================================================================
+void CC_Tuner::apply(const CC_Tuning &tuning)
+{
+	programmer_.set_debug_interface_speed(tuning.fast_speed ?
+			CC_Programmer::IS_FAST : CC_Programmer::IS_SLOW);
+	programmer_.unit_set_read_chunk_sizes(tuning.flash_read_chunk_size,
+			tuning.xdata_read_chunk_size);
+}
+
+//==============================================================================
+bool CC_Tuner::read_flash_sample(const ByteVector &reference, ByteVector &data,
+		uint64_t &time)
+{
+	size_t size = std::min(TUNE_SAMPLE_SIZE, unit_info_.actual_flash_size());
+
+	data.clear();
+	VectorSink sink(data);
+	try
+	{
+		uint64_t start_time = programmer_.transport_time();
+		programmer_.unit_flash_read(AddressRange(0, size), sink);
+		time = programmer_.transport_time() - start_time;
+	}
+	catch (std::runtime_error &e) // usb error, e.g. timeout
+	{
+		log_info("tuner, flash read failed, %s", e.what());
+		return false;
+	}
+	return reference.empty() || data == reference;
+}
+
+//==============================================================================
+bool CC_Tuner::read_info_page(const ByteVector &reference, ByteVector &data,
+		uint64_t &time)
+{
+	data.clear();
+	try
+	{
+		uint64_t start_time = programmer_.transport_time();
+		programmer_.unit_read_info_page(data);
+		time = programmer_.transport_time() - start_time;
+	}
+	catch (std::runtime_error &e)
+	{
+		log_info("tuner, info page read failed, %s", e.what());
+		return false;
+	}
+	return reference.empty() || data == reference;
+}
+
+//==============================================================================
+bool CC_Tuner::verify_sample(const DataSectionStore &sample,
+		CC_Programmer::VerifyMethod method, uint64_t &time)
+{
+	try
+	{
+		uint64_t start_time = programmer_.transport_time();
+		bool result = programmer_.unit_flash_verify(sample, method);
+		time = programmer_.transport_time() - start_time;
+		return result;
+	}
+	catch (std::runtime_error &e)
+	{
+		log_info("tuner, verify failed, %s", e.what());
+		return false;
+	}
+}
+
+//==============================================================================
+bool CC_Tuner::calibrate(CC_Tuning &tuning)
+{
+	log_info("tuner, calibrate %s", key().c_str());
+
+	tuning = CC_Tuning();
+	apply(tuning);
+
+	if (!unit_info_.actual_flash_size())
+		return false;
+
+	// reference is read twice at defaults to be trusted
+	ByteVector reference, data;
+	uint64_t best_time = 0, time = 0;
+	if (!read_flash_sample(ByteVector(), reference, best_time) ||
+			!read_flash_sample(reference, data, time))
+		return false;
+	best_time = std::min(best_time, time);
+
+	programmer_.set_debug_interface_speed(CC_Programmer::IS_FAST);
+	bool fast_result = read_flash_sample(reference, data, time);
+	if (fast_result && time < best_time)
+	{
+		tuning.fast_speed = true;
+		best_time = time;
+	}
+	else
+	{
+		programmer_.set_debug_interface_speed(CC_Programmer::IS_SLOW);
+		if (!fast_result && !read_flash_sample(reference, data, time))
+			return false; // unit hasn't recovered from the fast attempt
+	}
+	log_info("tuner, fast speed: %u", tuning.fast_speed);
+
+	foreach (size_t chunk_size, READ_CHUNK_SIZES)
+	{
+		if (chunk_size == tuning.flash_read_chunk_size)
+			continue;
+
+		programmer_.unit_set_read_chunk_sizes(chunk_size, tuning.xdata_read_chunk_size);
+		if (read_flash_sample(reference, data, time) && time < best_time)
+		{
+			tuning.flash_read_chunk_size = chunk_size;
+			best_time = time;
+		}
+		log_info("tuner, flash read chunk %u, time: %u us", chunk_size, (uint_t)time);
+	}
+	programmer_.unit_set_read_chunk_sizes(tuning.flash_read_chunk_size,
+			tuning.xdata_read_chunk_size);
+
+	if (unit_info_.flags & UnitInfo::SUPPORT_INFO_PAGE)
+	{
+		ByteVector info_reference;
+		if (read_info_page(ByteVector(), info_reference, best_time))
+		{
+			foreach (size_t chunk_size, READ_CHUNK_SIZES)
+			{
+				if (chunk_size == tuning.xdata_read_chunk_size)
+					continue;
+
+				programmer_.unit_set_read_chunk_sizes(tuning.flash_read_chunk_size,
+						chunk_size);
+				if (read_info_page(info_reference, data, time) && time < best_time)
+				{
+					tuning.xdata_read_chunk_size = chunk_size;
+					best_time = time;
+				}
+			}
+			programmer_.unit_set_read_chunk_sizes(tuning.flash_read_chunk_size,
+					tuning.xdata_read_chunk_size);
+		}
+	}
+
+	// verify of the sample against itself, the faster method that agrees wins
+	DataSectionStore sample;
+	sample.add_section(DataSection(0, reference), true);
+
+	uint64_t crc_time = 0, read_time = 0;
+	bool crc_result = verify_sample(sample, CC_Programmer::VM_BY_CRC, crc_time);
+	bool read_result = verify_sample(sample, CC_Programmer::VM_BY_READ, read_time);
+	if (read_result && (!crc_result || read_time < crc_time))
+		tuning.verify_method = CC_Programmer::VM_BY_READ;
+
+	log_info("tuner, verify by crc: %u us, by read: %u us", (uint_t)crc_time,
+			(uint_t)read_time);
+	return true;
+}
+
+//==============================================================================
+String CC_Tuner::key() const
+{
+	CC_ProgrammerInfo info;
+	programmer_.programmer_info(info);
+
+	std::stringstream ss;
+	ss << (info.debugger_id.empty() ? "-" : info.debugger_id) << " "
+			<< std::hex << std::uppercase << std::setfill('0')
+			<< std::setw(4) << info.fw_version << " "
+			<< std::setw(4) << info.fw_revision << " "
+			<< unit_info_.name;
+	return ss.str();
+}
+
+//==============================================================================
+/// Entry line: debugger fw_version fw_revision target speed flash_chunk
+/// xdata_chunk verify
+static bool parse_entry(const String &line, String &key, CC_Tuning &tuning)
+{
+	std::istringstream in(line);
+	String id, fw_version, fw_revision, target, speed, verify;
+	size_t flash_chunk_size = 0, xdata_chunk_size = 0;
+
+	in >> id >> fw_version >> fw_revision >> target >> speed
+			>> flash_chunk_size >> xdata_chunk_size >> verify;
+	if (!in || (speed != "fast" && speed != "slow") ||
+			(verify != "crc" && verify != "read") ||
+			!flash_chunk_size || flash_chunk_size > MAX_READ_CHUNK_SIZE ||
+			!xdata_chunk_size || xdata_chunk_size > MAX_READ_CHUNK_SIZE)
+		return false;
+
+	key = id + " " + fw_version + " " + fw_revision + " " + target;
+	tuning.fast_speed = speed == "fast";
+	tuning.flash_read_chunk_size = flash_chunk_size;
+	tuning.xdata_read_chunk_size = xdata_chunk_size;
+	tuning.verify_method = verify == "crc" ?
+			CC_Programmer::VM_BY_CRC : CC_Programmer::VM_BY_READ;
+	return true;
+}
+
+//==============================================================================
+bool CC_Tuner::load(const String &file_name, const String &key, CC_Tuning &tuning)
+{
+	std::ifstream in(file_name.c_str());
+
+	String line;
+	while (std::getline(in, line))
+	{
+		String entry_key;
+		CC_Tuning entry;
+		if (line.empty() || line[0] == '#' || !parse_entry(line, entry_key, entry))
+			continue;
+
+		if (entry_key == key)
+		{
+			tuning = entry;
+			return true;
+		}
+	}
+	return false;
+}
+
+//==============================================================================
+void CC_Tuner::save(const String &file_name, const String &key,
+		const CC_Tuning &tuning)
+{
+	boost::system::error_code error;
+	boost::filesystem::path parent = boost::filesystem::path(file_name).parent_path();
+	if (!parent.empty())
+		boost::filesystem::create_directories(parent, error);
+
+	// entries of other debuggers may be saved meanwhile
+	FileLock lock(file_name);
+
+	std::stringstream ss;
+	ss << "# cc-tool tuning: debugger fw_version fw_revision target "
+			"speed flash_chunk xdata_chunk verify\n";
+
+	std::ifstream in(file_name.c_str());
+	String line;
+	while (std::getline(in, line))
+	{
+		String entry_key;
+		CC_Tuning entry;
+		if (parse_entry(line, entry_key, entry) && entry_key != key)
+			ss << line << "\n";
+	}
+	in.close();
+
+	ss << key << " " << (tuning.fast_speed ? "fast" : "slow")
+			<< " " << tuning.flash_read_chunk_size
+			<< " " << tuning.xdata_read_chunk_size
+			<< " " << (tuning.verify_method == CC_Programmer::VM_BY_CRC ?
+					"crc" : "read") << "\n";
+
+	file_replace(file_name, ss.str());
+}
+
+//==============================================================================
+String CC_Tuner::default_file_name()
+{	return ImageCache::default_directory() + "/tuning"; }
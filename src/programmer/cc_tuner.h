@@ -0,0 +1,73 @@
+/*
+ * cc_tuner.h
+ *
+ * Created on: Oct 18, 2026
+ *
+ * License: GNU GPL v2
+ *
+ */
+
+#ifndef _CC_TUNER_H_
+#define _CC_TUNER_H_
+
+#include "cc_programmer.h"
+
+/// Transfer settings of a debugger and target pair
+struct CC_Tuning
+{
+	bool fast_speed;
+	size_t flash_read_chunk_size;
+	size_t xdata_read_chunk_size;
+	CC_Programmer::VerifyMethod verify_method;
+
+	/// Settings cc-tool uses without tuning
+	CC_Tuning();
+};
+
+/// Finds the fastest settings that still read back correctly. Results are
+/// kept in a text file, one line per debugger ID, firmware version and
+/// revision, and target name.
+class CC_Tuner : boost::noncopyable
+{
+public:
+	/// Try fast interface speed, read chunk sizes and verify methods on
+	/// the connected unit, flash content is only read. Settings found are
+	/// left applied.
+	/// @return false if flash doesn't read back consistently at defaults,
+	/// tuning is left at defaults then
+	bool calibrate(CC_Tuning &tuning);
+
+	void apply(const CC_Tuning &tuning);
+
+	/// Identity of the connected debugger and unit settings are saved for
+	String key() const;
+
+	/// @return false if file has no valid entry for key
+	static bool load(const String &file_name, const String &key,
+			CC_Tuning &tuning);
+	/// Add or replace entry of the key, file is replaced atomically
+	static void save(const String &file_name, const String &key,
+			const CC_Tuning &tuning); // throw
+
+	/// $XDG_CACHE_HOME/cc-tool/tuning or ~/.cache/cc-tool/tuning
+	static String default_file_name();
+
+	CC_Tuner(CC_Programmer &programmer, const UnitInfo &unit_info);
+
+private:
+	/// Read flash sample, compare it with reference if it's not empty
+	/// @return false on transfer error or mismatch
+	bool read_flash_sample(const ByteVector &reference, ByteVector &data,
+			uint64_t &time);
+	bool read_info_page(const ByteVector &reference, ByteVector &data,
+			uint64_t &time);
+	bool verify_sample(const DataSectionStore &sample,
+			CC_Programmer::VerifyMethod method, uint64_t &time);
+
+	CC_Programmer &programmer_;
+	const UnitInfo &unit_info_;
+};
+
+std::ostream& operator <<(std::ostream &os, const CC_Tuning &o);
+
+#endif // !_CC_TUNER_H_
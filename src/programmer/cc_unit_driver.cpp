@@ -8,31 +8,283 @@
  *
  */
 
-#include <boost/crc.hpp>
+#include <boost/preprocessor/repetition/repeat.hpp>
 #include "cc_unit_driver.h"
 #include "cc_programmer.h"
 #include "log.h"
+#include "trace.h"
 #include "cc_debug_interface.h"
 
 #include "data/binary_file.h" // remove
 #include "data/hex_file.h"  // remove
 
-typedef boost::crc_optimal<16, 0x8005, 0xFFFF, 0, false, false> CrcCalculator;
-
 const size_t MAX_EMPTY_BLOCK_SIZE = FLASH_BANK_SIZE;
 static uint8_t empty_block_[MAX_EMPTY_BLOCK_SIZE];
 
+// Programmer returns read data in groups of up to 64 bytes
+const size_t READ_GROUP_SIZE = 64;
+
+// Registers saved around commands
+const uint8_t SFR_DPL	= 0x82;
+const uint8_t SFR_DPH	= 0x83;
+const uint8_t SFR_DPS	= 0x92;
+const uint8_t SFR_FMAP	= 0x9F;
+const uint8_t SFR_PSW	= 0xD0;
+
+// Save and restore A, DPTR and DPS around xdata access
+const static uint8_t XDATA_PROLOGUE[] = {
+	CC_INSTR(CC_Nop),
+	CC_INSTR_1(CC_SaveDirect<1>, SFR_DPS),
+	CC_INSTR_2(CC_MovDirect_Imm, SFR_DPS, 0x00),
+	CC_INSTR_1(CC_SaveDirect<2>, SFR_DPH),
+	CC_INSTR_1(CC_SaveDirect<3>, SFR_DPL)
+};
+const static uint8_t XDATA_EPILOGUE[] = {
+	CC_INSTR(CC_RestoreDptr<2>),
+	CC_INSTR_1(CC_RestoreDirect<1>, SFR_DPS),
+	CC_INSTR(CC_RestoreA)
+};
+
+// Save and restore A around SFR access
+const static uint8_t SFR_PROLOGUE[] = { CC_INSTR(CC_Nop) };
+const static uint8_t SFR_EPILOGUE[] = { CC_INSTR(CC_RestoreA) };
+
+// Save and restore A, PSW, DPS, DPTR and FMAP around flash read
+const static uint8_t FLASH_READ_PROLOGUE[] = {
+	CC_INSTR(CC_Nop),
+	CC_INSTR_1(CC_SaveDirect<1>, SFR_PSW),
+	CC_INSTR_1(CC_SaveDirect<2>, SFR_DPS),
+	CC_INSTR_2(CC_MovDirect_Imm, SFR_DPS, 0x00),
+	CC_INSTR_1(CC_SaveDirect<3>, SFR_DPH),
+	CC_INSTR_1(CC_SaveDirect<4>, SFR_DPL),
+	CC_INSTR_1(CC_SaveDirect<5>, SFR_FMAP)
+};
+const static uint8_t FLASH_READ_EPILOGUE[] = {
+	CC_INSTR_1(CC_RestoreDirect<5>, SFR_FMAP),
+	CC_INSTR(CC_RestoreDptr<3>),
+	CC_INSTR_1(CC_RestoreDirect<2>, SFR_DPS),
+	CC_INSTR_1(CC_RestoreDirect<1>, SFR_PSW),
+	CC_INSTR(CC_RestoreA)
+};
+
+#define XDATA_READ_ITEM(z, n, unused) CC_INSTR(CC_MovxA_Dptr), CC_INSTR(CC_IncDptr),
+#define FLASH_READ_ITEM(z, n, unused) \
+	CC_INSTR(CC_ClrA), CC_INSTR(CC_MovcA_Dptr), CC_INSTR(CC_IncDptr),
+
+// Read procedures of a whole group, the last byte is sent to the host
+const static uint8_t XDATA_READ_GROUP[] = {
+	BOOST_PP_REPEAT(63, XDATA_READ_ITEM, ~)
+	CC_INSTR_OUTPUT(CC_MovxA_Dptr), CC_INSTR(CC_IncDptr)
+};
+const static uint8_t FLASH_READ_GROUP[] = {
+	BOOST_PP_REPEAT(63, FLASH_READ_ITEM, ~)
+	CC_INSTR(CC_ClrA), CC_INSTR_OUTPUT(CC_MovcA_Dptr), CC_INSTR(CC_IncDptr)
+};
+
+const size_t XDATA_READ_ITEM_SIZE = CC_MovxA_Dptr::SIZE + CC_IncDptr::SIZE;
+const size_t FLASH_READ_ITEM_SIZE = CC_ClrA::SIZE + CC_MovcA_Dptr::SIZE +
+		CC_IncDptr::SIZE;
+
+BOOST_STATIC_ASSERT(sizeof(XDATA_READ_GROUP) == READ_GROUP_SIZE * XDATA_READ_ITEM_SIZE);
+BOOST_STATIC_ASSERT(sizeof(FLASH_READ_GROUP) == READ_GROUP_SIZE * FLASH_READ_ITEM_SIZE);
+BOOST_STATIC_ASSERT(MAX_READ_CHUNK_SIZE * FLASH_READ_ITEM_SIZE <= CC_Command::MAX_SIZE);
+
+// xdata reads are split to keep command within the buffer
+const size_t XDATA_READ_CHUNK = 1024;
+BOOST_STATIC_ASSERT(sizeof(XDATA_PROLOGUE) + CC_MovDptr_Imm::SIZE +
+		XDATA_READ_CHUNK * XDATA_READ_ITEM_SIZE + sizeof(XDATA_EPILOGUE) <=
+		CC_Command::MAX_SIZE);
+
+//==============================================================================
+/// Append procedure reading count bytes, built of group items.
+/// output_offset is offset of the instruction sending the byte to the host
+static void put_read_proc(CC_Command &command, const uint8_t group[],
+		size_t item_size, size_t output_offset, size_t count)
+{
+	for (; count >= READ_GROUP_SIZE; count -= READ_GROUP_SIZE)
+		command.append(group, READ_GROUP_SIZE * item_size);
+
+	if (!count)
+		return;
+
+	// the group is cut, its last byte must be sent as well
+	size_t size = (count - 1) * item_size;
+	command.append(group, size);
+
+	uint8_t item[16];
+	memcpy(item, group + size, item_size);
+	item[output_offset] |= 1;
+	command.append(item, item_size);
+}
+
 //==============================================================================
-CC_UnitDriver::CC_UnitDriver(USB_Device &programmer, ProgressWatcher &pw) :
+CC_UnitDriver::CC_UnitDriver(USB_Device &programmer, ProgressWatcher &pw,
+		const UnitCoreInfo &reg_info) :
 
 	usb_device_(programmer),
 	pw_(pw),
 	endpoint_in_(0),
-	endpoint_out_(0)
+	endpoint_out_(0),
+	flash_read_chunk_size_(FLASH_READ_CHUNK_SIZE),
+	xdata_read_chunk_size_(XDATA_READ_CHUNK_SIZE),
+	reg_info_(reg_info),
+	write_stamp_(0)
 {
 	memset(empty_block_, FLASH_EMPTY_BYTE, FLASH_BANK_SIZE);
 }
 
+//==============================================================================
+CC_TargetShadow::CC_TargetShadow() :
+		debug_config_(0),
+		debug_config_known_(false)
+{ }
+
+//==============================================================================
+bool CC_TargetShadow::debug_config(uint8_t &config) const
+{
+	if (debug_config_known_)
+		config = debug_config_;
+	return debug_config_known_;
+}
+
+//==============================================================================
+void CC_TargetShadow::set_debug_config(uint8_t config)
+{
+	debug_config_ = config;
+	debug_config_known_ = true;
+}
+
+//==============================================================================
+bool CC_TargetShadow::register_holds(uint16_t address, uint8_t value) const
+{
+	RegisterMap::const_iterator it = registers_.find(address);
+	return it != registers_.end() && it->second == value;
+}
+
+//==============================================================================
+void CC_TargetShadow::set_register(uint16_t address, uint8_t value)
+{	registers_[address] = value; }
+
+//==============================================================================
+void CC_TargetShadow::forget_register(uint16_t address)
+{	registers_.erase(address); }
+
+//==============================================================================
+bool CC_TargetShadow::block_holds(uint16_t address, const uint8_t data[],
+		size_t size) const
+{
+	BlockMap::const_iterator it = blocks_.find(address);
+	return it != blocks_.end() && it->second.size() == size &&
+			!memcmp(&it->second[0], data, size);
+}
+
+//==============================================================================
+void CC_TargetShadow::set_block(uint16_t address, const uint8_t data[], size_t size)
+{
+	forget_range(address, size);
+	blocks_[address].assign(data, data + size);
+}
+
+//==============================================================================
+void CC_TargetShadow::forget_range(uint16_t address, size_t size)
+{
+	registers_.erase(registers_.lower_bound(address),
+			registers_.lower_bound(address + size));
+
+	BlockMap::iterator it = blocks_.begin();
+	while (it != blocks_.end())
+	{
+		if (it->first < address + size && address < it->first + it->second.size())
+			blocks_.erase(it++);
+		else
+			++it;
+	}
+}
+
+//==============================================================================
+void CC_TargetShadow::clear()
+{
+	debug_config_known_ = false;
+	registers_.clear();
+	blocks_.clear();
+}
+
+//==============================================================================
+CC_PollStats::CC_PollStats() :
+		polls(0),
+		wait_time(0)
+{ }
+
+//==============================================================================
+CC_PcSample::CC_PcSample() :
+		pc(0),
+		bank(0),
+		sp(0)
+{ }
+
+//==============================================================================
+const CC_PollStats &CC_UnitDriver::poll_stats() const
+{	return poll_stats_; }
+
+//==============================================================================
+void CC_UnitDriver::reset_poll_stats()
+{	poll_stats_ = CC_PollStats(); }
+
+//==============================================================================
+void CC_UnitDriver::add_poll_stats(uint_t polls, uint64_t wait_time)
+{
+	poll_stats_.polls += polls;
+	poll_stats_.wait_time += wait_time;
+}
+
+//==============================================================================
+void CC_UnitDriver::set_read_chunk_sizes(size_t flash_chunk_size,
+		size_t xdata_chunk_size)
+{
+	flash_read_chunk_size_ = std::max(std::min(flash_chunk_size,
+			MAX_READ_CHUNK_SIZE), (size_t)1);
+	xdata_read_chunk_size_ = std::max(std::min(xdata_chunk_size,
+			MAX_READ_CHUNK_SIZE), (size_t)1);
+}
+
+//==============================================================================
+uint8_t CC_UnitDriver::poll_xdata_memory(uint16_t address, uint8_t mask,
+		uint8_t expected)
+{
+	TraceScope trace("poll_xdata", "driver", "address", address);
+
+	uint64_t start_time = get_monotonic_time();
+	uint_t polls = 0;
+
+	uint8_t value;
+	do
+	{
+		value = read_xdata_memory(address);
+		polls++;
+	}
+	while ((value & mask) != expected);
+
+	add_poll_stats(polls, get_monotonic_time() - start_time);
+	return value;
+}
+
+//==============================================================================
+uint64_t CC_UnitDriver::flash_write_time(size_t size) const
+{	return (uint64_t)size / reg_info_.flash_word_size * reg_info_.flash_word_time; }
+
+//==============================================================================
+uint8_t CC_UnitDriver::wait_flash_ready(uint64_t start_time, uint64_t expected_time)
+{
+	uint64_t elapsed = usb_device_.transport_time() - start_time;
+	if (elapsed < expected_time)
+	{
+		TraceScope trace("flash_wait", "driver");
+		usleep(expected_time - elapsed);
+		add_poll_stats(0, expected_time - elapsed);
+	}
+	return poll_xdata_memory(reg_info_.fctl, FCTL_BUSY, 0);
+}
+
 //==============================================================================
 void CC_UnitDriver::set_programmer_ID(const USB_DeviceID& programmer_ID)
 {
@@ -66,6 +318,179 @@ void CC_UnitDriver::reset(bool debug_mode)
 
 	usb_device_.control_write(LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
 			USB_REQUEST_RESET, 0, index, NULL, 0);
+	shadow_.clear();
+}
+
+//==============================================================================
+void CC_UnitDriver::resume()
+{
+	log_info("programmer, resume target");
+
+	uint8_t command[] = { 0x1C, DEBUG_COMMAND_RESUME };
+
+	usb_device_.bulk_write(endpoint_out_, sizeof(command), command);
+	shadow_.clear(); // target code may change anything
+}
+
+//==============================================================================
+void CC_UnitDriver::sample_pc(CC_PcSample &sample, bool read_stack)
+{
+	const uint8_t SFR_SP 			= 0x81;
+	const uint8_t SFR_FMAP 			= 0x9F;
+	const uint8_t IRAM_STACK_START 	= 0x08; // above register bank 0
+
+	const uint8_t HALT[] 	= { 0x1C, DEBUG_COMMAND_HALT };
+	const uint8_t GET_PC[] 	= { 0x1F, DEBUG_COMMAND_GET_PC };
+	const uint8_t RESUME[] 	= { 0x1C, DEBUG_COMMAND_RESUME };
+
+	// PC, SP and FMAP are returned by a single command
+	command_.clear();
+	command_.append(HALT, sizeof(HALT));
+	command_.append(GET_PC, sizeof(GET_PC));
+	command_.append(SFR_PROLOGUE, sizeof(SFR_PROLOGUE));
+	command_.put_output<CC_MovA_Direct>(SFR_SP);
+	if (reg_info_.fmap)
+		command_.put_output<CC_MovA_Direct>(SFR_FMAP);
+	command_.append(SFR_EPILOGUE, sizeof(SFR_EPILOGUE));
+	if (!read_stack)
+		command_.append(RESUME, sizeof(RESUME));
+
+	uint8_t response[4] = { 0 };
+	size_t response_size = reg_info_.fmap ? 4 : 3;
+
+	usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
+	usb_device_.bulk_read(endpoint_in_, response_size, response);
+
+	sample.pc = response[0] << 8 | response[1];
+	sample.sp = response[2];
+	sample.bank = reg_info_.fmap ? response[3] & 0x07 : 0;
+	sample.stack.clear();
+
+	if (read_stack)
+	{
+		size_t count = sample.sp >= IRAM_STACK_START ?
+				sample.sp - IRAM_STACK_START + 1 : 0;
+		uint16_t address = reg_info_.iram_offset + IRAM_STACK_START;
+
+		command_.clear();
+		if (count)
+		{
+			command_.append(XDATA_PROLOGUE, sizeof(XDATA_PROLOGUE));
+			command_.put<CC_MovDptr_Imm>(HIBYTE(address), LOBYTE(address));
+			put_read_proc(command_, XDATA_READ_GROUP, XDATA_READ_ITEM_SIZE, 0, count);
+			command_.append(XDATA_EPILOGUE, sizeof(XDATA_EPILOGUE));
+		}
+		command_.append(RESUME, sizeof(RESUME));
+
+		sample.stack.resize(count);
+		usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
+		if (count)
+			usb_device_.bulk_read(endpoint_in_, count, &sample.stack[0]);
+	}
+	shadow_.clear();
+
+	log_info("programmer, pc sample, pc: %04Xh, bank: %u, sp: %02Xh",
+			sample.pc, sample.bank, sample.sp);
+}
+
+//==============================================================================
+void CC_UnitDriver::set_hw_breakpoint(size_t number, uint_t address, bool enable)
+{
+	log_info("programmer, set breakpoint %u at %06Xh, enable: %u", number, address,
+			enable);
+
+	CHECK_PARAM(number < CC_BREAKPOINT_COUNT);
+
+	// banked code is addressed by bank and its CPU address at 0x8000
+	uint_t bank = 0;
+	if (address >= FLASH_MAPPED_BANK_OFFSET)
+	{
+		bank = address / FLASH_BANK_SIZE;
+		address = FLASH_MAPPED_BANK_OFFSET + address % FLASH_BANK_SIZE;
+	}
+
+	// number, enable and bank, then CPU address
+	uint8_t command[] = { 0xCC, DEBUG_COMMAND_SET_HW_BRKPNT,
+			(uint8_t)(number << 3 | (enable ? 0x04 : 0) | (bank & 0x03)),
+			HIBYTE(address), LOBYTE(address) };
+
+	usb_device_.bulk_write(endpoint_out_, sizeof(command), command);
+}
+
+//==============================================================================
+bool CC_UnitDriver::wait_halted(uint64_t timeout)
+{
+	TraceScope trace("wait_halted", "driver");
+
+	uint64_t start_time = usb_device_.transport_time();
+	uint_t polls = 0;
+
+	uint8_t status = 0;
+	do
+	{
+		read_debug_status(status);
+		polls++;
+	}
+	while (!(status & DEBUG_STATUS_CPU_HALTED) &&
+			usb_device_.transport_time() - start_time < timeout);
+
+	add_poll_stats(polls, usb_device_.transport_time() - start_time);
+	return status & DEBUG_STATUS_CPU_HALTED;
+}
+
+//==============================================================================
+void CC_UnitDriver::breakpoint_continue(uint16_t &pc, uint16_t &timer)
+{
+	const uint8_t SFR_T1CNTL = 0xE2; // reading it latches T1CNTH
+	const uint8_t SFR_T1CNTH = 0xE3;
+
+	const uint8_t GET_PC[] 	= { 0x1F, DEBUG_COMMAND_GET_PC };
+	const uint8_t STEP[] 	= { 0x1C, DEBUG_COMMAND_STEP_INSTR };
+	const uint8_t RESUME[] 	= { 0x1C, DEBUG_COMMAND_RESUME };
+
+	command_.clear();
+	command_.append(GET_PC, sizeof(GET_PC));
+	command_.append(SFR_PROLOGUE, sizeof(SFR_PROLOGUE));
+	command_.put_output<CC_MovA_Direct>(SFR_T1CNTL);
+	command_.put_output<CC_MovA_Direct>(SFR_T1CNTH);
+	command_.append(SFR_EPILOGUE, sizeof(SFR_EPILOGUE));
+	// target would halt again at once if resumed at the breakpoint
+	command_.append(STEP, sizeof(STEP));
+	command_.append(RESUME, sizeof(RESUME));
+
+	uint8_t response[4] = { 0 };
+	usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
+	usb_device_.bulk_read(endpoint_in_, sizeof(response), response);
+	shadow_.clear();
+
+	pc = response[0] << 8 | response[1];
+	timer = response[3] << 8 | response[2];
+
+	log_info("programmer, breakpoint hit, pc: %04Xh, timer: %04Xh", pc, timer);
+}
+
+//==============================================================================
+void CC_UnitDriver::start_timer(uint_t divider)
+{
+	const uint8_t SFR_T1CTL = 0xE4;
+	const uint8_t T1CTL_FREE_RUNNING = 0x01;
+
+	const uint_t DIVIDERS[] = { 1, 8, 32, 128 }; // by T1CTL.DIV
+
+	uint8_t div = 0;
+	while (div < 3 && DIVIDERS[div] < divider)
+		div++;
+	write_sfr(SFR_T1CTL, div << 2 | T1CTL_FREE_RUNNING);
+}
+
+//==============================================================================
+uint_t CC_UnitDriver::cycles_per_timer_tick()
+{
+	// both are power of two dividers of the system clock source
+	uint8_t status = read_xdata_memory(reg_info_.clock_status);
+	uint_t tick_speed = (status >> 3) & 0x07;
+	uint_t clock_speed = status & 0x07;
+	return tick_speed > clock_speed ? 1 << (tick_speed - clock_speed) : 1;
 }
 
 //==============================================================================
@@ -86,12 +511,16 @@ void CC_UnitDriver::read_debug_status(uint8_t &status)
 //==============================================================================
 void CC_UnitDriver::read_debug_config(uint8_t &config)
 {
+	if (shadow_.debug_config(config))
+		return;
+
 	log_info("programmer, read debug config");
 
 	uint8_t command[] = { 0x1F, DEBUG_COMMAND_RD_CONFIG };
 
 	usb_device_.bulk_write(endpoint_out_, sizeof(command), command);
 	usb_device_.bulk_read(endpoint_in_, 1, &config);
+	shadow_.set_debug_config(config);
 
 	log_info("programmer, debug config, %02Xh", config);
 }
@@ -99,31 +528,46 @@ void CC_UnitDriver::read_debug_config(uint8_t &config)
 //==============================================================================
 void CC_UnitDriver::write_debug_config(uint8_t config)
 {
+	uint8_t known_config = 0;
+	if (shadow_.debug_config(known_config) && known_config == config)
+		return;
+
 	log_info("programmer, write debug config, %02Xh", config);
 
 	uint8_t command[] = { 0x4C, DEBUG_COMMAND_WR_CONFIG, config };
 
 	usb_device_.bulk_write(endpoint_out_, sizeof(command), command);
+	shadow_.set_debug_config(config);
 }
 
 //==============================================================================
 bool CC_UnitDriver::erase_page(uint_t page_offset)
 {
+	TraceScope trace("erase_page", "driver", "offset", page_offset);
+
 	page_offset /= reg_info_.flash_word_size;
 
-	write_xdata_memory(reg_info_.faddrl, 0);
-	write_xdata_memory(reg_info_.faddrh, HIBYTE(page_offset));
+	write_xdata_register(reg_info_.faddrl, 0);
+	write_xdata_register(reg_info_.faddrh, HIBYTE(page_offset));
 
 	// erase
 	write_xdata_memory(reg_info_.fctl, FCTL_ERASE);
+	uint64_t start_time = usb_device_.transport_time();
 
-	// wait for write to finish
-	uint8_t reg;
-	while ((reg = read_xdata_memory(reg_info_.fctl)) & FCTL_BUSY);
+	// wait for erase to finish
+	uint8_t reg = wait_flash_ready(start_time, reg_info_.page_erase_time * 1000);
 
 	return !(reg & FCTL_ABORT);
 }
 
+//==============================================================================
+bool CC_UnitDriver::clock_boost()
+{	return false; }
+
+//==============================================================================
+void CC_UnitDriver::clock_restore()
+{ }
+
 //==============================================================================
 void CC_UnitDriver::erase()
 {
@@ -132,6 +576,7 @@ void CC_UnitDriver::erase()
 	uint8_t command[] = { 0x1C, DEBUG_COMMAND_CHIP_ERASE };
 
 	usb_device_.bulk_write(endpoint_out_, sizeof(command), command);
+	shadow_.clear();
 }
 
 //==============================================================================
@@ -139,16 +584,15 @@ void CC_UnitDriver::write_sfr(uint8_t address, uint8_t value)
 {
 	log_info("write sfr at %02Xh, value: %02Xh", address, value);
 
-	uint8_t header[] 		= { 0x40, 0x55, 0x00, };
-	uint8_t mov_a_direct[] 	= { 0xBE, 0x57, 0x75, address, value };
-	uint8_t footer[] 		= { 0x90, 0x56, 0x74 };
+	command_.clear();
+	command_.append(SFR_PROLOGUE, sizeof(SFR_PROLOGUE));
+	command_.put<CC_MovDirect_Imm>(address, value);
+	command_.append(SFR_EPILOGUE, sizeof(SFR_EPILOGUE));
 
-	ByteVector command;
-	vector_append(command, header, sizeof(header));
-	vector_append(command, mov_a_direct, sizeof(mov_a_direct));
-	vector_append(command, footer, sizeof(footer));
+	usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
 
-	usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
+	// SFRs are mapped to xdata, don't track which one is hit
+	shadow_.forget_range(0, 0x10000);
 }
 
 //==============================================================================
@@ -156,16 +600,12 @@ void CC_UnitDriver::read_sfr(uint8_t address, uint8_t &value)
 {
 	log_info("programmer, read sfr at %02Xh", address);
 
-	uint8_t header[] 		= { 0x40, 0x55, 0x00, };
-	uint8_t mov_a_direct[] 	= { 0x7F, 0x56, 0xE5, address };
-	uint8_t footer[] 		= { 0x90, 0x56, 0x74 };
+	command_.clear();
+	command_.append(SFR_PROLOGUE, sizeof(SFR_PROLOGUE));
+	command_.put_output<CC_MovA_Direct>(address);
+	command_.append(SFR_EPILOGUE, sizeof(SFR_EPILOGUE));
 
-	ByteVector command;
-	vector_append(command, header, sizeof(header));
-	vector_append(command, mov_a_direct, sizeof(mov_a_direct));
-	vector_append(command, footer, sizeof(footer));
-
-	usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
+	usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
 	usb_device_.bulk_read(endpoint_in_, 1, &value);
 
 	log_info("programmer, sfr value: %02Xh", value);
@@ -174,51 +614,40 @@ void CC_UnitDriver::read_sfr(uint8_t address, uint8_t &value)
 //==============================================================================
 uint8_t CC_UnitDriver::read_xdata_memory(uint16_t address)
 {
-	ByteVector data;
-	read_xdata_memory(address, 1, data);
-	return data[0];
+	uint8_t value = 0;
+	read_xdata_memory(address, 1, &value);
+	return value;
 }
 
 //==============================================================================
 void CC_UnitDriver::read_xdata_memory(uint16_t address, size_t count, ByteVector &data)
 {
-	log_info("programmer, read xdata memory at %04Xh, count: %u", address, count);
-
-	uint8_t header[] = {
-			0x40, 0x55, 0x00, 0x72, 0x56, 0xE5, 0x92, 0xBE, 0x57, 0x75,
-			0x92, 0x00, 0x74, 0x56, 0xE5, 0x83, 0x76, 0x56, 0xE5, 0x82 };
-
-	uint8_t footer[] 	= { 0xD4, 0x57, 0x90, 0xC2, 0x57, 0x75, 0x92, 0x90, 0x56, 0x74 };
-
-	uint8_t load_dtpr[] = { 0xBE, 0x57, 0x90, 0x00, 0x00 };
-	uint8_t mov_a_dtpr[] = { 0x4E, 0x55, 0xE0 };
-	uint8_t inc_dtpr[] 	= { 0x5E, 0x55, 0xA3 };
-
-	ByteVector command;
-	vector_append(command, header, sizeof(header));
+	data.resize(count);
+	if (count)
+		read_xdata_memory(address, count, &data[0]);
+}
 
-	load_dtpr[sizeof(load_dtpr) - 1] = address;
-	load_dtpr[sizeof(load_dtpr) - 2] = address >> 8;
-	vector_append(command, load_dtpr, sizeof(load_dtpr));
+//==============================================================================
+void CC_UnitDriver::read_xdata_memory(uint16_t address, size_t count, uint8_t data[])
+{
+	log_info("programmer, read xdata memory at %04Xh, count: %u", address, count);
 
-	for (size_t i = 0; i < count; i++)
+	for (size_t offset = 0; offset < count; offset += XDATA_READ_CHUNK)
 	{
-		if (i == (count - 1) || !((i + 1) % 64))
-			mov_a_dtpr[0] |= 1;
-		else
-			mov_a_dtpr[0] &= ~1;
+		size_t size = std::min(count - offset, XDATA_READ_CHUNK);
+		uint16_t chunk_address = address + offset;
 
-		vector_append(command, mov_a_dtpr, sizeof(mov_a_dtpr));
-		vector_append(command, inc_dtpr, sizeof(inc_dtpr));
-	}
-	vector_append(command, footer, sizeof(footer));
+		command_.clear();
+		command_.append(XDATA_PROLOGUE, sizeof(XDATA_PROLOGUE));
+		command_.put<CC_MovDptr_Imm>(HIBYTE(chunk_address), LOBYTE(chunk_address));
+		put_read_proc(command_, XDATA_READ_GROUP, XDATA_READ_ITEM_SIZE, 0, size);
+		command_.append(XDATA_EPILOGUE, sizeof(XDATA_EPILOGUE));
 
-	data.resize(count);
-
-	usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
-	usb_device_.bulk_read(endpoint_in_, count, &data[0]);
+		usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
+		usb_device_.bulk_read(endpoint_in_, size, data + offset);
+	}
 
-	log_info("programmer, read xdata memory, data: %s", binary_to_hex(&data[0], count, " ").c_str());
+	log_info("programmer, read xdata memory, data: %s", binary_to_hex(data, count, " ").c_str());
 }
 
 //==============================================================================
@@ -256,31 +685,54 @@ void CC_UnitDriver::write_xdata_memory(uint16_t address, const uint8_t data[], s
 {
 	log_info("programmer, write xdata memory at %04Xh, count: %u", address, size);
 
-	uint8_t header[] = {
-			0x40, 0x55, 0x00, 0x72, 0x56, 0xE5, 0x92, 0xBE, 0x57, 0x75, 0x92, 0x00,
-			0x74, 0x56, 0xE5, 0x83, 0x76, 0x56, 0xE5, 0x82 };
+	for (size_t offset = 0; offset < size; offset += XDATA_WRITE_CHUNK_SIZE)
+	{
+		size_t count = std::min(size - offset, XDATA_WRITE_CHUNK_SIZE);
+		uint16_t chunk_address = address + offset;
 
-	uint8_t footer[] = { 0xD4, 0x57, 0x90, 0xC2, 0x57, 0x75, 0x92, 0x90, 0x56, 0x74 };
+		command_.clear();
+		command_.append(XDATA_PROLOGUE, sizeof(XDATA_PROLOGUE));
+		command_.put<CC_MovDptr_Imm>(HIBYTE(chunk_address), LOBYTE(chunk_address));
 
-	uint8_t load_dtpr[] 	= { 0xBE, 0x57, 0x90, HIBYTE(address), LOBYTE(address) };
-	uint8_t mov_a_data[] 	= { 0x8E, 0x56, 0x74, 0x00 };
-	uint8_t mov_dtpr_a[]	= { 0x5E, 0x55, 0xF0 };
-	uint8_t inc_dtpr[] 		= { 0x5E, 0x55, 0xA3 };
+		for (size_t i = offset; i < offset + count; i++)
+		{
+			command_.put<CC_MovA_Imm>(data[i]);
+			command_.put<CC_MovxDptr_A>();
+			command_.put<CC_IncDptr>();
+		}
+		command_.append(XDATA_EPILOGUE, sizeof(XDATA_EPILOGUE));
 
-	ByteVector command;
-	vector_append(command, header, sizeof(header));
-	vector_append(command, load_dtpr, sizeof(load_dtpr));
+		usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
+	}
 
-	for (size_t i = 0; i < size; i++)
+	shadow_.forget_range(address, size);
+	if (address == reg_info_.fctl)
 	{
-		mov_a_data[3] = data[i];
-		vector_append(command, mov_a_data, sizeof(mov_a_data));
-		vector_append(command, mov_dtpr_a, sizeof(mov_dtpr_a));
-		vector_append(command, inc_dtpr, sizeof(inc_dtpr));
+		// flash controller advances FADDR
+		shadow_.forget_register(reg_info_.faddrl);
+		shadow_.forget_register(reg_info_.faddrh);
 	}
-	vector_append(command, footer, sizeof(footer));
+}
+
+//==============================================================================
+void CC_UnitDriver::write_xdata_register(uint16_t address, uint8_t value)
+{
+	if (shadow_.register_holds(address, value))
+		return;
+
+	write_xdata_memory(address, value);
+	shadow_.set_register(address, value);
+}
 
-	usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
+//==============================================================================
+void CC_UnitDriver::load_xdata_block(uint16_t address, const uint8_t data[],
+		size_t size)
+{
+	if (shadow_.block_holds(address, data, size))
+		return;
+
+	write_xdata_memory(address, data, size);
+	shadow_.set_block(address, data, size);
 }
 
 //==============================================================================
@@ -327,136 +779,141 @@ bool CC_UnitDriver::flash_verify_by_read(const DataSectionStore &section_store)
 //==============================================================================
 bool CC_UnitDriver::flash_verify_by_crc(const DataSectionStore &section_store)
 {
-	// Channel 0: Flash mapped to Xdata -> CRC shift register
-	uint8_t dma_desc[8] = {
-		  HIBYTE(reg_info_.xbank_offset),   // src[15:8]
-		  LOBYTE(reg_info_.xbank_offset),   // src[7:0]
-		  HIBYTE(reg_info_.rndh),    		// dest[15:8]
-		  LOBYTE(reg_info_.rndh),      		// dest[7:0]
-		  HIBYTE(reg_info_.verify_block_size),// block size[15:8]
-		  LOBYTE(reg_info_.verify_block_size),// block size[7:0]
-		  0x20,                     		// no trigger event, block mode
-		  0x42,                   			// increment source
-	};
+	FlashBlockCrcList blocks;
+	flash_block_crcs(section_store, reg_info_.verify_block_size,
+			FLASH_BANK_SIZE, blocks);
+	return flash_verify_by_crc(blocks);
+}
 
-	write_xdata_memory(reg_info_.dma_arm, 0x00);
+//==============================================================================
+bool CC_UnitDriver::flash_verify_by_crc(const FlashBlockCrcList &blocks)
+{
+	crc_dma_init();
+	size_t flash_bank = 0xFF; // correct flash bank will be set later
 
-	// set the pointer to the DMA descriptors
-	write_xdata_memory(reg_info_.dma0_cfgl, LOBYTE(reg_info_.dma0_cfg_offset));
-	write_xdata_memory(reg_info_.dma0_cfgh, HIBYTE(reg_info_.dma0_cfg_offset));
+	size_t total_size = 0;
+	foreach (const FlashBlockCrc &block, blocks)
+		total_size += block.size;
+	pw_.read_start(total_size);
+
+	foreach (const FlashBlockCrc &block, blocks)
+	{
+		if (flash_block_crc(block.address, block.size, true, flash_bank) != block.crc)
+			return false;
 
+		pw_.read_progress(block.size);
+	}
+	pw_.read_finish();
+	return true;
+}
+
+//==============================================================================
+void CC_UnitDriver::flash_read_crc(FlashBlockCrcList &blocks)
+{
+	crc_dma_init();
 	size_t flash_bank = 0xFF; // correct flash bank will be set later
 
-	pw_.read_start(section_store.actual_size());
+	size_t total_size = 0;
+	foreach (const FlashBlockCrc &block, blocks)
+		total_size += block.size;
+	pw_.read_start(total_size);
 
-	foreach (const DataSection &section, section_store.sections())
+	foreach (FlashBlockCrc &block, blocks)
 	{
-		size_t section_offset = section.address;
-		size_t total_size = section.size();
-		size_t bank_offset = section_offset % FLASH_BANK_SIZE;
-		while (total_size)
+		size_t offset = 0;
+		while (offset < block.size)
 		{
-			size_t count = std::min(total_size, reg_info_.verify_block_size);
-			size_t flash_bank_0 = section_offset / FLASH_BANK_SIZE;
-			size_t flash_bank_1 = (section_offset + count) / FLASH_BANK_SIZE;
-
-			if (flash_bank_0 != flash_bank_1)
-				count = FLASH_BANK_SIZE - (section_offset % FLASH_BANK_SIZE);
-
-			if (flash_bank != flash_bank_0)
-			{
-				flash_bank = flash_bank_0;
-				if (reg_info_.memctr)
-					write_xdata_memory(reg_info_.memctr, flash_bank);
-				bank_offset = section_offset % FLASH_BANK_SIZE;
-			}
-
-			dma_desc[0] = HIBYTE(bank_offset + reg_info_.xbank_offset);
-			dma_desc[1] = LOBYTE(bank_offset + reg_info_.xbank_offset);
-			dma_desc[4] = HIBYTE(count);
-			dma_desc[5] = LOBYTE(count);
-			write_xdata_memory(reg_info_.dma0_cfg_offset, dma_desc, sizeof(dma_desc));
-
-			CrcCalculator crc_calc;
-			crc_calc.process_bytes(&section.data[section.size() - total_size], count);
-			if (calc_block_crc() != crc_calc.checksum())
-				return false;
-
-			total_size -= count;
-			section_offset += count;
-			bank_offset += count;
-
-			pw_.read_progress(count);
+			size_t count = std::min(block.size - offset, reg_info_.verify_block_size);
+			block.crc = flash_block_crc(block.address + offset, count, !offset,
+					flash_bank);
+			offset += count;
 		}
+		pw_.read_progress(block.size);
 	}
 	pw_.read_finish();
-	return true;
 }
 
 //==============================================================================
-uint16_t CC_UnitDriver::calc_block_crc()
+void CC_UnitDriver::crc_dma_init()
 {
-	write_xdata_memory(reg_info_.rndl, 0xFF);
-	write_xdata_memory(reg_info_.rndl, 0xFF);
-	write_xdata_memory(reg_info_.dma_arm, 0x01);
-	write_xdata_memory(reg_info_.dma_req, 0x01);
+	write_xdata_memory(reg_info_.dma_arm, 0x00);
 
-	while (!(read_xdata_memory(reg_info_.dma_irq) & 0x01));
+	// set the pointer to the DMA descriptors
+	write_xdata_register(reg_info_.dma0_cfgl, LOBYTE(reg_info_.dma0_cfg_offset));
+	write_xdata_register(reg_info_.dma0_cfgh, HIBYTE(reg_info_.dma0_cfg_offset));
+}
 
-	ByteVector xsfr;
-	read_xdata_memory(reg_info_.rndl, 2, xsfr);
-	return xsfr[0] | (xsfr[1] << 8);
+//==============================================================================
+uint16_t CC_UnitDriver::flash_block_crc(uint_t address, size_t size, bool seed,
+		size_t &flash_bank)
+{
+	if (flash_bank != address / FLASH_BANK_SIZE)
+	{
+		flash_bank = address / FLASH_BANK_SIZE;
+		if (reg_info_.memctr)
+			write_xdata_register(reg_info_.memctr, flash_bank);
+	}
+
+	// Channel 0: Flash mapped to Xdata -> CRC shift register
+	size_t source = address % FLASH_BANK_SIZE + reg_info_.xbank_offset;
+	uint8_t dma_desc[8] = {
+		  HIBYTE(source),   				// src[15:8]
+		  LOBYTE(source),   				// src[7:0]
+		  HIBYTE(reg_info_.rndh),    		// dest[15:8]
+		  LOBYTE(reg_info_.rndh),      		// dest[7:0]
+		  HIBYTE(size),						// block size[15:8]
+		  LOBYTE(size),						// block size[7:0]
+		  0x20,                     		// no trigger event, block mode
+		  0x42,                   			// increment source
+	};
+	load_xdata_block(reg_info_.dma0_cfg_offset, dma_desc, sizeof(dma_desc));
+
+	return calc_block_crc(seed);
 }
 
 //==============================================================================
-static void create_read_proc(size_t count, ByteVector &proc)
+uint16_t CC_UnitDriver::calc_block_crc(bool seed)
 {
-	uint8_t clr_a[]			= { 0x5E, 0x55, 0xE4 };
-	uint8_t mov_c_a_dptr_a[]= { 0x4E, 0x55, 0x93 };
-	uint8_t inc_dptr[]		= { 0x5E, 0x55, 0xA3 };
+	TraceScope trace("calc_block_crc", "driver");
 
-	proc.clear();
-	for (size_t i = 0; i < count; i++)
+	if (seed)
 	{
-		vector_append(proc, clr_a, sizeof(clr_a));
-		if (!((i + 1) % 64) || i == (count - 1))
-			mov_c_a_dptr_a[0] |= 0x01;
-		vector_append(proc, mov_c_a_dptr_a, sizeof(mov_c_a_dptr_a));
-		mov_c_a_dptr_a[0] &= ~0x01;
-		vector_append(proc, inc_dptr, sizeof(inc_dptr));
+		write_xdata_memory(reg_info_.rndl, 0xFF);
+		write_xdata_memory(reg_info_.rndl, 0xFF);
 	}
+	write_xdata_memory(reg_info_.dma_arm, 0x01);
+	write_xdata_memory(reg_info_.dma_req, 0x01);
+
+	poll_xdata_memory(reg_info_.dma_irq, 0x01, 0x01);
+
+	uint8_t xsfr[2];
+	read_xdata_memory(reg_info_.rndl, 2, xsfr);
+	return xsfr[0] | (xsfr[1] << 8);
 }
 
 //==============================================================================
 void CC_UnitDriver::flash_read_near(uint16_t address, size_t size, ByteVector &data)
 {
-	const uint8_t load_dtpr[] = { 0xBE, 0x57, 0x90, HIBYTE(address), LOBYTE(address) };
-	usb_device_.bulk_write(endpoint_out_, sizeof(load_dtpr), load_dtpr);
+	command_.clear();
+	command_.put<CC_MovDptr_Imm>(HIBYTE(address), LOBYTE(address));
+	usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
 
 	size_t offset = data.size();
 	data.resize(offset + size, FLASH_EMPTY_BYTE);
 
-	ByteVector command;
-	for (size_t i = 0; i < size / FLASH_READ_CHUNK_SIZE; i++)
+	for (size_t done = 0; done < size; )
 	{
-		if (command.empty())
-			create_read_proc(FLASH_READ_CHUNK_SIZE, command);
+		size_t count = std::min(size - done, flash_read_chunk_size_);
 
-		usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
-		usb_device_.bulk_read(endpoint_in_, FLASH_READ_CHUNK_SIZE, &data[offset]);
-		offset += FLASH_READ_CHUNK_SIZE;
+		command_.clear();
+		put_read_proc(command_, FLASH_READ_GROUP, FLASH_READ_ITEM_SIZE,
+				CC_ClrA::SIZE, count);
 
-		pw_.read_progress(FLASH_READ_CHUNK_SIZE);
-	}
-
-	if ((size % FLASH_READ_CHUNK_SIZE))
-	{
-		create_read_proc(size % FLASH_READ_CHUNK_SIZE, command);
+		usb_device_.bulk_write(endpoint_out_, command_.size(), command_.data());
+		usb_device_.bulk_read(endpoint_in_, count, &data[offset + done]);
+		done += count;
 
-		usb_device_.bulk_write(endpoint_out_, command.size(), &command[0]);
-		usb_device_.bulk_read(endpoint_in_, size - offset, &data[offset]);
-
-		pw_.read_progress(size - offset);
+		pw_.read_progress(count);
 	}
 }
 
@@ -467,19 +924,14 @@ void CC_UnitDriver::flash_read(size_t offset, size_t size, ByteVector &flash_dat
 
 	while (size)
 	{
+		// read doesn't go past the bank, offset may be unaligned
 		size_t bank_offset = offset % FLASH_BANK_SIZE;
-		size_t count = std::min(size, (size_t)0x8000);
-		uint8_t flash_bank_0 = offset / FLASH_BANK_SIZE;
-		uint8_t flash_bank_1 = (offset + count) / FLASH_BANK_SIZE;
-
-		if (flash_bank_0 != flash_bank_1)
-			size_t count = ((offset + count) % FLASH_BANK_SIZE);
+		size_t count = std::min(size, FLASH_BANK_SIZE - bank_offset);
 
-		if (flash_bank != flash_bank_0)
+		if (flash_bank != offset / FLASH_BANK_SIZE)
 		{
-			flash_bank = flash_bank_0;
-			write_xdata_memory(reg_info_.fmap, flash_bank);
-			bank_offset = offset % FLASH_BANK_SIZE;
+			flash_bank = offset / FLASH_BANK_SIZE;
+			write_xdata_register(reg_info_.fmap, flash_bank);
 		}
 
 		flash_read_near(bank_offset + reg_info_.xbank_offset, count, flash_data);
@@ -499,23 +951,18 @@ void CC_UnitDriver::flash_read_start()
 			USB_PREPARE, 0, 0, &byte, 1);
 	//reset(true); // if write and lock verifing will fail after reset
 
-	uint8_t header[] = {
-		0x40, 0x55, 0x00, 0x72, 0x56, 0xE5, 0xD0, 0x74, 0x56, 0xE5, 0x92, 0xBE,
-		0x57, 0x75, 0x92, 0x00, 0x76, 0x56, 0xE5, 0x83, 0x78, 0x56, 0xE5, 0x82,
-		0x7A, 0x56, 0xE5, 0x9F
-	};
-
-	usb_device_.bulk_write(endpoint_out_, sizeof(header), header);
+	usb_device_.bulk_write(endpoint_out_, sizeof(FLASH_READ_PROLOGUE),
+			FLASH_READ_PROLOGUE);
 }
 
 //==============================================================================
 void CC_UnitDriver::flash_read_end()
 {
-	uint8_t command[] = {
-			0xCA, 0x57, 0x75, 0x9F, 0xD6, 0x57, 0x90, 0xC4, 0x57,
-			0x75, 0x92, 0xC2, 0x57, 0x75, 0xD0, 0x90, 0x56, 0x74
-	};
-	usb_device_.bulk_write(endpoint_out_, sizeof(command), command);
+	usb_device_.bulk_write(endpoint_out_, sizeof(FLASH_READ_EPILOGUE),
+			FLASH_READ_EPILOGUE);
+
+	// FMAP is restored to the value saved by flash_read_start
+	shadow_.forget_register(reg_info_.fmap);
 }
 
 //==============================================================================
@@ -541,12 +988,12 @@ uint_t CC_UnitDriver::lock_data_size() const
 }
 
 //==============================================================================
-UnitCoreInfo CC_UnitDriver::get_reg_info()
-{	return reg_info_; }
+void CC_UnitDriver::select_core_info(const UnitCoreInfo &reg_info)
+{	reg_info_ = reg_info; }
 
 //==============================================================================
-void CC_UnitDriver::set_reg_info(const UnitCoreInfo &reg_info)
-{	reg_info_ = reg_info; }
+void CC_UnitDriver::set_iram_offset(uint16_t iram_offset)
+{	reg_info_.iram_offset = iram_offset; }
 
 //==============================================================================
 bool CC_UnitDriver::empty_block(const uint8_t* data, size_t size)
@@ -605,7 +1052,41 @@ void CC_UnitDriver::convert_lock_data_std_set(
 }
 
 //==============================================================================
-void CC_UnitDriver::write_flash_slow(const DataSectionStore &section_store)
+uint_t CC_UnitDriver::chip_erase_time() const
+{	return reg_info_.chip_erase_time; }
+
+//==============================================================================
+size_t CC_UnitDriver::verify_block_size() const
+{	return reg_info_.verify_block_size; }
+
+//==============================================================================
+void CC_UnitDriver::prepare_write_view(const DataSectionStore &sections,
+		size_t block_size)
+{
+	write_view_.reset(sections, block_size, FLASH_EMPTY_BYTE);
+	write_stamp_ = sections.stamp();
+}
+
+//==============================================================================
+bool CC_UnitDriver::write_prepared(const DataSectionStore &sections) const
+{	return write_stamp_ && write_stamp_ == sections.stamp(); }
+
+//==============================================================================
+DataBlockView &CC_UnitDriver::take_write_view()
+{
+	write_stamp_ = 0;
+	return write_view_;
+}
+
+//==============================================================================
+void CC_UnitDriver::flash_write_prepare(const DataSectionStore &sections)
+{
+	TraceScope trace("flash_write_prepare", "driver");
+	prepare_write_view(sections, reg_info_.write_block_size);
+}
+
+//==============================================================================
+void CC_UnitDriver::load_write_descriptors()
 {
 	const size_t WRITE_BLOCK_SIZE = reg_info_.write_block_size;
 
@@ -622,42 +1103,63 @@ void CC_UnitDriver::write_flash_slow(const DataSectionStore &section_store)
 	};
 
 	// Load dma descriptors
-	write_xdata_memory(reg_info_.dma0_cfg_offset, dma_desc, sizeof(dma_desc));
+	load_xdata_block(reg_info_.dma0_cfg_offset, dma_desc, sizeof(dma_desc));
+}
 
-	// Set the pointer to the DMA descriptors
-	write_xdata_memory(reg_info_.dma0_cfgl, LOBYTE(reg_info_.dma0_cfg_offset));
-	write_xdata_memory(reg_info_.dma0_cfgh, HIBYTE(reg_info_.dma0_cfg_offset));
+//==============================================================================
+void CC_UnitDriver::write_flash_slow(const DataSectionStore &section_store)
+{
+	const size_t WRITE_BLOCK_SIZE = reg_info_.write_block_size;
 
-	size_t faddr = (size_t)-1;
+	if (!write_prepared(section_store))
+		CC_UnitDriver::flash_write_prepare(section_store);
 
-	ByteVector data;
-	section_store.create_image(FLASH_EMPTY_BYTE, data);
-	data.resize(align_up(section_store.upper_address(), WRITE_BLOCK_SIZE),
-			FLASH_EMPTY_BYTE);
+	DataBlockView &view = take_write_view();
+
+	// target may have been reset since prepare, don't rely on its RAM
+	load_write_descriptors();
+
+	// Set the pointer to the DMA descriptors
+	write_xdata_register(reg_info_.dma0_cfgl, LOBYTE(reg_info_.dma0_cfg_offset));
+	write_xdata_register(reg_info_.dma0_cfgh, HIBYTE(reg_info_.dma0_cfg_offset));
+
+	uint64_t write_start_time = 0;
+	bool write_pending = false;
 
-	pw_.write_start(data.size());
+	pw_.write_start(view.block_count() * WRITE_BLOCK_SIZE);
 
-	for (size_t i = 0; i < (data.size() / WRITE_BLOCK_SIZE); i++)
+	for (size_t i = 0; i < view.block_count(); i++)
 	{
 		pw_.write_progress(WRITE_BLOCK_SIZE);
 
 		size_t offset = WRITE_BLOCK_SIZE * i;
-		if (empty_block(&data[offset], WRITE_BLOCK_SIZE))
+		if (!view.block_used(i))
 			continue;
 
-		size_t next_faddr = offset / reg_info_.flash_word_size;
-		if (next_faddr != faddr)
-		{
-			write_xdata_memory(reg_info_.faddrl, LOBYTE(next_faddr));
-			write_xdata_memory(reg_info_.faddrh, HIBYTE(next_faddr));
-			faddr = next_faddr + WRITE_BLOCK_SIZE / reg_info_.flash_word_size;
-		}
+		TraceScope trace("flash_write_block", "driver", "offset", offset);
 
-		write_xdata_memory(reg_info_.dma_data_offset, &data[offset], WRITE_BLOCK_SIZE);
+		// the only buffer and flash address are reused, previous write must be over
+		if (write_pending)
+			wait_flash_ready(write_start_time, flash_write_time(WRITE_BLOCK_SIZE));
+
+		size_t faddr = offset / reg_info_.flash_word_size;
+		write_xdata_register(reg_info_.faddrl, LOBYTE(faddr));
+		write_xdata_register(reg_info_.faddrh, HIBYTE(faddr));
+
+		write_xdata_memory(reg_info_.dma_data_offset, view.block(i), WRITE_BLOCK_SIZE);
 
 		write_xdata_memory(reg_info_.dma_arm, 0x01);
 		write_xdata_memory(reg_info_.fctl, reg_info_.fctl_write);
-		while ((read_xdata_memory(reg_info_.fctl) & FCTL_BUSY));
+
+		// FADDR points right after the block once it's written
+		faddr += WRITE_BLOCK_SIZE / reg_info_.flash_word_size;
+		shadow_.set_register(reg_info_.faddrl, LOBYTE(faddr));
+		shadow_.set_register(reg_info_.faddrh, HIBYTE(faddr));
+		write_start_time = usb_device_.transport_time();
+		write_pending = true;
 	}
+	if (write_pending)
+		wait_flash_ready(write_start_time, flash_write_time(WRITE_BLOCK_SIZE));
+
 	pw_.write_finish();
 }
@@ -11,16 +11,22 @@
 #ifndef _CC_UNIT_DRIVER_H_
 #define _CC_UNIT_DRIVER_H_
 
+#include <map>
 #include "data/data_section_store.h"
+#include "data/data_block_view.h"
+#include "data/flash_plan.h"
 #include "data/progress_watcher.h"
 #include "usb/usb_device.h"
 #include "cc_unit_info.h"
+#include "cc_debug_instr.h"
 
 const size_t FLASH_EMPTY_BYTE 	   		= 0xFF;
-const size_t XDATA_READ_CHUNK_SIZE 		= 128;
-const size_t FLASH_READ_CHUNK_SIZE 		= 128;
+const size_t XDATA_READ_CHUNK_SIZE 		= 128; // default, may be tuned
+const size_t FLASH_READ_CHUNK_SIZE 		= 128; // default, may be tuned
+const size_t MAX_READ_CHUNK_SIZE 		= 1024;
 const size_t FLASH_BANK_SIZE 			= 1024 * 32;
 const size_t FLASH_MAPPED_BANK_OFFSET 	= 1024 * 32;
+const size_t XDATA_WRITE_CHUNK_SIZE 	= 1024; // per debug command
 
 const uint8_t FCTL_BUSY					= 0x80;
 const uint8_t FCTL_ABORT				= 0x20;
@@ -28,6 +34,67 @@ const uint8_t FCTL_ERASE				= 0x01;
 
 struct USB_DeviceID;
 
+/// Large enough for xdata write of XDATA_WRITE_CHUNK_SIZE bytes
+typedef CC_CommandBuffer<64 + XDATA_WRITE_CHUNK_SIZE *
+		(CC_MovA_Imm::SIZE + CC_MovxDptr_A::SIZE + CC_IncDptr::SIZE)> CC_Command;
+
+/// Busy-wait loops on target status (flash controller, DMA, chip erase)
+struct CC_PollStats
+{
+	uint_t polls;		// number of status reads
+	uint64_t wait_time;	// us
+
+	CC_PollStats();
+};
+
+/// State of the running target caught by a single halt
+struct CC_PcSample
+{
+	uint16_t pc;
+	uint8_t bank;		// FMAP, flash bank mapped at 0x8000, 0 if not banked
+	uint8_t sp;
+	ByteVector stack;	// internal RAM from 0x08 up to SP, if requested
+
+	CC_PcSample();
+};
+
+/// Target state written by the driver since the last reset or erase:
+/// debug config, single xdata registers and xdata blocks (DMA descriptors).
+/// Lets the driver skip accesses whose effect is already known.
+class CC_TargetShadow
+{
+public:
+	/// @return true if config is known
+	bool debug_config(uint8_t &config) const;
+	void set_debug_config(uint8_t config);
+
+	/// @return true if register is known to hold value
+	bool register_holds(uint16_t address, uint8_t value) const;
+	void set_register(uint16_t address, uint8_t value);
+	void forget_register(uint16_t address);
+
+	/// @return true if xdata at address is known to hold data
+	bool block_holds(uint16_t address, const uint8_t data[], size_t size) const;
+	void set_block(uint16_t address, const uint8_t data[], size_t size);
+
+	/// Forget registers and blocks overlapped by xdata range
+	void forget_range(uint16_t address, size_t size);
+
+	/// Forget everything
+	void clear();
+
+	CC_TargetShadow();
+
+private:
+	typedef std::map<uint16_t, uint8_t> RegisterMap;
+	typedef std::map<uint16_t, ByteVector> BlockMap;
+
+	uint8_t debug_config_;
+	bool debug_config_known_;
+	RegisterMap registers_;
+	BlockMap blocks_;
+};
+
 class CC_UnitDriver : boost::noncopyable
 {
 public:
@@ -64,6 +131,20 @@ public:
 	virtual void erase();
 	virtual bool erase_check_comleted() = 0;
 
+	/// Typical time of complete flash erase, ms
+	uint_t chip_erase_time() const;
+
+	/// Max size of a block verified by CRC, flash banks are multiple of it
+	size_t verify_block_size() const;
+
+	/// Switch system clock of the halted target to the high speed crystal
+	/// oscillator, so on-target DMA and CRC run at full speed. The clock is
+	/// back to default after reset.
+	/// @return false if not supported or oscillator isn't stable in time
+	virtual bool clock_boost();
+	/// Restore clock setting saved by clock_boost
+	virtual void clock_restore();
+
 	/// Erase single page. Page size depends on target
 	/// @param page_offset must be aligned to a page boundary.
 	/// @return false if erase was aborted (e.g. 'cause page is locked)
@@ -73,10 +154,23 @@ public:
 	/// Modified parts of flash should be bllank.
 	virtual void flash_write(const DataSectionStore &sections) = 0;
 
+	/// Build flash image for the next flash_write of the same sections if
+	/// they aren't changed meanwhile. Done on the host only, so may be called
+	/// while chip erase is in progress.
+	virtual void flash_write_prepare(const DataSectionStore &sections);
+
 	/// Compare specified data to data from flash. Empty blocks are skipped.
 	/// @return false if verification failed
 	virtual bool flash_verify_by_crc(const DataSectionStore &sections);
 
+	/// Compare CRC of flash blocks to the expected ones (e.g. from FlashPlan)
+	/// @return false if verification failed
+	bool flash_verify_by_crc(const FlashBlockCrcList &blocks);
+
+	/// Compute CRC of flash blocks on target, a block larger than
+	/// verify_block_size is processed by several DMA transfers
+	void flash_read_crc(FlashBlockCrcList &blocks);
+
 	/// Compare specified data to data from flash. Empty blocks are skipped.
 	/// @return false if verification failed
 	virtual bool flash_verify_by_read(const DataSectionStore &sections);
@@ -103,19 +197,66 @@ public:
 	void write_xdata_memory(uint16_t address, uint8_t data);
 
 	void read_xdata_memory(uint16_t address, size_t count, ByteVector &out);
+	void read_xdata_memory(uint16_t address, size_t count, uint8_t out[]);
 	uint8_t read_xdata_memory(uint16_t address);
 
 	/// @param debug_mode if true after reset target will be halted
 	void reset(bool debug_mode);
 
+	/// Let the halted target run from its current PC
+	void resume();
+
+	/// Halt the running target, read its PC and stack pointer and let it
+	/// run again. Target is halted for one USB round trip, for two if
+	/// the stack is read as well.
+	void sample_pc(CC_PcSample &sample, bool read_stack);
+
+	/// Set or clear hardware breakpoint, number is below CC_BREAKPOINT_COUNT
+	/// @param address flash offset, banked code included
+	void set_hw_breakpoint(size_t number, uint_t address, bool enable);
+
+	/// Poll debug status until the running target halts (e.g. at a breakpoint)
+	/// @param timeout us
+	/// @return false on timeout
+	bool wait_halted(uint64_t timeout);
+
+	/// Read PC and Timer 1 counter of the target halted at a breakpoint,
+	/// step over the breakpoint and resume, all by a single command
+	void breakpoint_continue(uint16_t &pc, uint16_t &timer);
+
+	/// Start Timer 1 in free-running mode
+	/// @param divider 1, 8, 32 or 128
+	void start_timer(uint_t divider);
+
+	/// System clock cycles per timer tick at the current clock setting
+	uint_t cycles_per_timer_tick();
+
 	uint_t lock_data_size() const;
 
 	bool set_flash_size(uint_t flash_size);
 	void set_programmer_ID(const USB_DeviceID& programmer_ID);
 
-	CC_UnitDriver(USB_Device &programmer, ProgressWatcher &pw);
+	const CC_PollStats &poll_stats() const;
+	void reset_poll_stats();
+
+	/// Account status polling done outside of the driver (e.g. erase wait)
+	void add_poll_stats(uint_t polls, uint64_t wait_time);
+
+	/// Bytes read per debug command from flash and from xdata (info page),
+	/// up to MAX_READ_CHUNK_SIZE
+	void set_read_chunk_sizes(size_t flash_chunk_size, size_t xdata_chunk_size);
 
 protected:
+	/// Drivers are created for a family only, see CC_FamilyDriver
+	CC_UnitDriver(USB_Device &programmer, ProgressWatcher &pw,
+			const UnitCoreInfo &reg_info);
+
+	/// Switch register map and geometry to a variant of the family
+	void select_core_info(const UnitCoreInfo &reg_info);
+
+	/// Where internal RAM is seen in xdata, for parts that differ in SRAM size
+	void set_iram_offset(uint16_t iram_offset);
+
 	void select_info_page_flash(bool select_info_page);
 
 	/// Read data from the 16-bit address space. Bank number is not changed.
@@ -125,11 +266,42 @@ protected:
 	/// Read any block size
 	void flash_read(size_t offset, size_t size, ByteVector &data);//todo: rename!!!
 
-	void set_reg_info(const UnitCoreInfo &);
-	UnitCoreInfo get_reg_info();
+	/// Write xdata register unless it's known to hold the value already.
+	/// Only for registers that target doesn't change on its own
+	void write_xdata_register(uint16_t address, uint8_t value);
+
+	/// Write xdata block (e.g. DMA descriptors) unless it's known to be loaded
+	void load_xdata_block(uint16_t address, const uint8_t data[], size_t size);
+
+	/// Read xdata register until (value & mask) == expected
+	/// @return last read value
+	uint8_t poll_xdata_memory(uint16_t address, uint8_t mask, uint8_t expected);
+
+	/// Modeled time to program size bytes of flash, us
+	uint64_t flash_write_time(size_t size) const;
+
+	/// Wait for flash controller operation started at start_time (transport
+	/// time) that takes expected_time us. Sleep on the host until the operation should be
+	/// over, then confirm with a status read instead of polling over USB.
+	/// @return FCTL value
+	uint8_t wait_flash_ready(uint64_t start_time, uint64_t expected_time);
 
 	void write_flash_slow(const DataSectionStore &sections);
 
+	/// Split sections into write blocks of block_size and find blank ones,
+	/// the view is kept until flash_write
+	void prepare_write_view(const DataSectionStore &sections, size_t block_size);
+
+	/// @return true if flash_write_prepare was done for the sections as
+	/// they are now
+	bool write_prepared(const DataSectionStore &sections) const;
+
+	/// Load DMA descriptors of write_flash_slow
+	void load_write_descriptors();
+
+	/// Return prepared write blocks, prepared state is reset
+	DataBlockView &take_write_view();
+
 	//void write_flash_word(const DataSectionStore &sections);
 	void write_lock_to_info_page(uint8_t lock_byte);
 	//void
@@ -150,10 +322,27 @@ protected:
 	uint8_t endpoint_in_;
 	uint8_t endpoint_out_;
 
+	/// Reused by all debug commands
+	CC_Command command_;
+
+	size_t flash_read_chunk_size_;
+	size_t xdata_read_chunk_size_;
+
 private:
-	uint16_t calc_block_crc();
+	/// Point DMA channel 0 to the descriptor used for CRC calculation
+	void crc_dma_init();
+	/// CRC of flash block, flash_bank tracks bank selected on target
+	/// @param seed false to continue CRC of the previous block
+	uint16_t flash_block_crc(uint_t address, size_t size, bool seed,
+			size_t &flash_bank);
+	uint16_t calc_block_crc(bool seed);
 
 	UnitCoreInfo reg_info_;
+	CC_PollStats poll_stats_;
+
+	DataBlockView write_view_;
+	uint_t write_stamp_; // DataSectionStore::stamp of the view, 0 if none
+	CC_TargetShadow shadow_;
 };
 
 typedef boost::shared_ptr<CC_UnitDriver> CC_UnitDriverPtr;
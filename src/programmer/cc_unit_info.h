@@ -60,6 +60,7 @@ struct UnitCoreInfo
 	uint16_t xbank_offset;
 	uint16_t dma0_cfg_offset;
 	uint16_t dma_data_offset;
+	uint16_t iram_offset;	// internal RAM as seen in xdata
 
 	// Xdata register addresses;
 	uint16_t memctr;
@@ -75,10 +76,15 @@ struct UnitCoreInfo
 	uint16_t dma_arm;
 	uint16_t dma_req;
 	uint16_t dma_irq;
+	uint16_t clock_status;	// TICKSPD and CLKSPD in use
 
 	uint8_t fctl_write;
 	uint8_t fctl_erase;
 
+	uint_t flash_word_time;	// us, typical flash word write time
+	uint_t page_erase_time;	// ms, typical page erase time
+	uint_t chip_erase_time;	// ms, typical mass erase time
+
 	UnitCoreInfo();
 };
 
@@ -10,6 +10,7 @@
 
 #include "usb_device.h"
 #include "log.h"
+#include "trace.h"
 
 static void on_error(const String &context, int error = LIBUSB_ERROR_OTHER);
 
@@ -87,6 +88,29 @@ static void on_error(const String &context, int error)
 			libusb_error_string((libusb_error)error));
 }
 
+//==============================================================================
+String usb_error_name(int error)
+{
+	switch (error)
+	{
+	case LIBUSB_SUCCESS:				return "LIBUSB_SUCCESS";
+	case LIBUSB_ERROR_IO:				return "LIBUSB_ERROR_IO";
+	case LIBUSB_ERROR_INVALID_PARAM:	return "LIBUSB_ERROR_INVALID_PARAM";
+	case LIBUSB_ERROR_ACCESS:			return "LIBUSB_ERROR_ACCESS";
+	case LIBUSB_ERROR_NO_DEVICE:		return "LIBUSB_ERROR_NO_DEVICE";
+	case LIBUSB_ERROR_NOT_FOUND:		return "LIBUSB_ERROR_NOT_FOUND";
+	case LIBUSB_ERROR_BUSY:				return "LIBUSB_ERROR_BUSY";
+	case LIBUSB_ERROR_TIMEOUT:			return "LIBUSB_ERROR_TIMEOUT";
+	case LIBUSB_ERROR_OVERFLOW:			return "LIBUSB_ERROR_OVERFLOW";
+	case LIBUSB_ERROR_PIPE:				return "LIBUSB_ERROR_PIPE";
+	case LIBUSB_ERROR_INTERRUPTED:		return "LIBUSB_ERROR_INTERRUPTED";
+	case LIBUSB_ERROR_NO_MEM:			return "LIBUSB_ERROR_NO_MEM";
+	case LIBUSB_ERROR_NOT_SUPPORTED:	return "LIBUSB_ERROR_NOT_SUPPORTED";
+	case LIBUSB_ERROR_OTHER:			return "LIBUSB_ERROR_OTHER";
+	default:							return "LIBUSB_ERROR_" + number_to_string(-error);
+	}
+}
+
 //==============================================================================
 static void on_timeout_error(const String &context, ssize_t total,
 		ssize_t transfered)
@@ -294,47 +318,86 @@ void USB_Device::set_configuration(uint_t configuration)
 		on_error("set_configuration", result);
 }
 
+//==============================================================================
+int USB_Device::bulk_transfer(uint8_t endpoint, uint8_t data[], size_t count,
+		int &transfered)
+{
+	return libusb_bulk_transfer(handle_, endpoint, data, count, &transfered,
+			timeout_);
+}
+
+//==============================================================================
+int USB_Device::control_transfer(uint8_t bmRequestType, uint8_t bRequest,
+		uint16_t wValue, uint16_t wIndex, uint8_t data[], size_t count)
+{
+	return libusb_control_transfer(handle_, bmRequestType, bRequest, wValue,
+			wIndex, data, count, timeout_);
+}
+
 //==============================================================================
 void USB_Device::bulk_read(uint8_t endpoint, size_t count, uint8_t data[])
 {
+	TraceScope trace("bulk_read", "usb", "bytes", count);
+
 	int transfered = 0;
 	endpoint |= LIBUSB_ENDPOINT_IN;
 
-	ssize_t result = libusb_bulk_transfer(handle_, endpoint, data, count,
-			&transfered, timeout_);
+	ssize_t result = bulk_transfer(endpoint, data, count, transfered);
 
 	log_info("usb, bulk read, count %u: data: %s",
 			count, binary_to_hex(data, transfered, " ").c_str());
 
 	if (result < 0)
+	{
+		count_error(result);
 		on_error("libusb_bulk_transfer (in)", result);
+	}
 
 	if ((int)count != transfered)
+	{
+		count_error(LIBUSB_ERROR_TIMEOUT);
 		on_timeout_error("libusb_bulk_transfer (in)", count, transfered);
+	}
+
+	stats_.bulk_reads++;
+	stats_.bytes_in += count;
 }
 
 //==============================================================================
 void USB_Device::bulk_write(uint8_t endpoint, size_t count, const uint8_t data[])
 {
+	TraceScope trace("bulk_write", "usb", "bytes", count);
+
 	log_info("usb, bulk write, count: %u, data: %s", count,
 			binary_to_hex(data, count, " ").c_str());
 
 	int transfered = 0;
 	endpoint |= LIBUSB_ENDPOINT_OUT;
 
-	ssize_t result = libusb_bulk_transfer(handle_, endpoint, const_cast<uint8_t*>(data), count,
-			&transfered, timeout_);
+	ssize_t result = bulk_transfer(endpoint, const_cast<uint8_t*>(data), count,
+			transfered);
 	if (result < 0)
+	{
+		count_error(result);
 		on_error("libusb_bulk_transfer (out)", result);
+	}
 
 	if ((int)count != transfered)
+	{
+		count_error(LIBUSB_ERROR_TIMEOUT);
 		on_timeout_error("libusb_bulk_transfer (out)", count, transfered);
+	}
+
+	stats_.bulk_writes++;
+	stats_.bytes_out += count;
 }
 
 //==============================================================================
 void USB_Device::control_write(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
 		uint16_t wIndex, const uint8_t data[], size_t count)
 {
+	TraceScope trace("control_write", "usb", "request", bRequest);
+
 	bmRequestType |= LIBUSB_ENDPOINT_OUT;
 
 	log_info("usb, control write, request_type: %02Xh, request: %02Xh, value: %04Xh, index: %04Xh, count: %u",
@@ -342,31 +405,81 @@ void USB_Device::control_write(uint8_t bmRequestType, uint8_t bRequest, uint16_t
 	if (count)
 		log_info("usb, control write, data: %s", binary_to_hex(data, count, " ").c_str());
 
-	ssize_t result = libusb_control_transfer(handle_, bmRequestType, bRequest,
-			wValue, wIndex, const_cast<uint8_t*>(data), count, timeout_);
+	ssize_t result = control_transfer(bmRequestType, bRequest, wValue, wIndex,
+			const_cast<uint8_t*>(data), count);
 	if (result < 0)
+	{
+		count_error(result);
 		on_error("libusb_control_transfer (out)", result);
+	}
 
 	if (count && (ssize_t)count != result)
+	{
+		count_error(LIBUSB_ERROR_TIMEOUT);
 		on_timeout_error("libusb_control_transfer (out)", count, result);
+	}
+
+	stats_.control_writes++;
+	stats_.bytes_out += count;
 }
 
 //==============================================================================
 void USB_Device::control_read(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
 		uint16_t wIndex, uint8_t data[], size_t count)
 {
+	TraceScope trace("control_read", "usb", "request", bRequest);
+
 	bmRequestType |= LIBUSB_ENDPOINT_IN;
 
 	log_info("usb, control read, request_type: %02Xh, request: %02Xh, value: %04Xh, index: %04Xh, count: %u",
 			bmRequestType, bRequest, wValue, wIndex, count);
 
-	ssize_t result = libusb_control_transfer(handle_, bmRequestType, bRequest,
-			wValue, wIndex, data, count, timeout_);
+	ssize_t result = control_transfer(bmRequestType, bRequest, wValue, wIndex,
+			data, count);
 	if (result < 0)
+	{
+		count_error(result);
 		on_error("libusb_control_transfer (in)", result);
+	}
 
 	if (count && (ssize_t)count != result)
+	{
+		count_error(LIBUSB_ERROR_TIMEOUT);
 		on_timeout_error("libusb_control_transfer (in)", count, result);
+	}
 
 	log_info("usb, control read, data: %s", binary_to_hex(data, count, " ").c_str());
+
+	stats_.control_reads++;
+	stats_.bytes_in += count;
 }
+
+//==============================================================================
+const USB_TransferStats &USB_Device::transfer_stats() const
+{	return stats_; }
+
+//==============================================================================
+uint64_t USB_Device::transport_time() const
+{	return get_monotonic_time(); }
+
+//==============================================================================
+void USB_Device::count_error(int error)
+{	stats_.errors[error]++; }
+
+//==============================================================================
+void USB_Device::reset_transfer_stats()
+{	stats_ = USB_TransferStats(); }
+
+//==============================================================================
+USB_TransferStats::USB_TransferStats() :
+	bulk_reads(0),
+	bulk_writes(0),
+	control_reads(0),
+	control_writes(0),
+	bytes_in(0),
+	bytes_out(0)
+{ }
+
+//==============================================================================
+uint_t USB_TransferStats::transactions() const
+{	return bulk_reads + bulk_writes + control_reads + control_writes; }
@@ -11,12 +11,36 @@
 #ifndef _USB_DEVICE_H_
 #define _USB_DEVICE_H_
 
+#include <map>
 #include <libusb-1.0/libusb.h>
 #include <boost/shared_ptr.hpp>
 #include "common.h"
 
 typedef boost::shared_ptr<libusb_context> USB_ContextPtr;
 
+/// Counters of completed transfers, payload bytes only
+struct USB_TransferStats
+{
+	uint_t bulk_reads;
+	uint_t bulk_writes;
+	uint_t control_reads;
+	uint_t control_writes;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+
+	/// Failed transfers: libusb error code -> count
+	std::map<int, uint_t> errors;
+
+	uint_t transactions() const;
+
+	USB_TransferStats();
+};
+
+/// @return libusb error code as string, e.g. LIBUSB_ERROR_TIMEOUT
+String usb_error_name(int error);
+
+/// Device is accessed through libusb. Descendants may override the virtual
+/// methods to provide an alternative transport (e.g. a simulated programmer)
 class USB_Device : boost::noncopyable
 {
 public:
@@ -25,15 +49,15 @@ public:
 
 	void set_transfer_timeout(uint_t timeout);
 
-	void reset_device();
+	virtual void reset_device();
 
-	void set_configuration(uint_t configuration); // throw
-	void claim_interface(uint_t interface_number); // throw
-	void release_interface(uint_t interface_number); // throw
+	virtual void set_configuration(uint_t configuration); // throw
+	virtual void claim_interface(uint_t interface_number); // throw
+	virtual void release_interface(uint_t interface_number); // throw
 
-	void device_decriptor(libusb_device_descriptor &descriptor); // throw
-	void string_descriptor_utf8(uint8_t index, uint16_t language, String &data); // throw
-	void string_descriptor_ascii(uint8_t index, String &data); // throw
+	virtual void device_decriptor(libusb_device_descriptor &descriptor); // throw
+	virtual void string_descriptor_utf8(uint8_t index, uint16_t language, String &data); // throw
+	virtual void string_descriptor_ascii(uint8_t index, String &data); // throw
 
 	void clear_halt(uint8_t endpoint);
 
@@ -46,22 +70,40 @@ public:
 	void control_read(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
 			uint16_t wIndex, uint8_t data[], size_t count); // throw
 
-	bool open_by_vid_pid(uint16_t vendor_id, uint16_t product_id); // throw
-	bool open_by_address(uint8_t bus_number, uint8_t device_address); // throw
-	bool opened() const;
-	void close();
+	virtual bool open_by_vid_pid(uint16_t vendor_id, uint16_t product_id); // throw
+	virtual bool open_by_address(uint8_t bus_number, uint8_t device_address); // throw
+	virtual bool opened() const;
+	virtual void close();
+
+	const USB_TransferStats &transfer_stats() const;
+	void reset_transfer_stats();
+
+	/// Time base of the device side, us. Host monotonic time for real devices,
+	/// used to schedule waits for operations of known duration
+	virtual uint64_t transport_time() const;
 
 	USB_Device();
-	~USB_Device();
+	virtual ~USB_Device();
+
+protected:
+	/// @return libusb error code, transfered is set to number of bytes moved
+	virtual int bulk_transfer(uint8_t endpoint, uint8_t data[], size_t count,
+			int &transfered);
+
+	/// @return number of bytes transfered or libusb error code
+	virtual int control_transfer(uint8_t bmRequestType, uint8_t bRequest,
+			uint16_t wValue, uint16_t wIndex, uint8_t data[], size_t count);
 
 private:
 	void init_context();
 	void check_open();
+	void count_error(int error);
 
 	USB_ContextPtr context_;
 	libusb_device_handle *handle_;
 	libusb_device *device_;
 	uint_t timeout_;
+	USB_TransferStats stats_;
 };
 
 #endif // !_USB_DEVICE_H_